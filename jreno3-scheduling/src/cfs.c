@@ -0,0 +1,293 @@
+/*
+ * cfs.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The completely fair scheduler policy (-c).
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfs.h"
+#include "policy.h"
+
+static const unsigned int nice_weight[40] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+};
+
+unsigned int weight_of(const pcb_t *pcb)
+{
+    return nice_weight[pcb->nice + 20];
+}
+
+/*
+ * group_load() adds (or with remove set, takes away) a process that became
+ * runnable (or stopped being runnable) to its group's CFS load, and its
+ * group's shares to the parent's when the group goes from idle to busy or
+ * back.
+ */
+static void group_load(const pcb_t *pcb, int remove)
+{
+    unsigned long w = weight_of(pcb);
+    int g = (int) group_of(pcb);
+
+    prof_mutex_lock(&sched->group_lock);
+    while (g >= 0) {
+        group_state_t *gs = &sched->group_state[g];
+        unsigned long was = gs->load;
+        gs->load = remove ? gs->load - w : gs->load + w;
+        if ((was == 0) == (gs->load == 0)) {
+            break;
+        }
+        w = sched->groups.groups[g].shares;
+        g = sched->groups.groups[g].parent;
+    }
+    prof_mutex_unlock(&sched->group_lock);
+}
+
+/*
+ * The weight CFS charges a process at: its share of its group's load, times
+ * the group's share of its parent's, and so on up, scaled back to the root's
+ * load.  With no groups this is just weight_of().
+ */
+static unsigned long cfs_weight(const pcb_t *pcb)
+{
+    double frac;
+    unsigned long w;
+    int g = (int) group_of(pcb);
+
+    if (sched->groups.count == 1) {
+        return weight_of(pcb);
+    }
+    prof_mutex_lock(&sched->group_lock);
+    frac = sched->group_state[g].load ?
+        (double) weight_of(pcb) / sched->group_state[g].load : 1.0;
+    for (; sched->groups.groups[g].parent >= 0;
+         g = sched->groups.groups[g].parent) {
+        unsigned long parent_load =
+            sched->group_state[sched->groups.groups[g].parent].load;
+        if (parent_load) {
+            frac *= (double) sched->groups.groups[g].shares / parent_load;
+        }
+    }
+    w = (unsigned long) (frac * sched->group_state[0].load);
+    prof_mutex_unlock(&sched->group_lock);
+    return w ? w : 1;
+}
+
+/* Moves rq's min_vruntime up to its leftmost process; rq->lock held */
+static void cfs_update_min(runqueue_t *rq)
+{
+    rb_node_t *first = rb_first(&rq->cfs.tree);
+    if (first) {
+        unsigned long long vr =
+            rb_entry(first, proc_info_t, cfs.node)->cfs.vruntime;
+        if (vr > rq->cfs.min_vruntime) {
+            rq->cfs.min_vruntime = vr;
+        }
+    }
+}
+
+/* Re-bases a vruntime from one run queue's min_vruntime onto another's */
+static unsigned long long cfs_rebase(unsigned long long vr,
+                                     const runqueue_t *from,
+                                     const runqueue_t *to)
+{
+    unsigned long long base = __atomic_load_n(&from->cfs.min_vruntime,
+        __ATOMIC_RELAXED);
+    return (vr > base ? vr - base : 0) +
+        __atomic_load_n(&to->cfs.min_vruntime, __ATOMIC_RELAXED);
+}
+
+/*
+ * cfs_account() charges a process that is leaving the CPU for the ticks it
+ * ran, scaled by its weight, and lets the CPU's min_vruntime catch up.
+ */
+static void cfs_account(unsigned int cpu_id, pcb_t *pcb)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    runqueue_t *rq = rq_of(cpu_id);
+    unsigned long long ran = get_simulator_time() - pi->dispatched;
+    pi->cfs.vruntime += ran * VRUNTIME_SCALE * NICE_0_WEIGHT / cfs_weight(pcb);
+
+    prof_mutex_lock(&rq->lock);
+    if (!rb_first(&rq->cfs.tree) && pi->cfs.vruntime > rq->cfs.min_vruntime) {
+        rq->cfs.min_vruntime = pi->cfs.vruntime;
+    }
+    cfs_update_min(rq);
+    prof_mutex_unlock(&rq->lock);
+}
+
+/* CFS order: smallest vruntime first, ties to the lower PID */
+static int vruntime_less(const rb_node_t *a, const rb_node_t *b)
+{
+    const proc_info_t *x = rb_const_entry(a, proc_info_t, cfs.node);
+    const proc_info_t *y = rb_const_entry(b, proc_info_t, cfs.node);
+    if (x->cfs.vruntime != y->cfs.vruntime) {
+        return x->cfs.vruntime < y->cfs.vruntime;
+    }
+    return x < y;
+}
+
+/*
+ * New processes start at min_vruntime.  A process that moved from another
+ * CPU's queue keeps its lead or lag relative to that queue.  One waking from
+ * I/O is credited at most half a period of sleep, so it runs soon without
+ * starving everyone else.
+ */
+static void cfs_push(runqueue_t *rq, pcb_t *pcb)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    runqueue_t *from = pcb->last_cpu >= 0 ?
+        rq_of((unsigned int) pcb->last_cpu) : rq;
+    if (!pi->started) {
+        pi->cfs.vruntime = rq->cfs.min_vruntime;
+        pi->started = 1;
+    } else if (from != rq) {
+        pi->cfs.vruntime = cfs_rebase(pi->cfs.vruntime, from, rq);
+    }
+    if (pi->waking) {
+        unsigned long long credit = sched->cfs.latency * VRUNTIME_SCALE / 2;
+        unsigned long long floor = rq->cfs.min_vruntime > credit ?
+            rq->cfs.min_vruntime - credit : 0;
+        if (pi->cfs.vruntime < floor) {
+            pi->cfs.vruntime = floor;
+        }
+        pi->waking = 0;
+    }
+    rb_insert(&rq->cfs.tree, &pi->cfs.node);
+    __atomic_store_n(&rq->cfs.load, rq->cfs.load + weight_of(pcb),
+        __ATOMIC_RELAXED);
+}
+
+static pcb_t *cfs_pop(runqueue_t *rq)
+{
+    rb_node_t *first = rb_first(&rq->cfs.tree);
+    proc_info_t *pi;
+    pcb_t *pcb;
+    if (!first) {
+        return NULL;
+    }
+    pi = rb_entry(first, proc_info_t, cfs.node);
+    rb_erase(&rq->cfs.tree, first);
+    pcb = &sched->processes[pi - sched->info];
+    __atomic_store_n(&rq->cfs.load, rq->cfs.load - weight_of(pcb),
+        __ATOMIC_RELAXED);
+    cfs_update_min(rq);
+    return pcb;
+}
+
+/*
+ * The CFS slice: the process's share of the scheduling period by weight.  The
+ * period is latency, stretched so that nobody gets less than granularity
+ * when many processes are runnable.
+ */
+static int cfs_slice(unsigned int cpu_id, const pcb_t *pcb)
+{
+    runqueue_t *rq = rq_of(cpu_id);
+    unsigned long w = weight_of(pcb);
+    unsigned long load = __atomic_load_n(&rq->cfs.load, __ATOMIC_RELAXED) + w;
+    unsigned long long nr = __atomic_load_n(&rq->size, __ATOMIC_RELAXED) + 1;
+    unsigned long long period =
+        nr * sched->cfs.granularity > sched->cfs.latency ?
+        nr * sched->cfs.granularity : sched->cfs.latency;
+    unsigned long long slice = period * w / load;
+    return (int) (slice > sched->cfs.granularity ?
+        slice : sched->cfs.granularity);
+}
+
+/*
+ * A process coming off the CPU is charged for its run, and leaves its group's
+ * load if it is no longer runnable.
+ */
+static void cfs_leave(unsigned int cpu_id, pcb_t *pcb, process_state_t state)
+{
+    cfs_account(cpu_id, pcb);
+    if (state != PROCESS_READY && sched->groups.count > 1) {
+        group_load(pcb, 1);
+    }
+}
+
+static void cfs_wake(pcb_t *pcb)
+{
+    if (sched->groups.count > 1) {
+        group_load(pcb, 0);
+    }
+}
+
+static void cfs_migrate(pcb_t *pcb, const runqueue_t *from,
+                        const runqueue_t *to)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    pi->cfs.vruntime = cfs_rebase(pi->cfs.vruntime, from, to);
+}
+
+static void cfs_create(const scheduler_config_t *config)
+{
+    sched->cfs.latency = config->cfs_latency;
+    sched->cfs.granularity = config->cfs_granularity;
+}
+
+static void cfs_rq_init(runqueue_t *rq, unsigned int index)
+{
+    (void) index;
+    rb_init(&rq->cfs.tree, vruntime_less);
+    rq->cfs.min_vruntime = 0;
+    rq->cfs.load = 0;
+}
+
+const sched_policy_t cfs_policy = {
+    .create = cfs_create,
+    .rq_init = cfs_rq_init,
+    .push = cfs_push,
+    .pop = cfs_pop,
+    .quantum = cfs_slice,
+    .leave = cfs_leave,
+    .wake = cfs_wake,
+    .migrate = cfs_migrate,
+};
+
+/* scheduler_parse_cfs() reads -c's "latency=L,granularity=G" */
+extern int scheduler_parse_cfs(scheduler_config_t *config, const char *spec) {
+    char *copy = strdup(spec), *save, *tok;
+    int ret = 0;
+    assert(copy != NULL);
+    config->algorithm = CFS;
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(tok, '=');
+        long n;
+        if (strcmp(tok, "default") == 0) {
+            continue;
+        }
+        if (value == NULL) {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        n = strtol(value, NULL, 10);
+        if (n < 1) {
+            ret = -1;
+        } else if (strcmp(tok, "latency") == 0) {
+            config->cfs_latency = (unsigned int) n;
+        } else if (strcmp(tok, "granularity") == 0) {
+            config->cfs_granularity = (unsigned int) n;
+        } else {
+            ret = -1;
+        }
+    }
+    free(copy);
+    if (ret != 0) {
+        fprintf(stderr, "Bad CFS spec '%s'\n", spec);
+    }
+    return ret;
+}
@@ -0,0 +1,56 @@
+/*
+ * cfs.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The completely fair scheduler policy (-c).
+ *
+ * Every runnable process should get a turn within latency ticks, but no slice
+ * is shorter than granularity.  Processes run in order of virtual runtime,
+ * which advances more slowly the more weight a process has.  With control
+ * groups, sibling groups divide the CPU by their shares.
+ */
+
+#ifndef __CFS_H__
+#define __CFS_H__
+
+#include "os-sim.h"
+#include "rbtree.h"
+
+/*
+ * CFS weights follow Linux's table, where each nice level is worth about 10%
+ * of CPU.
+ */
+#define VRUNTIME_SCALE 1024ull
+#define NICE_0_WEIGHT 1024
+
+/* The weight of pcb's nice level, which lottery and stride use as tickets */
+extern unsigned int weight_of(const pcb_t *pcb);
+
+/*
+ * Per-process: node in the run queue's tree, and vruntime, in VRUNTIME_SCALE
+ * units per tick at nice 0.
+ */
+typedef struct {
+    rb_node_t node;
+    unsigned long long vruntime;
+} cfs_proc_t;
+
+/*
+ * Per run queue: tree, ordered by vruntime, with load the total weight
+ * queued in it and min_vruntime a floor that only moves forward.
+ */
+typedef struct {
+    rbtree_t tree;
+    unsigned long long min_vruntime;
+    unsigned long load;
+} cfs_rq_t;
+
+/* The settings from scheduler_config_t */
+typedef struct {
+    unsigned int latency;
+    unsigned int granularity;
+} cfs_sched_t;
+
+extern const struct sched_policy cfs_policy;
+
+#endif /* __CFS_H__ */
@@ -0,0 +1,113 @@
+/*
+ * cgroup.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Parsing control group specs.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cgroup.h"
+
+void cgroup_default(cgroup_tree_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    strcpy(t->groups[0].name, "root");
+    t->groups[0].parent = -1;
+    t->groups[0].shares = CGROUP_DEFAULT_SHARES;
+    t->groups[0].period = CGROUP_DEFAULT_PERIOD;
+    t->count = 1;
+}
+
+/* The group whose path is name's up to its last '/', or the root */
+static int find_parent(const cgroup_tree_t *t, const char *name)
+{
+    const char *slash = strrchr(name, '/');
+    unsigned int n;
+
+    if (slash == NULL)
+        return 0;
+    for (n = 1; n < t->count; n++)
+        if (strlen(t->groups[n].name) == (size_t)(slash - name) &&
+            strncmp(t->groups[n].name, name, (size_t)(slash - name)) == 0)
+            return (int) n;
+    return -1;
+}
+
+/* Parses one "name[:key=value,...]" */
+static int parse_group(cgroup_tree_t *t, char *def)
+{
+    char *params = strchr(def, ':'), *save, *tok, *end;
+    cgroup_t *g;
+    unsigned int n;
+
+    if (params != NULL)
+        *params++ = '\0';
+    if (t->count == CGROUP_MAX || def[0] == '\0' || def[0] == '/' ||
+        strlen(def) >= CGROUP_NAME_MAX)
+        return -1;
+    for (n = 1; n < t->count; n++)
+        if (strcmp(t->groups[n].name, def) == 0)
+            return -1;
+
+    g = &t->groups[t->count];
+    strcpy(g->name, def);
+    if ((g->parent = find_parent(t, def)) < 0)
+        return -1;
+    g->shares = CGROUP_DEFAULT_SHARES;
+    g->quota = 0;
+    g->period = CGROUP_DEFAULT_PERIOD;
+
+    for (tok = params ? strtok_r(params, ",", &save) : NULL; tok != NULL;
+         tok = strtok_r(NULL, ",", &save))
+    {
+        char *value = strchr(tok, '=');
+        unsigned long v;
+
+        if (value == NULL)
+            return -1;
+        *value++ = '\0';
+        v = strtoul(value, &end, 10);
+        if (*end != '\0' || end == value || v > 1000000)
+            return -1;
+        if (strcmp(tok, "shares") == 0 && v >= 2)
+            g->shares = (unsigned int) v;
+        else if (strcmp(tok, "quota") == 0)
+            g->quota = (unsigned int) v;
+        else if (strcmp(tok, "period") == 0 && v >= 1)
+            g->period = (unsigned int) v;
+        else
+            return -1;
+    }
+    t->count++;
+    return 0;
+}
+
+int cgroup_parse(cgroup_tree_t *t, const char *spec)
+{
+    char *copy = strdup(spec), *save, *tok;
+    int ret = 0;
+
+    assert(copy != NULL);
+    for (tok = strtok_r(copy, ";", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ";", &save))
+        ret = parse_group(t, tok);
+
+    if (ret != 0)
+        fprintf(stderr, "Bad control group spec '%s'\n", spec);
+    free(copy);
+    return ret;
+}
+
+int cgroup_has_quota(const cgroup_tree_t *t)
+{
+    unsigned int n;
+
+    for (n = 0; n < t->count; n++)
+        if (t->groups[n].quota > 0)
+            return 1;
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * cgroup.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Control groups: a tree of process groups with CPU shares and quotas.
+ */
+
+#ifndef __CGROUP_H__
+#define __CGROUP_H__
+
+#define CGROUP_MAX 64
+#define CGROUP_NAME_MAX 32
+
+#define CGROUP_DEFAULT_SHARES 1024
+#define CGROUP_DEFAULT_PERIOD 100
+
+/*
+ * One group.  Group 0 is the root, which holds every process not placed in
+ * another group (see the group workload attribute) and has no limits.
+ *
+ *   name : the path from the root, such as "batch/etl"
+ *   parent : the parent group's index, or -1 for the root
+ *   shares : the group's weight against its siblings and the processes
+ *        directly in its parent, where a nice 0 process weighs 1024.  Only
+ *        the completely fair scheduler uses shares.
+ *   quota, period : the group and everything below it may run for at most
+ *        quota ticks, summed over CPUs, in every period ticks; 0 for no limit
+ */
+typedef struct {
+    char name[CGROUP_NAME_MAX];
+    int parent;
+    unsigned int shares;
+    unsigned int quota;
+    unsigned int period;
+} cgroup_t;
+
+typedef struct {
+    cgroup_t groups[CGROUP_MAX];
+    unsigned int count;
+} cgroup_tree_t;
+
+/* cgroup_default() makes a tree of just the root */
+extern void cgroup_default(cgroup_tree_t *t);
+
+/*
+ * cgroup_parse() adds groups to t from a spec such as
+ *
+ *     serving:shares=2048;batch:shares=512,quota=50,period=100;batch/etl
+ *
+ * Groups are numbered from 1 in the order given, and a group's parent must
+ * come before it.  Returns -1 on a bad spec.
+ */
+extern int cgroup_parse(cgroup_tree_t *t, const char *spec);
+
+/* Whether any group has a quota */
+extern int cgroup_has_quota(const cgroup_tree_t *t);
+
+#endif /* __CGROUP_H__ */
@@ -0,0 +1,192 @@
+/*
+ * eventlog.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * A buffered binary log of scheduling events.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eventlog.h"
+
+
+static const char *type_names[] = {
+    "create", "dispatch", "preempt", "io-start", "wakeup", "terminate",
+    "sleep", "release"
+};
+
+static int eventlog_flush(eventlog_t *log)
+{
+    if (log->count > 0 &&
+        fwrite(log->buffer, sizeof(event_record_t), log->count, log->file) !=
+        log->count)
+    {
+        log->count = 0;
+        return -1;
+    }
+    log->count = 0;
+    return 0;
+}
+
+static void make_record(event_record_t *r, unsigned int time,
+                        event_type_t type, unsigned int cpu, unsigned int pid,
+                        unsigned int arg)
+{
+    r->time = time;
+    r->pid = pid;
+    r->cpu = (uint16_t) cpu;
+    r->type = (uint8_t) type;
+    r->arg = (uint8_t) arg;
+}
+
+extern int eventlog_open(eventlog_t *log, const char *path,
+                         eventlog_header_t *header)
+{
+    if ((log->file = fopen(path, "wb")) == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    log->path = path;
+    log->buffer = malloc(sizeof(event_record_t) * EVENTLOG_BUFFER);
+    assert(log->buffer != NULL);
+    log->count = 0;
+    log->written = 0;
+    log->replaying = 0;
+
+    header->version = EVENTLOG_VERSION;
+    fwrite(EVENTLOG_MAGIC, 1, strlen(EVENTLOG_MAGIC), log->file);
+    fwrite(header, sizeof(*header), 1, log->file);
+    return 0;
+}
+
+extern int eventlog_open_replay(eventlog_t *log, const char *path,
+                                eventlog_header_t *header)
+{
+    char magic[sizeof(EVENTLOG_MAGIC) - 1];
+
+    if ((log->file = fopen(path, "rb")) == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    if (fread(magic, 1, sizeof(magic), log->file) != sizeof(magic) ||
+        memcmp(magic, EVENTLOG_MAGIC, sizeof(magic)) != 0 ||
+        fread(&header->version, sizeof(header->version), 1, log->file) != 1)
+    {
+        fprintf(stderr, "%s: not an event log\n", path);
+        fclose(log->file);
+        log->file = NULL;
+        return -1;
+    }
+    if (header->version != EVENTLOG_VERSION ||
+        fread(&header->deterministic, sizeof(*header) -
+            sizeof(header->version), 1, log->file) != 1)
+    {
+        fprintf(stderr, "%s: unsupported or truncated event log\n", path);
+        fclose(log->file);
+        log->file = NULL;
+        return -1;
+    }
+
+    log->path = path;
+    log->buffer = malloc(sizeof(event_record_t) * EVENTLOG_BUFFER);
+    assert(log->buffer != NULL);
+    log->count = 0;
+    log->written = 0;
+    log->replaying = 1;
+    log->next = 0;
+    log->diverged = 0;
+    return 0;
+}
+
+extern void eventlog_add(eventlog_t *log, unsigned int time, event_type_t type,
+                         unsigned int cpu, unsigned int pid, unsigned int arg)
+{
+    if (log->count == EVENTLOG_BUFFER && eventlog_flush(log) != 0)
+        fprintf(stderr, "%s: write failed\n", log->path);
+
+    make_record(&log->buffer[log->count++], time, type, cpu, pid, arg);
+    log->written++;
+}
+
+/* Reads ahead in a replayed log; returns NULL at its end */
+static const event_record_t *replay_next(eventlog_t *log)
+{
+    if (log->next == log->count)
+    {
+        log->count = (unsigned int) fread(log->buffer, sizeof(event_record_t),
+            EVENTLOG_BUFFER, log->file);
+        log->next = 0;
+        if (log->count == 0)
+            return NULL;
+    }
+    return &log->buffer[log->next];
+}
+
+extern void eventlog_check(eventlog_t *log, unsigned int time,
+                           event_type_t type, unsigned int cpu,
+                           unsigned int pid, unsigned int arg)
+{
+    const event_record_t *expected;
+
+    if (log->diverged)
+        return;
+    make_record(&log->actual, time, type, cpu, pid, arg);
+    expected = replay_next(log);
+    if (expected == NULL || expected->time != log->actual.time ||
+        expected->pid != log->actual.pid || expected->cpu != log->actual.cpu ||
+        expected->type != log->actual.type || expected->arg != log->actual.arg)
+    {
+        if (expected != NULL)
+            log->expected = *expected;
+        else
+            log->expected.type = UINT8_MAX;
+        log->diverged = 1;
+        return;
+    }
+    log->next++;
+    log->written++;
+}
+
+extern int eventlog_close(eventlog_t *log)
+{
+    int ret = 0;
+
+    if (log->replaying)
+    {
+        /* A run that ends before the log does has diverged too */
+        const event_record_t *expected = replay_next(log);
+
+        if (!log->diverged && expected != NULL)
+        {
+            log->expected = *expected;
+            log->actual.type = UINT8_MAX;
+            log->diverged = 1;
+        }
+        ret = log->diverged ? -1 : 0;
+        fclose(log->file);
+    }
+    else
+    {
+        ret = eventlog_flush(log);
+        if (ferror(log->file))
+            ret = -1;
+        if (fclose(log->file) != 0)
+            ret = -1;
+        if (ret != 0)
+            fprintf(stderr, "%s: write failed\n", log->path);
+    }
+    free(log->buffer);
+    log->file = NULL;
+    return ret;
+}
+
+extern const char *eventlog_type_name(unsigned int type)
+{
+    if (type >= sizeof(type_names) / sizeof(type_names[0]))
+        return "end";
+    return type_names[type];
+}
@@ -0,0 +1,116 @@
+/*
+ * eventlog.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * A buffered binary log of scheduling events.
+ *
+ * The file is EVENTLOG_MAGIC, an eventlog_header_t, then fixed-size
+ * event_record_t records, all in host byte order.
+ *
+ * A log recorded in deterministic mode can be replayed: the same run is
+ * repeated with the recorded seed, and each event is checked against the log
+ * as it happens, so a change in scheduling behaviour shows up as the first
+ * event that differs.
+ */
+
+#ifndef __EVENTLOG_H__
+#define __EVENTLOG_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define EVENTLOG_MAGIC "OSEV"
+#define EVENTLOG_VERSION 2
+
+/* Records buffered in memory between writes */
+#define EVENTLOG_BUFFER 4096
+
+typedef enum {
+    EVENT_CREATE = 0,   /* process arrived (cpu unused) */
+    EVENT_DISPATCH,     /* process put on cpu; pid is EVENT_NO_PID for idle */
+    EVENT_PREEMPT,      /* process's time slice ran out or it was preempted */
+    EVENT_IO_START,     /* process left cpu for I/O on device arg */
+    EVENT_WAKEUP,       /* process's I/O on device arg completed */
+    EVENT_TERMINATE,    /* process finished on cpu */
+    EVENT_SLEEP,        /* real-time task finished a job on cpu */
+    EVENT_RELEASE       /* real-time task's next job was released */
+} event_type_t;
+
+#define EVENT_NO_PID UINT32_MAX
+
+/*
+ * What a log was recorded from.  seed is only meaningful if deterministic is
+ * set.  Version 1 logs had only the version.
+ */
+typedef struct {
+    uint32_t version;
+    uint32_t deterministic;
+    uint64_t seed;
+    uint32_t cpu_count;
+    uint32_t process_count;
+} eventlog_header_t;
+
+typedef struct {
+    uint32_t time;
+    uint32_t pid;
+    uint16_t cpu;
+    uint8_t type;
+    uint8_t arg;
+} event_record_t;
+
+/*
+ * A log being written, or with replaying set, being read back.  When
+ * replaying, buffer holds count records read ahead from next, written counts
+ * the records matched so far, and diverged is set at the first mismatch,
+ * with expected and actual holding the two records.
+ */
+typedef struct {
+    FILE *file;
+    const char *path;
+    event_record_t *buffer;
+    unsigned int count;
+    unsigned long long written;
+    int replaying;
+    unsigned int next;
+    int diverged;
+    event_record_t expected, actual;
+} eventlog_t;
+
+/*
+ * eventlog_open() creates path and writes header, whose version it fills in.
+ * Returns 0 on success; on failure prints the reason and returns -1.
+ */
+extern int eventlog_open(eventlog_t *log, const char *path,
+                         eventlog_header_t *header);
+
+/*
+ * eventlog_open_replay() opens the log at path for eventlog_check() and reads
+ * its header.  Returns 0 on success; on failure prints the reason and returns
+ * -1.
+ */
+extern int eventlog_open_replay(eventlog_t *log, const char *path,
+                                eventlog_header_t *header);
+
+/* eventlog_add() appends a record, writing the buffer out when it fills */
+extern void eventlog_add(eventlog_t *log, unsigned int time, event_type_t type,
+                         unsigned int cpu, unsigned int pid, unsigned int arg);
+
+/*
+ * eventlog_check() compares an event against the next record of a replayed
+ * log.  Once the run has diverged it does nothing.
+ */
+extern void eventlog_check(eventlog_t *log, unsigned int time,
+                           event_type_t type, unsigned int cpu,
+                           unsigned int pid, unsigned int arg);
+
+/*
+ * eventlog_close() flushes and closes the log.  Returns -1 on a write error,
+ * or for a replayed log, if the run diverged from it or stopped short of its
+ * end.
+ */
+extern int eventlog_close(eventlog_t *log);
+
+/* eventlog_type_name() names an event type, for messages */
+extern const char *eventlog_type_name(unsigned int type);
+
+#endif /* __EVENTLOG_H__ */
@@ -0,0 +1,55 @@
+/*
+ * fenwick.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * A Fenwick (binary indexed) tree of weights over small integer ids.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "fenwick.h"
+
+void fenwick_init(fenwick_t *f, unsigned int size)
+{
+    f->tree = calloc(size + 1, sizeof(unsigned long long));
+    assert(f->tree != NULL);
+    f->size = size;
+    f->total = 0;
+}
+
+void fenwick_free(fenwick_t *f)
+{
+    free(f->tree);
+    f->tree = NULL;
+}
+
+void fenwick_add(fenwick_t *f, unsigned int id, long long delta)
+{
+    unsigned int i;
+
+    assert(id < f->size);
+    for (i = id + 1; i <= f->size; i += i & -i)
+        f->tree[i] += (unsigned long long) delta;
+    f->total += (unsigned long long) delta;
+}
+
+unsigned int fenwick_find(const fenwick_t *f, unsigned long long target)
+{
+    unsigned int pos = 0, step = 1;
+
+    assert(target < f->total);
+    while (step * 2 <= f->size)
+        step *= 2;
+
+    /* Descend from the largest power of two, skipping whole spans */
+    for (; step > 0; step /= 2)
+    {
+        if (pos + step <= f->size && f->tree[pos + step] <= target)
+        {
+            pos += step;
+            target -= f->tree[pos];
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,37 @@
+/*
+ * fenwick.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * A Fenwick (binary indexed) tree of weights over small integer ids, for
+ * drawing an id with probability proportional to its weight.
+ */
+
+#ifndef __FENWICK_H__
+#define __FENWICK_H__
+
+/*
+ * tree[] holds partial sums, one-based, so tree[i] covers the ids from
+ * i - (i & -i) to i - 1.  Every id starts at weight 0.  It does no locking
+ * of its own.
+ */
+typedef struct {
+    unsigned long long *tree;
+    unsigned int size;
+    unsigned long long total;
+} fenwick_t;
+
+extern void fenwick_init(fenwick_t *f, unsigned int size);
+extern void fenwick_free(fenwick_t *f);
+
+/* fenwick_add() changes id's weight by delta in O(log n) */
+extern void fenwick_add(fenwick_t *f, unsigned int id, long long delta);
+
+/*
+ * fenwick_find() returns the id whose weights span target, counting from
+ * id 0, in O(log n): the smallest id whose weight and those of all ids
+ * before it add up to more than target.  target must be below f->total, so
+ * a uniform target in [0, total) draws each id in proportion to its weight.
+ */
+extern unsigned int fenwick_find(const fenwick_t *f, unsigned long long target);
+
+#endif /* __FENWICK_H__ */
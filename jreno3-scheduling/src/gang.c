@@ -0,0 +1,417 @@
+/*
+ * gang.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The gang scheduling policy (-j).
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gang.h"
+#include "policy.h"
+#include "workload.h"
+
+/* CPUs a GANG job runs on at once: one per live thread, up to every CPU */
+static unsigned int gang_width(const gang_job_t *job)
+{
+    return job->alive < sched->cpu_count ? job->alive : sched->cpu_count;
+}
+
+/*
+ * gang_account() adds up the CPU time lost since the last event: CPUs held
+ * by a job for a thread that is not running, and free CPUs left idle while
+ * a job waits.  Nothing changes between events, so counting at each one is
+ * exact.  runqueues[0].lock held, as for every gang_ function.
+ */
+static void gang_account(void)
+{
+    unsigned int now = get_simulator_time(), held = 0, spare = 0;
+
+    if (now == sched->gang.accounted) {
+        return;
+    }
+    for (unsigned int c = 0; c < sched->cpu_count; c++) {
+        if (sched->cpus[c].slot < 0) {
+            spare++;
+        } else if (sched->cpus[c].current == NULL) {
+            held++;
+        }
+    }
+    sched->gang.aligned += (unsigned long long) held *
+        (now - sched->gang.accounted);
+    if (sched->gang.head >= 0) {
+        sched->gang.fragmented += (unsigned long long) spare *
+            (now - sched->gang.accounted);
+    }
+    sched->gang.accounted = now;
+}
+
+static void gang_queue(unsigned int j)
+{
+    gang_job_t *job = &sched->gang.jobs[j];
+
+    job->queued = 1;
+    job->queued_at = get_simulator_time();
+    job->next = -1;
+    if (sched->gang.tail >= 0) {
+        sched->gang.jobs[sched->gang.tail].next = (int) j;
+    } else {
+        sched->gang.head = (int) j;
+    }
+    sched->gang.tail = (int) j;
+}
+
+/* Takes job j, which follows prev (-1 for the head), off the queue */
+static void gang_unlink(unsigned int j, int prev)
+{
+    gang_job_t *job = &sched->gang.jobs[j];
+
+    if (prev >= 0) {
+        sched->gang.jobs[prev].next = job->next;
+    } else {
+        sched->gang.head = job->next;
+    }
+    if (sched->gang.tail == (int) j) {
+        sched->gang.tail = prev;
+    }
+    job->queued = 0;
+}
+
+/* Runs ready thread pcb of job on cpu_id, a CPU it holds, for the slice */
+static void gang_run(unsigned int cpu_id, pcb_t *pcb, gang_job_t *job)
+{
+    unsigned int now = get_simulator_time();
+
+    if (pcb->last_cpu >= 0 && (unsigned int) pcb->last_cpu != cpu_id) {
+        sched->cpus[cpu_id].migrations++;
+    }
+    pcb->last_cpu = (int) cpu_id;
+    pcb->state = PROCESS_RUNNING;
+    sched->info[pcb->pid].dispatched = now;
+    sched->cpus[cpu_id].current = pcb;
+    job->ready--;
+    job->running++;
+    context_switch(cpu_id, pcb, (int) (job->slice_end - now));
+    pthread_cond_broadcast(&sched->runqueues[0].wakeup);
+}
+
+/*
+ * The next ready thread of job, from its cursor on, preferring one that
+ * last ran on cpu_id; NULL if none is ready.
+ */
+static pcb_t *gang_next_ready(gang_job_t *job, unsigned int cpu_id)
+{
+    pcb_t *first = NULL;
+
+    for (unsigned int n = 0; n < job->size; n++) {
+        unsigned int i = (job->cursor + n) % job->size;
+        pcb_t *pcb = &sched->processes[sched->gang.members[job->first + i]];
+        if (pcb->state != PROCESS_READY) {
+            continue;
+        }
+        if (pcb->last_cpu == (int) cpu_id) {
+            return pcb;
+        }
+        if (first == NULL) {
+            first = pcb;
+            job->cursor = (i + 1) % job->size;
+        }
+    }
+    return first;
+}
+
+/* Runs ready threads of active job j on the CPUs it holds idle */
+static void gang_fill(unsigned int j)
+{
+    gang_job_t *job = &sched->gang.jobs[j];
+    pcb_t *pcb;
+
+    if (get_simulator_time() >= job->slice_end) {
+        return;
+    }
+    for (unsigned int c = 0; c < sched->cpu_count && job->ready > 0; c++) {
+        if (sched->cpus[c].slot == (int) j && sched->cpus[c].current == NULL &&
+            (pcb = gang_next_ready(job, c)) != NULL) {
+            gang_run(c, pcb, job);
+        }
+    }
+}
+
+/*
+ * gang_start() gives job j, just off the queue, the free CPUs it needs for
+ * a slice: first any its ready threads last ran on, then the lowest.  Its
+ * ready threads then all start in this tick.
+ */
+static void gang_start(unsigned int j)
+{
+    gang_job_t *job = &sched->gang.jobs[j];
+    unsigned int needed = gang_width(job);
+
+    job->active = 1;
+    job->slice_end = get_simulator_time() + sched->gang.quantum;
+    sched->gang.slices++;
+    for (unsigned int n = 0; n < job->size && needed > 0; n++) {
+        const pcb_t *pcb =
+            &sched->processes[sched->gang.members[job->first + n]];
+        if (pcb->state == PROCESS_READY && pcb->last_cpu >= 0 &&
+            sched->cpus[pcb->last_cpu].slot < 0) {
+            sched->cpus[pcb->last_cpu].slot = (int) j;
+            needed--;
+        }
+    }
+    for (unsigned int c = 0; c < sched->cpu_count && needed > 0; c++) {
+        if (sched->cpus[c].slot < 0) {
+            sched->cpus[c].slot = (int) j;
+            needed--;
+        }
+    }
+    gang_fill(j);
+}
+
+/*
+ * gang_dispatch() starts queued jobs while there are free CPUs.  The head
+ * goes first if it fits.  If not, FIFO leaves the CPUs idle for it, while
+ * packing backfills them with the widest queued job that fits, unless the
+ * head has waited longer than patience.
+ */
+static void gang_dispatch(void)
+{
+    unsigned int spare = 0, now = get_simulator_time();
+
+    for (unsigned int c = 0; c < sched->cpu_count; c++) {
+        if (sched->cpus[c].slot < 0) {
+            spare++;
+        }
+    }
+    while (sched->gang.head >= 0 && spare > 0) {
+        unsigned int head = (unsigned int) sched->gang.head;
+        int best = -1, best_prev = -1;
+        if (gang_width(&sched->gang.jobs[head]) <= spare) {
+            best = (int) head;
+        } else if (sched->gang.pack &&
+                   now - sched->gang.jobs[head].queued_at <=
+                   sched->gang.patience) {
+            for (int prev = (int) head, j = sched->gang.jobs[head].next;
+                 j >= 0; prev = j, j = sched->gang.jobs[j].next) {
+                unsigned int width = gang_width(&sched->gang.jobs[j]);
+                if (width <= spare && (best < 0 ||
+                    width > gang_width(&sched->gang.jobs[best]))) {
+                    best = j;
+                    best_prev = prev;
+                }
+            }
+            if (best >= 0) {
+                sched->gang.backfills++;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        gang_unlink((unsigned int) best, best_prev);
+        spare -= gang_width(&sched->gang.jobs[best]);
+        gang_start((unsigned int) best);
+    }
+}
+
+/*
+ * gang_leave() takes the thread on cpu_id off it, for preempt(), yield()
+ * and terminate().  The CPU stays with the job until the slice ends, which
+ * is once none of its threads is running; the job then queues again if any
+ * are ready.  Whatever the CPUs freed can run is dispatched, and cpu_id
+ * goes idle if nothing landed on it.
+ */
+static void gang_leave(unsigned int cpu_id, process_state_t state)
+{
+    runqueue_t *rq = &sched->runqueues[0];
+    pcb_t *pcb = sched->cpus[cpu_id].current;
+    unsigned int j = sched->info[pcb->pid].job;
+    gang_job_t *job = &sched->gang.jobs[j];
+
+    if (sched->groups.count > 1) {
+        group_charge(cpu_id, pcb);
+    }
+    prof_mutex_lock(&rq->lock);
+    gang_account();
+    pcb->state = state;
+    sched->cpus[cpu_id].current = NULL;
+    job->running--;
+    if (state == PROCESS_READY) {
+        job->ready++;
+    } else if (state == PROCESS_TERMINATED && --job->alive < sched->cpu_count) {
+        sched->cpus[cpu_id].slot = -1;
+    }
+    if (job->running == 0) {
+        job->active = 0;
+        for (unsigned int c = 0; c < sched->cpu_count; c++) {
+            if (sched->cpus[c].slot == (int) j) {
+                sched->cpus[c].slot = -1;
+            }
+        }
+        if (job->ready > 0) {
+            gang_queue(j);
+        }
+    } else {
+        gang_fill(j);
+    }
+    gang_dispatch();
+    if (sched->cpus[cpu_id].current == NULL) {
+        context_switch(cpu_id, NULL, sched->time_slice);
+    }
+    prof_mutex_unlock(&rq->lock);
+}
+
+/*
+ * gang_wake() makes a GANG thread ready.  If its job is mid-slice the
+ * thread runs at once on a CPU the job holds idle; otherwise the job queues
+ * if it is not already waiting.
+ */
+static void gang_wake(pcb_t *process)
+{
+    runqueue_t *rq = &sched->runqueues[0];
+    unsigned int j = sched->info[process->pid].job;
+    gang_job_t *job = &sched->gang.jobs[j];
+
+    prof_mutex_lock(&rq->lock);
+    gang_account();
+    process->state = PROCESS_READY;
+    job->ready++;
+    if (job->active) {
+        gang_fill(j);
+    } else if (!job->queued) {
+        gang_queue(j);
+    }
+    gang_dispatch();
+    prof_mutex_unlock(&rq->lock);
+}
+
+/*
+ * gang_build_jobs() makes a GANG job of each gang and of each process in
+ * none, numbered in order of their lowest PID.
+ */
+static void gang_build_jobs(void)
+{
+    unsigned int *job_of_gang = calloc(GANG_MAX + 1, sizeof(unsigned int));
+    unsigned int n, j;
+
+    sched->gang.jobs = calloc(sched->process_count, sizeof(gang_job_t));
+    sched->gang.members = malloc(sizeof(unsigned int) * sched->process_count);
+    assert(job_of_gang != NULL && sched->gang.jobs != NULL &&
+        sched->gang.members != NULL);
+
+    /* job_of_gang holds job numbers plus one, so 0 means none yet */
+    for (n = 0; n < sched->process_count; n++)
+    {
+        unsigned int gang = sched->processes[n].gang;
+
+        if (gang == 0 || job_of_gang[gang] == 0)
+        {
+            j = sched->gang.job_count++;
+            if (gang != 0)
+                job_of_gang[gang] = j + 1;
+        }
+        else
+            j = job_of_gang[gang] - 1;
+        sched->info[n].job = j;
+        sched->gang.jobs[j].size++;
+    }
+    for (j = 1; j < sched->gang.job_count; j++)
+        sched->gang.jobs[j].first = sched->gang.jobs[j - 1].first +
+            sched->gang.jobs[j - 1].size;
+    for (n = 0; n < sched->process_count; n++)
+    {
+        gang_job_t *job = &sched->gang.jobs[sched->info[n].job];
+        sched->gang.members[job->first + job->alive++] = n;
+    }
+    free(job_of_gang);
+}
+
+static void gang_create(const scheduler_config_t *config)
+{
+    sched->gang.quantum = config->gang_quantum;
+    sched->gang.pack = config->gang_pack;
+    sched->gang.patience = config->gang_patience;
+    sched->gang.head = -1;
+    sched->gang.tail = -1;
+    gang_build_jobs();
+}
+
+static void gang_destroy(scheduler_t *s)
+{
+    free(s->gang.jobs);
+    free(s->gang.members);
+}
+
+static void gang_print_stats(void)
+{
+    double capacity = (double) sched->cpu_count * get_simulator_time();
+    prof_mutex_lock(&sched->runqueues[0].lock);
+    gang_account();
+    prof_mutex_unlock(&sched->runqueues[0].lock);
+    printf("# of Gang Jobs: %u\n", sched->gang.job_count);
+    printf("# of Gang Slices: %lu (%lu backfilled)\n", sched->gang.slices,
+        sched->gang.backfills);
+    printf("CPU time lost to gang alignment: %.1f s (%.1f%%)\n",
+        sched->gang.aligned / 10.0,
+        capacity > 0 ? 100.0 * sched->gang.aligned / capacity : 0.0);
+    printf("CPU time lost to fragmentation: %.1f s (%.1f%%)\n",
+        sched->gang.fragmented / 10.0,
+        capacity > 0 ? 100.0 * sched->gang.fragmented / capacity : 0.0);
+}
+
+const sched_policy_t gang_policy = {
+    .create = gang_create,
+    .destroy = gang_destroy,
+    .print_stats = gang_print_stats,
+    .place_leave = gang_leave,
+    .place_wake = gang_wake,
+};
+
+extern int scheduler_parse_gang(scheduler_config_t *config, const char *spec) {
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+    assert(copy != NULL);
+    config->algorithm = GANG;
+    config->time_slice = -1;
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(tok, '=');
+        unsigned long n;
+        if (strcmp(tok, "default") == 0) {
+            continue;
+        }
+        if (value == NULL) {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        if (strcmp(tok, "policy") == 0) {
+            if (strcmp(value, "fifo") == 0) {
+                config->gang_pack = 0;
+            } else if (strcmp(value, "pack") == 0) {
+                config->gang_pack = 1;
+            } else {
+                ret = -1;
+            }
+            continue;
+        }
+        n = strtoul(value, &end, 0);
+        if (*end != '\0' || end == value || n > 1000000) {
+            ret = -1;
+        } else if (strcmp(tok, "quantum") == 0 && n >= 1) {
+            config->gang_quantum = (unsigned int) n;
+        } else if (strcmp(tok, "patience") == 0) {
+            config->gang_patience = (unsigned int) n;
+        } else {
+            ret = -1;
+        }
+    }
+    free(copy);
+    if (ret != 0) {
+        fprintf(stderr, "Bad gang scheduling spec '%s'\n", spec);
+    }
+    return ret;
+}
@@ -0,0 +1,66 @@
+/*
+ * gang.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The gang scheduling policy (-j).
+ *
+ * The threads of a gang run together, each on its own CPU, for a slice at a
+ * time, see scheduler_parse_gang().  GANG dispatches onto CPUs itself rather
+ * than through the run queues.
+ */
+
+#ifndef __GANG_H__
+#define __GANG_H__
+
+/*
+ * A GANG job: the threads of one gang, or a process on its own.  Its PIDs
+ * are members[first] to members[first + size - 1], and cursor is where the
+ * next slice starts looking for ready ones, so a job with more threads than
+ * CPUs runs them in turn.  alive, ready and running count the threads not
+ * yet terminated, waiting for a CPU and on one.
+ *
+ * While active, the job owns every CPU whose slot is its index until
+ * slice_end, running or not.  Otherwise, if it has ready threads, it is
+ * queued, linked through next, since queued_at.
+ */
+typedef struct {
+    unsigned int first;
+    unsigned int size;
+    unsigned int cursor;
+    unsigned int alive;
+    unsigned int ready;
+    unsigned int running;
+    int active;
+    unsigned int slice_end;
+    int queued;
+    unsigned int queued_at;
+    int next;
+} gang_job_t;
+
+/*
+ * The settings from scheduler_config_t, and the jobs, all protected by
+ * runqueues[0].lock, whose wakeup idle CPUs sleep on until a job is
+ * dispatched onto them.  Jobs waiting for CPUs are linked from head to tail.
+ * Up to accounted, aligned counts CPU ticks a running job held idle for a
+ * thread that was not ready, and fragmented free CPU ticks while a job
+ * waited because it did not fit.
+ */
+typedef struct {
+    unsigned int quantum;
+    int pack;
+    unsigned int patience;
+    gang_job_t *jobs;
+    unsigned int job_count;
+    unsigned int *members;
+    int head;
+    int tail;
+    unsigned int accounted;
+    unsigned long long aligned;
+    unsigned long long fragmented;
+    unsigned long slices;
+    unsigned long backfills;
+} gang_sched_t;
+
+extern const struct sched_policy gang_policy;
+
+#endif /* __GANG_H__ */
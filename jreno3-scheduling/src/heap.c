@@ -0,0 +1,155 @@
+/*
+ * heap.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * An indexed binary heap of small integer ids (PIDs or CPU ids).
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "heap.h"
+
+
+static void heap_place(heap_t *heap, unsigned int i, unsigned int id)
+{
+    heap->items[i] = id;
+    heap->pos[id] = i;
+}
+
+/* Moves the item at i up while it beats its parent; returns its final slot */
+static unsigned int sift_up(heap_t *heap, unsigned int i)
+{
+    unsigned int id = heap->items[i];
+
+    while (i > 0)
+    {
+        unsigned int parent = (i - 1) / 2;
+        if (!heap->less(id, heap->items[parent]))
+            break;
+        heap_place(heap, i, heap->items[parent]);
+        i = parent;
+    }
+    heap_place(heap, i, id);
+    return i;
+}
+
+static void sift_down(heap_t *heap, unsigned int i)
+{
+    unsigned int id = heap->items[i];
+
+    while (1)
+    {
+        unsigned int child = 2 * i + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size &&
+            heap->less(heap->items[child + 1], heap->items[child]))
+            child++;
+        if (!heap->less(heap->items[child], id))
+            break;
+        heap_place(heap, i, heap->items[child]);
+        i = child;
+    }
+    heap_place(heap, i, id);
+}
+
+unsigned int *heap_pos_alloc(unsigned int capacity)
+{
+    unsigned int *pos = malloc(sizeof(unsigned int) * (capacity ? capacity : 1));
+    unsigned int n;
+
+    assert(pos != NULL);
+    for (n = 0; n < capacity; n++)
+        pos[n] = HEAP_NONE;
+    return pos;
+}
+
+void heap_init_shared(heap_t *heap, unsigned int capacity, heap_less_t less,
+                      unsigned int *pos)
+{
+    heap->items = NULL;
+    heap->pos = pos;
+    heap->size = 0;
+    heap->allocated = 0;
+    heap->capacity = capacity;
+    heap->less = less;
+    heap->owns_pos = 0;
+}
+
+void heap_init(heap_t *heap, unsigned int capacity, heap_less_t less)
+{
+    heap_init_shared(heap, capacity, less, heap_pos_alloc(capacity));
+    heap->owns_pos = 1;
+}
+
+void heap_free(heap_t *heap)
+{
+    free(heap->items);
+    if (heap->owns_pos)
+        free(heap->pos);
+    heap->items = NULL;
+    heap->pos = NULL;
+    heap->size = heap->allocated = 0;
+}
+
+void heap_push(heap_t *heap, unsigned int id)
+{
+    assert(id < heap->capacity && heap->pos[id] == HEAP_NONE);
+    if (heap->size == heap->allocated)
+    {
+        heap->allocated = heap->allocated ? heap->allocated * 2 : 16;
+        heap->items = realloc(heap->items,
+            sizeof(unsigned int) * heap->allocated);
+        assert(heap->items != NULL);
+    }
+    heap_place(heap, heap->size, id);
+    heap->size++;
+    sift_up(heap, heap->size - 1);
+}
+
+unsigned int heap_top(const heap_t *heap)
+{
+    return heap->size ? heap->items[0] : HEAP_NONE;
+}
+
+unsigned int heap_pop(heap_t *heap)
+{
+    unsigned int id = heap_top(heap);
+
+    if (id != HEAP_NONE)
+        heap_remove(heap, id);
+    return id;
+}
+
+int heap_contains(const heap_t *heap, unsigned int id)
+{
+    return id < heap->capacity && heap->pos[id] != HEAP_NONE;
+}
+
+void heap_remove(heap_t *heap, unsigned int id)
+{
+    unsigned int i = heap->pos[id];
+    unsigned int last;
+
+    assert(i != HEAP_NONE);
+    heap->pos[id] = HEAP_NONE;
+    heap->size--;
+    if (i == heap->size)
+        return;
+
+    /* Fill the hole with the last item and let it find its level */
+    last = heap->items[heap->size];
+    heap_place(heap, i, last);
+    if (sift_up(heap, i) == i)
+        sift_down(heap, i);
+}
+
+void heap_update(heap_t *heap, unsigned int id)
+{
+    unsigned int i = heap->pos[id];
+
+    assert(i != HEAP_NONE);
+    if (sift_up(heap, i) == i)
+        sift_down(heap, heap->pos[id]);
+}
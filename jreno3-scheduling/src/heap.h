@@ -0,0 +1,64 @@
+/*
+ * heap.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * An indexed binary heap of small integer ids (PIDs or CPU ids).
+ */
+
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#define HEAP_NONE ((unsigned int) -1)
+
+/*
+ * less(a, b) returns nonzero if id a belongs closer to the top than id b.
+ * It usually compares a field of processes[a] or current[a], so a heap can be
+ * a min-heap or a max-heap over whatever key the scheduler needs.
+ */
+typedef int (*heap_less_t)(unsigned int a, unsigned int b);
+
+/*
+ * The heap keeps each id's position in pos[], so an id can be removed or
+ * re-sifted after its key changes in O(log n).  Ids must be below capacity.
+ * items[] grows as needed.  It does no locking of its own.
+ */
+typedef struct {
+    unsigned int *items;
+    unsigned int *pos;
+    unsigned int size;
+    unsigned int allocated;
+    unsigned int capacity;
+    heap_less_t less;
+    int owns_pos;
+} heap_t;
+
+extern void heap_init(heap_t *heap, unsigned int capacity, heap_less_t less);
+
+/*
+ * heap_init_shared() is heap_init() with a caller-supplied pos[] of capacity
+ * entries, all HEAP_NONE.  Heaps that never hold the same id at once (such as
+ * per-CPU run queues) can share one, so each costs memory only for the ids it
+ * actually holds.
+ */
+extern void heap_init_shared(heap_t *heap, unsigned int capacity,
+                             heap_less_t less, unsigned int *pos);
+
+/* heap_pos_alloc() returns a pos[] of capacity entries for heap_init_shared() */
+extern unsigned int *heap_pos_alloc(unsigned int capacity);
+
+/* heap_free() frees items[], and pos[] unless it was shared */
+extern void heap_free(heap_t *heap);
+
+extern void heap_push(heap_t *heap, unsigned int id);
+
+/* heap_top() and heap_pop() return HEAP_NONE if the heap is empty */
+extern unsigned int heap_top(const heap_t *heap);
+extern unsigned int heap_pop(heap_t *heap);
+
+extern int heap_contains(const heap_t *heap, unsigned int id);
+extern void heap_remove(heap_t *heap, unsigned int id);
+
+/* Restores the heap after id's key changed in either direction */
+extern void heap_update(heap_t *heap, unsigned int id);
+
+#endif /* __HEAP_H__ */
@@ -0,0 +1,114 @@
+/*
+ * lockprof.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Contention-profiling mutexes.  A profiled lock first tries the mutex, so an
+ * uncontended acquisition only pays for reading the clock.
+ */
+
+#include <errno.h>
+#include <time.h>
+
+#include "lockprof.h"
+
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ull +
+        (unsigned long long) ts.tv_nsec;
+}
+
+void prof_mutex_init(prof_mutex_t *m, int profiled)
+{
+    pthread_mutex_init(&m->mutex, NULL);
+    m->profiled = profiled;
+    m->acquired_at = 0;
+    m->stats.acquisitions = 0;
+    m->stats.contended = 0;
+    m->stats.wait_ns = 0;
+    m->stats.max_wait_ns = 0;
+    m->stats.hold_ns = 0;
+}
+
+void prof_mutex_destroy(prof_mutex_t *m)
+{
+    pthread_mutex_destroy(&m->mutex);
+}
+
+void prof_mutex_lock(prof_mutex_t *m)
+{
+    unsigned long long start, wait = 0;
+    int contended = 0;
+
+    if (!m->profiled)
+    {
+        pthread_mutex_lock(&m->mutex);
+        return;
+    }
+
+    start = now_ns();
+    if (pthread_mutex_trylock(&m->mutex) == EBUSY)
+    {
+        pthread_mutex_lock(&m->mutex);
+        contended = 1;
+    }
+    m->acquired_at = now_ns();
+    if (contended)
+    {
+        wait = m->acquired_at - start;
+        m->stats.contended++;
+        m->stats.wait_ns += wait;
+        if (wait > m->stats.max_wait_ns)
+            m->stats.max_wait_ns = wait;
+    }
+    m->stats.acquisitions++;
+}
+
+void prof_mutex_unlock(prof_mutex_t *m)
+{
+    if (m->profiled)
+        m->stats.hold_ns += now_ns() - m->acquired_at;
+    pthread_mutex_unlock(&m->mutex);
+}
+
+/* Time spent waiting on cond is neither holding nor contention */
+void prof_cond_wait(pthread_cond_t *cond, prof_mutex_t *m)
+{
+    if (m->profiled)
+        m->stats.hold_ns += now_ns() - m->acquired_at;
+    pthread_cond_wait(cond, &m->mutex);
+    if (m->profiled)
+        m->acquired_at = now_ns();
+}
+
+void lockprof_add(lock_stats_t *sum, const prof_mutex_t *m)
+{
+    sum->acquisitions += m->stats.acquisitions;
+    sum->contended += m->stats.contended;
+    sum->wait_ns += m->stats.wait_ns;
+    sum->hold_ns += m->stats.hold_ns;
+    if (m->stats.max_wait_ns > sum->max_wait_ns)
+        sum->max_wait_ns = m->stats.max_wait_ns;
+}
+
+void lockprof_print_header(FILE *out)
+{
+    fprintf(out, "%-16s %5s %10s %10s %10s %10s %10s %10s\n", "lock",
+        "count", "acquired", "contended", "wait ms", "max us", "hold ms",
+        "avg us");
+}
+
+void lockprof_print(FILE *out, const char *name, unsigned int instances,
+                    const lock_stats_t *stats)
+{
+    fprintf(out, "%-16s %5u %10lu %9.1f%% %10.2f %10.1f %10.2f %10.2f\n",
+        name, instances, stats->acquisitions,
+        stats->acquisitions ?
+        100.0 * (double) stats->contended / (double) stats->acquisitions : 0.0,
+        (double) stats->wait_ns / 1e6, (double) stats->max_wait_ns / 1e3,
+        (double) stats->hold_ns / 1e6,
+        stats->acquisitions ?
+        (double) stats->hold_ns / (double) stats->acquisitions / 1e3 : 0.0);
+}
@@ -0,0 +1,58 @@
+/*
+ * lockprof.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Mutexes that can measure their own contention.
+ */
+
+#ifndef __LOCKPROF_H__
+#define __LOCKPROF_H__
+
+#include <pthread.h>
+#include <stdio.h>
+
+/*
+ * What a lock has been through.  Acquisitions that had to block are counted
+ * as contended, and the time spent blocking is wait_ns.  hold_ns is the time
+ * the lock was held, not counting time released in prof_cond_wait().
+ */
+typedef struct {
+    unsigned long acquisitions;
+    unsigned long contended;
+    unsigned long long wait_ns;
+    unsigned long long max_wait_ns;
+    unsigned long long hold_ns;
+} lock_stats_t;
+
+/*
+ * A pthread mutex with lock_stats_t.  When profiled is 0 it costs one extra
+ * branch per operation over the bare mutex.  stats and acquired_at are only
+ * touched with the mutex held.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    int profiled;
+    unsigned long long acquired_at;
+    lock_stats_t stats;
+} prof_mutex_t;
+
+extern void prof_mutex_init(prof_mutex_t *m, int profiled);
+extern void prof_mutex_destroy(prof_mutex_t *m);
+extern void prof_mutex_lock(prof_mutex_t *m);
+extern void prof_mutex_unlock(prof_mutex_t *m);
+
+/* pthread_cond_wait() on a prof_mutex_t */
+extern void prof_cond_wait(pthread_cond_t *cond, prof_mutex_t *m);
+
+/* lockprof_add() adds m's statistics to sum, to report a family of locks */
+extern void lockprof_add(lock_stats_t *sum, const prof_mutex_t *m);
+
+/*
+ * lockprof_print_header() starts a table that lockprof_print() adds a row
+ * to, for the sum of instances locks named name.
+ */
+extern void lockprof_print_header(FILE *out);
+extern void lockprof_print(FILE *out, const char *name,
+                           unsigned int instances, const lock_stats_t *stats);
+
+#endif /* __LOCKPROF_H__ */
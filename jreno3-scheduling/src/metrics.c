@@ -0,0 +1,323 @@
+/*
+ * metrics.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Per-process and per-CPU scheduling metrics, fed by the simulator.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+#include "os-sim.h"
+
+
+void metrics_init(metrics_t *m, unsigned int proc_count, unsigned int cpu_count)
+{
+    unsigned int n;
+
+    m->procs = malloc(sizeof(proc_metrics_t) * (proc_count ? proc_count : 1));
+    m->cpu_busy = calloc(cpu_count ? cpu_count : 1, sizeof(unsigned long));
+    assert(m->procs != NULL && m->cpu_busy != NULL);
+    for (n = 0; n < proc_count; n++)
+    {
+        m->procs[n].arrival = METRICS_NONE;
+        m->procs[n].first_run = METRICS_NONE;
+        m->procs[n].completion = METRICS_NONE;
+        m->procs[n].ready_since = 0;
+        m->procs[n].waiting = 0;
+        m->procs[n].cpu = 0;
+        m->procs[n].jobs = 0;
+        m->procs[n].misses = 0;
+    }
+    m->proc_count = proc_count;
+    m->cpu_count = cpu_count;
+    m->lateness = NULL;
+    m->job_count = 0;
+    m->job_capacity = 0;
+}
+
+void metrics_free(metrics_t *m)
+{
+    free(m->procs);
+    free(m->cpu_busy);
+    free(m->lateness);
+}
+
+void metrics_arrive(metrics_t *m, unsigned int pid, unsigned int now)
+{
+    m->procs[pid].arrival = now;
+    metrics_ready(m, pid, now);
+}
+
+void metrics_ready(metrics_t *m, unsigned int pid, unsigned int now)
+{
+    m->procs[pid].ready_since = now;
+}
+
+void metrics_dispatch(metrics_t *m, unsigned int pid, unsigned int now)
+{
+    proc_metrics_t *p = &m->procs[pid];
+
+    if (p->first_run == METRICS_NONE)
+        p->first_run = now;
+    p->waiting += now - p->ready_since;
+}
+
+void metrics_complete(metrics_t *m, unsigned int pid, unsigned int now)
+{
+    m->procs[pid].completion = now;
+}
+
+void metrics_cpu_tick(metrics_t *m, unsigned int cpu_id, unsigned int pid)
+{
+    m->cpu_busy[cpu_id]++;
+    m->procs[pid].cpu++;
+}
+
+void metrics_job(metrics_t *m, unsigned int pid, unsigned int now,
+                 unsigned int deadline)
+{
+    long late = (long) now - (long) deadline;
+
+    if (m->job_count == m->job_capacity)
+    {
+        m->job_capacity = m->job_capacity ? m->job_capacity * 2 : 256;
+        m->lateness = realloc(m->lateness, m->job_capacity * sizeof(long));
+        assert(m->lateness != NULL);
+    }
+    m->lateness[m->job_count++] = late;
+    m->procs[pid].jobs++;
+    if (late > 0)
+        m->procs[pid].misses++;
+}
+
+
+
+static int ulong_cmp(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long*) a, y = *(const unsigned long*) b;
+    return x < y ? -1 : (x > y);
+}
+
+/* Nearest-rank percentile of a sorted array */
+static unsigned long percentile(const unsigned long *sorted, unsigned int n,
+                                unsigned int pct)
+{
+    unsigned int rank = (unsigned int) ceil(pct / 100.0 * n);
+    return sorted[rank ? rank - 1 : 0];
+}
+
+/* Prints mean and p50/p95/p99 of values (in ticks) as seconds, and sorts it */
+static void print_distribution(FILE *out, const char *label,
+                               unsigned long *values, unsigned int n)
+{
+    unsigned long long sum = 0;
+    unsigned int k;
+
+    if (n == 0)
+        return;
+    for (k = 0; k < n; k++)
+        sum += values[k];
+    qsort(values, n, sizeof(unsigned long), ulong_cmp);
+    fprintf(out, "%-16s mean %.1f s  p50 %.1f s  p95 %.1f s  p99 %.1f s\n",
+        label, (double) sum / n / 10.0,
+        percentile(values, n, 50) / 10.0, percentile(values, n, 95) / 10.0,
+        percentile(values, n, 99) / 10.0);
+}
+
+static int long_cmp(const void *a, const void *b)
+{
+    long x = *(const long*) a, y = *(const long*) b;
+    return x < y ? -1 : (x > y);
+}
+
+/* percentile() for signed values */
+static long percentile_signed(const long *sorted, unsigned long n,
+                              unsigned int pct)
+{
+    unsigned long rank = (unsigned long) ceil(pct / 100.0 * n);
+    return sorted[rank ? rank - 1 : 0];
+}
+
+/* Deadline misses and the lateness distribution of real-time jobs */
+static void print_deadlines(const metrics_t *m, FILE *out)
+{
+    long *sorted = malloc(sizeof(long) * m->job_count);
+    unsigned long n, misses = 0;
+    unsigned int tasks = 0, late_tasks = 0;
+    long long sum = 0;
+
+    assert(sorted != NULL);
+    memcpy(sorted, m->lateness, sizeof(long) * m->job_count);
+    qsort(sorted, m->job_count, sizeof(long), long_cmp);
+    for (n = 0; n < m->job_count; n++)
+    {
+        sum += sorted[n];
+        misses += sorted[n] > 0;
+    }
+    for (n = 0; n < m->proc_count; n++)
+    {
+        tasks += m->procs[n].jobs > 0;
+        late_tasks += m->procs[n].misses > 0;
+    }
+
+    fprintf(out, "Deadline misses: %lu of %lu jobs (%.1f%%), %u of %u tasks "
+        "missed at least one\n", misses, m->job_count,
+        100.0 * misses / m->job_count, late_tasks, tasks);
+    fprintf(out, "%-16s mean %.1f s  p50 %.1f s  p95 %.1f s  p99 %.1f s  "
+        "max %.1f s\n", "Lateness:", (double) sum / m->job_count / 10.0,
+        percentile_signed(sorted, m->job_count, 50) / 10.0,
+        percentile_signed(sorted, m->job_count, 95) / 10.0,
+        percentile_signed(sorted, m->job_count, 99) / 10.0,
+        sorted[m->job_count - 1] / 10.0);
+    free(sorted);
+}
+
+/* Above this many CPUs only the spread of utilization is printed */
+#define METRICS_CPU_LIST_MAX 16
+
+void metrics_summarize(const metrics_t *m, unsigned int total,
+                       metrics_summary_t *summary)
+{
+    unsigned long long turnaround = 0, waiting = 0, response = 0;
+    unsigned long long busy = 0, misses = 0;
+    double jain_sum = 0.0, jain_sq = 0.0;
+    unsigned int n, done = 0;
+
+    if (total == 0)
+        total = 1;
+
+    for (n = 0; n < m->proc_count; n++)
+    {
+        const proc_metrics_t *p = &m->procs[n];
+        unsigned long t;
+
+        if (p->completion == METRICS_NONE)
+            continue;
+        t = p->completion - p->arrival;
+        turnaround += t;
+        waiting += p->waiting;
+        response += p->first_run - p->arrival;
+        done++;
+
+        /* Each process's share: CPU time received per unit of turnaround */
+        if (t > 0)
+        {
+            double x = (double) p->cpu / (double) t;
+            jain_sum += x;
+            jain_sq += x * x;
+        }
+    }
+    for (n = 0; n < m->cpu_count; n++)
+        busy += m->cpu_busy[n];
+    for (n = 0; n < m->proc_count; n++)
+        misses += m->procs[n].misses;
+
+    summary->throughput = done / (total / 10.0);
+    summary->utilization = (double) busy / total / m->cpu_count;
+    summary->turnaround = done ? (double) turnaround / done : 0.0;
+    summary->waiting = done ? (double) waiting / done : 0.0;
+    summary->response = done ? (double) response / done : 0.0;
+    summary->fairness = jain_sq > 0 ? jain_sum * jain_sum / (done * jain_sq) :
+        0.0;
+    summary->deadline_misses = m->job_count ? (double) misses / m->job_count :
+        0.0;
+}
+
+void metrics_print(const metrics_t *m, unsigned int total, FILE *out)
+{
+    unsigned long *turnaround, *waiting, *response;
+    double util_min = 1.0, util_max = 0.0;
+    metrics_summary_t summary;
+    unsigned int n, done = 0;
+
+    metrics_summarize(m, total, &summary);
+    if (total == 0)
+        total = 1;
+
+    turnaround = malloc(sizeof(unsigned long) * (m->proc_count + 1));
+    waiting = malloc(sizeof(unsigned long) * (m->proc_count + 1));
+    response = malloc(sizeof(unsigned long) * (m->proc_count + 1));
+    assert(turnaround != NULL && waiting != NULL && response != NULL);
+
+    for (n = 0; n < m->proc_count; n++)
+    {
+        const proc_metrics_t *p = &m->procs[n];
+
+        if (p->completion == METRICS_NONE)
+            continue;
+        turnaround[done] = p->completion - p->arrival;
+        waiting[done] = p->waiting;
+        response[done] = p->first_run - p->arrival;
+        done++;
+    }
+
+    fprintf(out, "Throughput: %.3f processes/s\n", summary.throughput);
+
+    for (n = 0; n < m->cpu_count; n++)
+    {
+        double u = (double) m->cpu_busy[n] / total;
+        if (u < util_min)
+            util_min = u;
+        if (u > util_max)
+            util_max = u;
+    }
+    fprintf(out, "CPU utilization: mean %.1f%%  min %.1f%%  max %.1f%%\n",
+        100.0 * summary.utilization, 100.0 * util_min, 100.0 * util_max);
+    if (m->cpu_count <= METRICS_CPU_LIST_MAX)
+    {
+        for (n = 0; n < m->cpu_count; n++)
+            fprintf(out, "  CPU %u: %.1f%%\n", n,
+                100.0 * m->cpu_busy[n] / total);
+    }
+
+    print_distribution(out, "Turnaround time:", turnaround, done);
+    print_distribution(out, "Waiting time:", waiting, done);
+    print_distribution(out, "Response time:", response, done);
+    if (summary.fairness > 0)
+        fprintf(out, "Jain's fairness index: %.4f\n", summary.fairness);
+    if (m->job_count > 0)
+        print_deadlines(m, out);
+
+    free(turnaround);
+    free(waiting);
+    free(response);
+}
+
+int metrics_write_csv(const metrics_t *m, const char *path, const pcb_t *pcbs)
+{
+    FILE *f;
+    unsigned int n;
+    int ret = 0;
+
+    if ((f = fopen(path, "w")) == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(f, "pid,name,arrival,first_run,completion,turnaround,waiting,"
+        "response,cpu,jobs,misses\n");
+    for (n = 0; n < m->proc_count; n++)
+    {
+        const proc_metrics_t *p = &m->procs[n];
+
+        if (p->completion == METRICS_NONE)
+            continue;
+        fprintf(f, "%u,%s,%u,%u,%u,%u,%lu,%u,%lu,%u,%u\n", n, pcbs[n].name,
+            p->arrival, p->first_run, p->completion,
+            p->completion - p->arrival, p->waiting,
+            p->first_run - p->arrival, p->cpu, p->jobs, p->misses);
+    }
+
+    if (ferror(f))
+        ret = -1;
+    if (fclose(f) != 0)
+        ret = -1;
+    if (ret != 0)
+        fprintf(stderr, "%s: write failed\n", path);
+    return ret;
+}
@@ -0,0 +1,108 @@
+/*
+ * metrics.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Per-process and per-CPU scheduling metrics, fed by the simulator.
+ */
+
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdio.h>
+
+struct _pcb_t;
+
+#define METRICS_NONE ((unsigned int) -1)
+
+/*
+ * Timing of one process, in ticks.
+ *
+ *   arrival : when the process was created
+ *   first_run : when it was first dispatched (METRICS_NONE until then)
+ *   completion : when it terminated (METRICS_NONE until then)
+ *   ready_since : when it last became READY
+ *   waiting : total time spent READY
+ *   cpu : total time spent on a CPU
+ *   jobs, misses : real-time jobs completed, and how many of them late
+ */
+typedef struct {
+    unsigned int arrival;
+    unsigned int first_run;
+    unsigned int completion;
+    unsigned int ready_since;
+    unsigned long waiting;
+    unsigned long cpu;
+    unsigned int jobs;
+    unsigned int misses;
+} proc_metrics_t;
+
+/* lateness holds every completed job's lateness, in completion order */
+typedef struct {
+    proc_metrics_t *procs;
+    unsigned int proc_count;
+    unsigned long *cpu_busy;
+    unsigned int cpu_count;
+    long *lateness;
+    unsigned long job_count;
+    unsigned long job_capacity;
+} metrics_t;
+
+/*
+ * The headline numbers of a run, for comparing runs side by side.  Times are
+ * means over completed processes, in ticks.
+ */
+typedef struct {
+    double throughput;          /* processes per second */
+    double utilization;         /* mean CPU utilization, 0 to 1 */
+    double turnaround;
+    double waiting;
+    double response;
+    double fairness;            /* Jain's index, see metrics_print() */
+    double deadline_misses;     /* fraction of real-time jobs that were late */
+} metrics_summary_t;
+
+extern void metrics_init(metrics_t *m, unsigned int proc_count,
+                         unsigned int cpu_count);
+extern void metrics_free(metrics_t *m);
+
+/*
+ * Events.  A process is READY from metrics_ready() (on creation, I/O
+ * completion or preemption) until metrics_dispatch().
+ */
+extern void metrics_arrive(metrics_t *m, unsigned int pid, unsigned int now);
+extern void metrics_ready(metrics_t *m, unsigned int pid, unsigned int now);
+extern void metrics_dispatch(metrics_t *m, unsigned int pid, unsigned int now);
+extern void metrics_complete(metrics_t *m, unsigned int pid, unsigned int now);
+
+/* Called once per tick for every CPU running pid */
+extern void metrics_cpu_tick(metrics_t *m, unsigned int cpu_id,
+                             unsigned int pid);
+
+/*
+ * metrics_job() records a real-time job of pid completing at now, which was
+ * due at deadline.  Only the simulator's supervisor calls it.
+ */
+extern void metrics_job(metrics_t *m, unsigned int pid, unsigned int now,
+                        unsigned int deadline);
+
+/*
+ * metrics_print() prints throughput, CPU utilization, turnaround, waiting and
+ * response time percentiles, and Jain's fairness index over each process's
+ * CPU time / turnaround.  If real-time jobs ran, it adds their deadline misses
+ * and the distribution of their lateness (completion minus deadline, so
+ * negative when early).  total is the length of the run in ticks.
+ */
+extern void metrics_print(const metrics_t *m, unsigned int total, FILE *out);
+
+/* metrics_summarize() fills summary for a run of total ticks */
+extern void metrics_summarize(const metrics_t *m, unsigned int total,
+                              metrics_summary_t *summary);
+
+/*
+ * metrics_write_csv() writes one row per process in pcbs (indexed by PID) to
+ * path.  Returns 0 on success, -1 on failure.
+ */
+extern int metrics_write_csv(const metrics_t *m, const char *path,
+                             const struct _pcb_t *pcbs);
+
+#endif /* __METRICS_H__ */
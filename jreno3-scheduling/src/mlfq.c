@@ -0,0 +1,248 @@
+/*
+ * mlfq.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The multi-level feedback queue policy (-m).
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mlfq.h"
+#include "policy.h"
+
+/* A process's MLFQ level, after any boost it missed */
+static unsigned int mlfq_level(const pcb_t *pcb)
+{
+    const proc_info_t *pi = &sched->info[pcb->pid];
+    unsigned int epoch = __atomic_load_n(&sched->mlfq.boost_epoch,
+        __ATOMIC_ACQUIRE);
+    return pi->mlfq.boost_epoch == epoch ? pi->mlfq.level : 0;
+}
+
+/*
+ * mlfq_move() demotes (up set) or promotes pcb one level from where
+ * mlfq_level() puts it, recording the boost that level is from.  Only the
+ * thread pcb belongs to calls it: the CPU it is leaving, under running_lock
+ * since its level orders running_heap, or the one waking it before it is
+ * queued.
+ */
+static void mlfq_move(const pcb_t *pcb, int up)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    unsigned int epoch = __atomic_load_n(&sched->mlfq.boost_epoch,
+        __ATOMIC_ACQUIRE);
+    unsigned int level = pi->mlfq.boost_epoch == epoch ? pi->mlfq.level : 0;
+    if (up && level + 1 < sched->mlfq.levels) {
+        level++;
+    } else if (!up && level > 0) {
+        level--;
+    }
+    pi->mlfq.level = level;
+    pi->mlfq.boost_epoch = epoch;
+}
+
+/*
+ * mlfq_maybe_boost() moves every queued process back to level 0 once boost
+ * ticks have passed since the last boost.  Only one CPU wins the
+ * compare-and-swap.  Processes not in a queue keep their old level, which
+ * mlfq_level() reads as 0 until mlfq_move() next records one.
+ */
+static void mlfq_maybe_boost(void)
+{
+    unsigned int now = get_simulator_time();
+    unsigned int last = __atomic_load_n(&sched->mlfq.last_boost,
+        __ATOMIC_RELAXED);
+    if (now - last < sched->mlfq.boost ||
+        !__atomic_compare_exchange_n(&sched->mlfq.last_boost, &last, now, 0,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+    __atomic_add_fetch(&sched->mlfq.boost_epoch, 1, __ATOMIC_RELEASE);
+    sched->mlfq.boosts++;
+    for (unsigned int i = 0; i < (sched->per_cpu ? sched->cpu_count : 1); i++) {
+        runqueue_t *rq = &sched->runqueues[i];
+        prof_mutex_lock(&rq->lock);
+        for (unsigned int l = 1; l < sched->mlfq.levels; l++) {
+            pcb_queue_t *q = &rq->mlfq.levels[l];
+            if (!q->head) {
+                continue;
+            }
+            if (rq->mlfq.levels[0].tail) {
+                rq->mlfq.levels[0].tail->next = q->head;
+            } else {
+                rq->mlfq.levels[0].head = q->head;
+            }
+            rq->mlfq.levels[0].tail = q->tail;
+            rq->mlfq.levels[0].size += q->size;
+            pcb_queue_init(q);
+        }
+        rq->mlfq.level_mask = rq->size ? 1 : 0;
+        prof_mutex_unlock(&rq->lock);
+    }
+}
+
+static void mlfq_push(runqueue_t *rq, pcb_t *pcb)
+{
+    unsigned int level = mlfq_level(pcb);
+    pcb_queue_push(&rq->mlfq.levels[level], pcb);
+    rq->mlfq.level_mask |= 1u << level;
+}
+
+static pcb_t *mlfq_pop(runqueue_t *rq)
+{
+    pcb_t *pcb;
+    unsigned int level;
+    if (!rq->mlfq.level_mask) {
+        return NULL;
+    }
+    level = (unsigned int) __builtin_ctz(rq->mlfq.level_mask);
+    pcb = pcb_queue_pop(&rq->mlfq.levels[level]);
+    if (!rq->mlfq.levels[level].head) {
+        rq->mlfq.level_mask &= ~(1u << level);
+    }
+    return pcb;
+}
+
+/* Higher levels first, with no tie-break, so equals never preempt */
+static int mlfq_runs_before(const pcb_t *a, const pcb_t *b)
+{
+    return mlfq_level(a) < mlfq_level(b);
+}
+
+static int mlfq_quantum(unsigned int cpu_id, const pcb_t *pcb)
+{
+    (void) cpu_id;
+    return sched->mlfq.quantum[mlfq_level(pcb)];
+}
+
+/*
+ * A process drops a level when it used up its quantum, rather than being
+ * bumped by a wake-up or cut short by its group's quota.  Its level orders
+ * running_heap, so it leaves the heap first.
+ */
+static void mlfq_leave(unsigned int cpu_id, pcb_t *pcb, process_state_t state)
+{
+    if (state != PROCESS_READY || sched->cpus[cpu_id].forced ||
+        sched->cpus[cpu_id].budget_limited) {
+        return;
+    }
+    prof_mutex_lock(&sched->running_lock);
+    heap_remove(&sched->running_heap, cpu_id);
+    mlfq_move(pcb, 1);
+    prof_mutex_unlock(&sched->running_lock);
+}
+
+/* Coming back from I/O earns a promotion */
+static void mlfq_wake(pcb_t *pcb)
+{
+    mlfq_move(pcb, 0);
+}
+
+static void mlfq_create(const scheduler_config_t *config)
+{
+    sched->mlfq.levels = config->mlfq_levels;
+    memcpy(sched->mlfq.quantum, config->mlfq_quantum,
+        sizeof(sched->mlfq.quantum));
+    sched->mlfq.boost = config->mlfq_boost;
+}
+
+static void mlfq_rq_init(runqueue_t *rq, unsigned int index)
+{
+    (void) index;
+    rq->mlfq.levels = malloc(sizeof(pcb_queue_t) * sched->mlfq.levels);
+    assert(rq->mlfq.levels != NULL);
+    for (unsigned int l = 0; l < sched->mlfq.levels; l++) {
+        pcb_queue_init(&rq->mlfq.levels[l]);
+    }
+    rq->mlfq.level_mask = 0;
+}
+
+static void mlfq_rq_free(runqueue_t *rq)
+{
+    free(rq->mlfq.levels);
+}
+
+static void mlfq_print_stats(void)
+{
+    printf("# of Priority Boosts: %lu\n", sched->mlfq.boosts);
+}
+
+const sched_policy_t mlfq_policy = {
+    .preemptive = 1,
+    .create = mlfq_create,
+    .rq_init = mlfq_rq_init,
+    .rq_free = mlfq_rq_free,
+    .push = mlfq_push,
+    .pop = mlfq_pop,
+    .runs_before = mlfq_runs_before,
+    .quantum = mlfq_quantum,
+    .pick = mlfq_maybe_boost,
+    .leave = mlfq_leave,
+    .wake = mlfq_wake,
+    .print_stats = mlfq_print_stats,
+};
+
+/*
+ * scheduler_parse_mlfq() reads -m's "levels=N,quanta=q0:q1:...,boost=T".
+ * Levels without a quantum double the one above them.  "default" keeps the
+ * defaults.
+ */
+extern int scheduler_parse_mlfq(scheduler_config_t *config, const char *spec) {
+    char *copy = strdup(spec), *save, *tok;
+    unsigned int quanta = 0;
+    int ret = 0;
+    assert(copy != NULL);
+    config->algorithm = MLFQ;
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(tok, '='), *q, *qsave;
+        if (strcmp(tok, "default") == 0) {
+            continue;
+        }
+        if (value == NULL) {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        if (strcmp(tok, "levels") == 0) {
+            long n = strtol(value, NULL, 10);
+            if (n < 1 || n > MLFQ_MAX_LEVELS) {
+                ret = -1;
+            }
+            config->mlfq_levels = (unsigned int) n;
+        } else if (strcmp(tok, "quanta") == 0) {
+            quanta = 0;
+            for (q = strtok_r(value, ":", &qsave); q != NULL && ret == 0;
+                 q = strtok_r(NULL, ":", &qsave)) {
+                long n = strtol(q, NULL, 10);
+                if (n < 1 || quanta == MLFQ_MAX_LEVELS) {
+                    ret = -1;
+                    break;
+                }
+                config->mlfq_quantum[quanta++] = (int) n;
+            }
+        } else if (strcmp(tok, "boost") == 0) {
+            long n = strtol(value, NULL, 10);
+            if (n < 1) {
+                ret = -1;
+            }
+            config->mlfq_boost = (unsigned int) n;
+        } else {
+            ret = -1;
+        }
+    }
+    free(copy);
+    if (quanta == 0) {
+        quanta = 3;
+    }
+    for (unsigned int l = quanta; l < config->mlfq_levels; l++) {
+        config->mlfq_quantum[l] = config->mlfq_quantum[l - 1] * 2;
+    }
+    if (ret != 0) {
+        fprintf(stderr, "Bad MLFQ spec '%s'\n", spec);
+    }
+    return ret;
+}
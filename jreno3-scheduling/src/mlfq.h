@@ -0,0 +1,50 @@
+/*
+ * mlfq.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The multi-level feedback queue policy (-m).
+ *
+ * A process that uses up its quantum at a level drops to the next one; one
+ * that comes back from I/O moves up a level.  Every boost ticks everything
+ * is moved back to level 0, which only bumps boost_epoch and splices the
+ * queues together.
+ */
+
+#ifndef __MLFQ_H__
+#define __MLFQ_H__
+
+#include "os-sim.h"
+#include "queue.h"
+#include "student.h"
+
+/*
+ * Per-process: level, 0 being the highest, and boost_epoch, the boost that
+ * level is from.  A process from an earlier boost is really at level 0.
+ */
+typedef struct {
+    unsigned int level;
+    unsigned int boost_epoch;
+} mlfq_proc_t;
+
+/*
+ * Per run queue: one FIFO per level in levels[], with bit n of level_mask set
+ * while levels[n] is non-empty.
+ */
+typedef struct {
+    pcb_queue_t *levels;
+    unsigned int level_mask;
+} mlfq_rq_t;
+
+/* The settings from scheduler_config_t, and the boost state */
+typedef struct {
+    unsigned int levels;
+    int quantum[MLFQ_MAX_LEVELS];
+    unsigned int boost;
+    unsigned int boost_epoch;
+    unsigned int last_boost;
+    unsigned long boosts;
+} mlfq_sched_t;
+
+extern const struct sched_policy mlfq_policy;
+
+#endif /* __MLFQ_H__ */
@@ -3,19 +3,24 @@
  * Multithreaded OS Simulation for CS 2200
  *
  * The simulator internals.
- *
- * DO NOT MODIFY THIS FILE
  */
 
 #include <assert.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 
+#include "eventlog.h"
+#include "heap.h"
+#include "lockprof.h"
+#include "metrics.h"
 #include "os-sim.h"
 #include "process.h"
+#include "realtime.h"
 #include "student.h"
 
 
@@ -27,139 +32,412 @@ typedef enum {
     CPU_TERMINATE
 } simulator_cpu_state_t;
 
+/*
+ * Each CPU thread spins on its own entry, so entries are padded out to a
+ * cache line to keep neighbouring CPUs from false-sharing.
+ *
+ * lock protects the rest of the entry.  While a process runs, state is
+ * CPU_RUNNING and the CPU thread waits on wakeup.  Raising an event (see
+ * raise_event()) sets state and bumps raised; the CPU thread copies raised
+ * before calling the student's handler and stores it in handled afterwards,
+ * broadcasting scheduled, so whoever raised an event can wait for exactly
+ * that event to be handled.
+ */
 typedef struct {
     pcb_t *current;
     simulator_cpu_state_t state;
+    prof_mutex_t lock;
     pthread_cond_t wakeup;
+    pthread_cond_t scheduled;
+    unsigned long raised, handled;
     int preemption_timer;
-} simulator_cpu_data_t;
+    simulator_t *owner;
+} __attribute__((aligned(CACHE_LINE_SIZE))) simulator_cpu_data_t;
 
-/* The I/O queue is a simple, FIFO queue using a linked list */
+/* Each device's I/O queue is a linked list in order of submission */
 typedef struct _io_request {
     pcb_t *pcb;
     unsigned int execution_time;
+    unsigned int submitted;
     struct _io_request *next;
 } io_request;
 
+/*
+ * An I/O device serves active until it completes, then picks the next
+ * request from its queue.  busy, served and queue_wait (ticks requests spent
+ * queued before service) feed the final statistics.
+ */
+typedef struct {
+    io_request *head, *tail;
+    io_request *active;
+    unsigned long busy;
+    unsigned long served;
+    unsigned long long queue_wait;
+} io_device_t;
 
-static io_request *io_queue_head = NULL, *io_queue_tail = NULL;
-static simulator_cpu_data_t *simulator_cpu_data;
-static pthread_t *cpu_thread;
-static pthread_mutex_t simulator_mutex;
-static unsigned int simulator_time = 0;
-static unsigned int processes_terminated = 0;
-static unsigned int cpu_count;
-static unsigned int ready_counter = 0, running_counter = 0, waiting_counter = 0;
-static unsigned int context_switches = 0;
+/*
+ * A simulator instance.  Everything one run touches lives here, so several
+ * instances can run side by side in one process.  Every thread working for an
+ * instance (its supervisor and CPU threads) points sim at it, which is how
+ * the student-facing calls below find their instance.
+ *
+ * Locking: the supervisor alone touches the I/O queues and process creation,
+ * so they need no lock.  CPU threads and the student's calls only take their
+ * CPU's lock, plus event_lock to append to the event log; the counters they
+ * share with the supervisor are atomic.  The order is a CPU's lock, then
+ * event_lock.  No simulator lock is held while the student's code runs.
+ */
+struct simulator {
+    /* Configuration, from simulator_config_t */
+    unsigned int cpu_count;
+    unsigned int io_device_count;
+    io_policy_t io_policy;
+    unsigned int io_deadline;
+    int headless;
+    int quiet;
+    const char *metrics_csv_path;
+    const char *event_log_path;
+
+    pcb_t *processes;
+    unsigned int process_count;
+    void *scheduler;
+
+    io_device_t *io_devices;
+    pcb_t **io_completed;
+    simulator_cpu_data_t *simulator_cpu_data;
+    pthread_t *cpu_thread;
+    unsigned int simulator_time;
+    unsigned int processes_created;
+    unsigned int processes_terminated;
+    unsigned long long ready_counter, running_counter, waiting_counter;
+
+    /*
+     * Processes currently on a CPU, in an I/O queue, and sleeping until their
+     * next job.  Together with processes_created and processes_terminated
+     * these give the number of processes in each state without walking the
+     * process table.
+     */
+    unsigned int running_count, io_count, sleep_count;
+    unsigned int context_switches;
+
+    /* Set once every process has terminated; CPU threads then exit */
+    int done;
+
+    metrics_t metrics;
+    eventlog_t event_log;
+    eventlog_t replay_log;
+    prof_mutex_t event_lock;
+
+    /*
+     * Deterministic mode (-d, -y).  A CPU thread then only runs a handler
+     * for an event raised by the supervisor, which raises CPU_IDLE on idle
+     * CPUs in dispatch_idle(), in an order drawn from rng.  idle_order is
+     * scratch space for that.
+     */
+    int deterministic;
+    uint64_t rng;
+    unsigned int *idle_order;
+
+    /* Profile the locks above (-k) */
+    int lock_profile;
+
+    /*
+     * Migration penalties.  last_cpu is the CPU each process last ran on, or
+     * -1; it is only touched by context_switch() while the process is being
+     * dispatched.  migrations counts moves by distance.
+     */
+    topology_t topology;
+    int *last_cpu;
+    unsigned long migrations[MIGRATE_NODE + 1];
+    unsigned long migration_penalty;
+
+    /*
+     * Real-time tasks between jobs (realtime.h), in a heap ordered by next
+     * release.  release is each task's latest release and jobs the number of
+     * jobs it has finished.  Only allocated if there are real-time tasks, and
+     * only touched by the supervisor.
+     */
+    heap_t sleepers;
+    unsigned int *release;
+    unsigned int *jobs;
+
+    /* The tick set_timer() last asked for, or NO_TIMER */
+    unsigned int timer;
+};
+
+#define NO_TIMER ((unsigned int) -1)
+
+static __thread simulator_t *sim;
 
 static void simulator_supervisor_thread(void);
 static void simulator_cpu_thread(unsigned int cpu_id);
+static void simulator_free(simulator_t *s);
 
 int nanosleep(const struct timespec *rqtp, struct timespec *rmtp);
 
 static void print_gantt_header(void);
-static void print_gantt_line(void);static void print_final_stats(void);
-
+static void count_states(unsigned int *ready, unsigned int *running,
+                         unsigned int *waiting);
+static void print_gantt_line(void);
+static void print_final_stats(void);
+static void print_lock_profile(void);
+static void print_topology_stats(void);
+static void print_divergence(void);
+
+static void raise_event(simulator_cpu_data_t *cpu,
+                        simulator_cpu_state_t event);
 static void simulate_cpus(void);
 static void simulate_process(unsigned int cpu_id, pcb_t *pcb);
-static void submit_io_request(pcb_t *pcb, unsigned int execution_time);
+static unsigned int submit_io_request(pcb_t *pcb, const op_t *op);
 static void simulate_io(void);
+static void sleep_until_release(unsigned int cpu_id, pcb_t *pcb);
+static void simulate_releases(void);
 static void simulate_creat(void);
+static void simulate_timer(void);
+static void dispatch_idle(void);
+static int release_less(unsigned int a, unsigned int b);
 
 static void* simulator_cpu_thread_func(void *data);
 
+/* Appends to the event log, if there is one */
+static void log_event(event_type_t type, unsigned int cpu_id, unsigned int pid,
+                      unsigned int arg)
+{
+    if (sim->event_log.file == NULL && sim->replay_log.file == NULL)
+        return;
+    prof_mutex_lock(&sim->event_lock);
+    if (sim->event_log.file != NULL)
+        eventlog_add(&sim->event_log, get_simulator_time(), type, cpu_id, pid,
+            arg);
+    if (sim->replay_log.file != NULL)
+        eventlog_check(&sim->replay_log, get_simulator_time(), type, cpu_id,
+            pid, arg);
+    prof_mutex_unlock(&sim->event_lock);
+}
 
-/*
- * IRWL - An "Inverted" Readers-Writers Lock
- *
- * Unlike a traditional readers-writers lock, this lock allows infinitely
- * many writers or one reader.
- *
- * Its purpose is to protect the state variable of the PCB structures, which
- * is accessed both by the student's code and by print_gantt_line().  We
- * could use a simple mutex, and lock it while calling any student's code,
- * but then the student's code wouldn't get tested for thread-safeness.
- * So we will intentionally let multiple pieces of the student's code run
- * simultaneously.
- *
- * For the student_lock, the IRWL_WRITER should always be locked while
- * student code is executing on a CPU thread.  The IRWL_READER should always be
- * locked whenever non-constant data in a PCB is used by the library.
- */
-typedef struct {
-    pthread_mutex_t mutex;
-    pthread_cond_t no_writers;
-    int writers;
-} irwl;
-
-#define IRWL_INIT(i) \
-    pthread_mutex_init(&(i).mutex, NULL); \
-    pthread_cond_init(&(i).no_writers, NULL); \
-    (i).writers = 0;
-
-#define IRWL_READER_LOCK(i) \
-    pthread_mutex_lock(&(i).mutex); \
-    while ((i).writers > 0) \
-    { pthread_cond_wait(&(i).no_writers, &(i).mutex); }
-
-#define IRWL_READER_UNLOCK(i) \
-    pthread_mutex_unlock(&(i).mutex);
-
-#define IRWL_WRITER_LOCK(i) \
-    pthread_mutex_lock(&(i).mutex); \
-    (i).writers++; \
-    pthread_mutex_unlock(&(i).mutex);
 
-#define IRWL_WRITER_UNLOCK(i) \
-    pthread_mutex_lock(&(i).mutex); \
-    (i).writers--; \
-    if ((i).writers == 0) \
-    { pthread_cond_signal(&(i).no_writers); } \
-    pthread_mutex_unlock(&(i).mutex);
 
-static irwl student_lock;
+/* Stack size for CPU threads */
+#define CPU_THREAD_STACK_SIZE (256 * 1024)
 
 
 /* The big initialization function */
-extern void start_simulator(unsigned int new_cpu_count)
+extern int simulator_run(const simulator_config_t *config, pcb_t *table,
+                         unsigned int count, void *scheduler,
+                         simulator_results_t *results)
 {
+    eventlog_header_t header;
+    pthread_attr_t attr;
     unsigned int n;
+    int ret = 0;
 
     /* Make sure the # of CPUs is reasonable */
-    cpu_count = new_cpu_count;
-    if (cpu_count < 1 || cpu_count > 16)
+    if (config->cpu_count < 1 || config->cpu_count > MAX_CPU_COUNT)
     {
-        fprintf(stderr, "CPU Count must be an integer from 1 to 16!\n\n");
-        exit(-1);
+        fprintf(stderr, "CPU Count must be an integer from 1 to %d!\n\n",
+            MAX_CPU_COUNT);
+        return -1;
+    }
+    if (count < 1 || count > MAX_PROCESS_COUNT)
+    {
+        fprintf(stderr, "Process count must be an integer from 1 to %d!\n\n",
+            MAX_PROCESS_COUNT);
+        return -1;
+    }
+
+    sim = calloc(1, sizeof(simulator_t));
+    assert(sim != NULL);
+    sim->cpu_count = config->cpu_count;
+    sim->io_device_count = config->io_devices;
+    sim->io_policy = config->io_policy;
+    sim->io_deadline = config->io_deadline;
+    sim->headless = config->headless || config->quiet;
+    sim->quiet = config->quiet;
+    sim->metrics_csv_path = config->csv_path;
+    sim->event_log_path = config->event_log_path;
+    sim->lock_profile = config->lock_profile;
+    sim->topology = config->topology;
+    sim->processes = table;
+    sim->process_count = count;
+    sim->scheduler = scheduler;
+    sim->deterministic = config->deterministic;
+    sim->rng = config->seed;
+    sim->timer = NO_TIMER;
+
+    /* A replay repeats the recorded run, so it takes its seed from the log */
+    if (config->replay_path != NULL)
+    {
+        if (eventlog_open_replay(&sim->replay_log, config->replay_path,
+                &header) != 0)
+        {
+            free(sim);
+            sim = NULL;
+            return -1;
+        }
+        if (!header.deterministic || header.cpu_count != sim->cpu_count ||
+            header.process_count != sim->process_count)
+        {
+            if (!header.deterministic)
+                fprintf(stderr, "%s: not recorded in deterministic mode\n",
+                    config->replay_path);
+            else
+                fprintf(stderr, "%s: recorded with %u CPUs and %u processes\n",
+                    config->replay_path, header.cpu_count,
+                    header.process_count);
+            eventlog_close(&sim->replay_log);
+            free(sim);
+            sim = NULL;
+            return -1;
+        }
+        sim->deterministic = 1;
+        sim->rng = header.seed;
     }
 
+    header.deterministic = (uint32_t) sim->deterministic;
+    header.seed = sim->rng;
+    header.cpu_count = sim->cpu_count;
+    header.process_count = sim->process_count;
+    if (sim->event_log_path != NULL &&
+        eventlog_open(&sim->event_log, sim->event_log_path, &header) != 0)
+    {
+        if (sim->replay_log.file != NULL)
+            eventlog_close(&sim->replay_log);
+        free(sim);
+        sim = NULL;
+        return -1;
+    }
 
     /* Allocate arrays */
-    cpu_thread = malloc(sizeof(pthread_t) * cpu_count);
-    assert(cpu_thread != NULL);
-    simulator_cpu_data = malloc(sizeof(simulator_cpu_data_t) * cpu_count);
-    assert(simulator_cpu_data != NULL);
+    sim->cpu_thread = malloc(sizeof(pthread_t) * sim->cpu_count);
+    assert(sim->cpu_thread != NULL);
+    if (posix_memalign((void**)&sim->simulator_cpu_data, CACHE_LINE_SIZE,
+            sizeof(simulator_cpu_data_t) * sim->cpu_count) != 0)
+        sim->simulator_cpu_data = NULL;
+    assert(sim->simulator_cpu_data != NULL);
+    metrics_init(&sim->metrics, sim->process_count, sim->cpu_count);
+    sim->io_devices = calloc(sim->io_device_count, sizeof(io_device_t));
+    sim->io_completed = malloc(sizeof(pcb_t*) * sim->io_device_count);
+    assert(sim->io_devices != NULL && sim->io_completed != NULL);
+    sim->last_cpu = malloc(sizeof(int) * sim->process_count);
+    sim->idle_order = malloc(sizeof(unsigned int) * sim->cpu_count);
+    assert(sim->last_cpu != NULL && sim->idle_order != NULL);
+    for (n=0; n<sim->process_count; n++)
+        sim->last_cpu[n] = -1;
+    for (n=0; n<sim->process_count; n++)
+    {
+        if (rt_is_task(&sim->processes[n]))
+        {
+            sim->release = calloc(sim->process_count, sizeof(unsigned int));
+            sim->jobs = calloc(sim->process_count, sizeof(unsigned int));
+            assert(sim->release != NULL && sim->jobs != NULL);
+            heap_init(&sim->sleepers, sim->process_count, release_less);
+            break;
+        }
+    }
 
     /* Initialize mutexes and condition variables */
-    pthread_mutex_init(&simulator_mutex, NULL);
-    simulator_time = 0;
-    for (n=0; n<cpu_count; n++)
+    prof_mutex_init(&sim->event_lock, sim->lock_profile);
+    for (n=0; n<sim->cpu_count; n++)
+    {
+        sim->simulator_cpu_data[n].current = NULL;
+        sim->simulator_cpu_data[n].state = CPU_IDLE;
+        sim->simulator_cpu_data[n].raised = 0;
+        sim->simulator_cpu_data[n].handled = 0;
+        sim->simulator_cpu_data[n].preemption_timer = -1;
+        sim->simulator_cpu_data[n].owner = sim;
+        prof_mutex_init(&sim->simulator_cpu_data[n].lock, sim->lock_profile);
+        pthread_cond_init(&sim->simulator_cpu_data[n].wakeup, NULL);
+        pthread_cond_init(&sim->simulator_cpu_data[n].scheduled, NULL);
+    }
+
+    /*
+     * Start CPU threads.  CPU threads only ever block on a condition variable
+     * or run the scheduler, so a small stack is plenty and keeps a large CPU
+     * count from reserving gigabytes of address space.
+     */
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, CPU_THREAD_STACK_SIZE);
+    for (n=0; n<sim->cpu_count; n++)
+        pthread_create(&sim->cpu_thread[n], &attr, simulator_cpu_thread_func,
+            &sim->simulator_cpu_data[n]);
+    pthread_attr_destroy(&attr);
+
+    /* Run the supervisor on this thread until every process terminates */
+    simulator_supervisor_thread();
+
+    /*
+     * Release the CPU threads idling in the student's code, and in
+     * deterministic mode those waiting for an event, then reap them
+     */
+    stop_idle();
+    for (n=0; n<sim->cpu_count; n++)
+    {
+        prof_mutex_lock(&sim->simulator_cpu_data[n].lock);
+        pthread_cond_signal(&sim->simulator_cpu_data[n].wakeup);
+        prof_mutex_unlock(&sim->simulator_cpu_data[n].lock);
+    }
+    for (n=0; n<sim->cpu_count; n++)
+        pthread_join(sim->cpu_thread[n], NULL);
+
+    if (!sim->quiet)
+        print_final_stats();
+    if (sim->metrics_csv_path != NULL &&
+        metrics_write_csv(&sim->metrics, sim->metrics_csv_path,
+            sim->processes) != 0)
+        ret = -1;
+    if (sim->event_log.file != NULL && eventlog_close(&sim->event_log) != 0)
+        ret = -1;
+    if (sim->replay_log.file != NULL)
     {
-        simulator_cpu_data[n].current = NULL;
-        simulator_cpu_data[n].state = CPU_IDLE;
-        simulator_cpu_data[n].preemption_timer = -1;
-        pthread_cond_init(&simulator_cpu_data[n].wakeup, NULL);
+        if (eventlog_close(&sim->replay_log) != 0)
+        {
+            print_divergence();
+            ret = -1;
+        }
+        else if (!sim->quiet)
+            printf("Replay of %s: all %llu events matched\n",
+                config->replay_path, sim->replay_log.written);
     }
 
-    IRWL_INIT(student_lock)
+    if (results != NULL)
+    {
+        results->context_switches = sim->context_switches;
+        results->total_time = sim->simulator_time;
+        results->ready_time = sim->ready_counter;
+        results->running_time = sim->running_counter;
+        results->waiting_time = sim->waiting_counter;
+        metrics_summarize(&sim->metrics, sim->simulator_time,
+            &results->metrics);
+    }
 
-    /* Start CPU threads */
-    for (n=0; n<cpu_count; n++)
-        pthread_create(&cpu_thread[n], NULL, simulator_cpu_thread_func,
-        (void*)(uintptr_t)n);
+    simulator_free(sim);
+    sim = NULL;
+    return ret;
+}
 
-    /* Start supervisor thread */
-    simulator_supervisor_thread();
+static void simulator_free(simulator_t *s)
+{
+    unsigned int n;
+
+    for (n=0; n<s->cpu_count; n++)
+    {
+        prof_mutex_destroy(&s->simulator_cpu_data[n].lock);
+        pthread_cond_destroy(&s->simulator_cpu_data[n].wakeup);
+        pthread_cond_destroy(&s->simulator_cpu_data[n].scheduled);
+    }
+    prof_mutex_destroy(&s->event_lock);
+    metrics_free(&s->metrics);
+    free(s->io_devices);
+    free(s->io_completed);
+    free(s->last_cpu);
+    free(s->idle_order);
+    if (s->release != NULL)
+        heap_free(&s->sleepers);
+    free(s->release);
+    free(s->jobs);
+    free(s->simulator_cpu_data);
+    free(s->cpu_thread);
+    free(s);
 }
 
 
@@ -170,29 +448,46 @@ extern void start_simulator(unsigned int new_cpu_count)
  */
 static void simulator_supervisor_thread(void)
 {
-    print_gantt_header();
+    if (!sim->headless)
+        print_gantt_header();
 
     /* Loop, performing execution every 100ms.  At each execution, we will
        display a line in the Gantt chart and check for pending I/O requests */
     while (1)
     {
-        pthread_mutex_lock(&simulator_mutex);
-
-        /* Exit when all processes terminate */
-        if (processes_terminated >= PROCESS_COUNT)
+        /* Stop when all processes terminate */
+        if (__atomic_load_n(&sim->processes_terminated, __ATOMIC_ACQUIRE) >=
+            sim->process_count)
         {
-            print_final_stats();
-            exit(0);
+            __atomic_store_n(&sim->done, 1, __ATOMIC_RELEASE);
+            return;
         }
 
-        print_gantt_line();
+        if (sim->headless)
+        {
+            unsigned int ready, running, waiting;
+            count_states(&ready, &running, &waiting);
+        }
+        else
+            print_gantt_line();
         simulate_cpus();
         simulate_io();
+        simulate_releases();
+        simulate_timer();
         simulate_creat();
-        simulator_time++;
-        pthread_mutex_unlock(&simulator_mutex);
+        if (sim->deterministic)
+            dispatch_idle();
+        __atomic_store_n(&sim->simulator_time, sim->simulator_time + 1,
+            __ATOMIC_RELAXED);
 
-        mt_safe_usleep(1);
+        /*
+         * Headless runs only give the CPU threads a chance to run; otherwise
+         * sleep so the chart scrolls at a watchable pace.
+         */
+        if (sim->headless)
+            sched_yield();
+        else
+            mt_safe_usleep(1);
     }
 }
 
@@ -202,9 +497,10 @@ static void simulator_supervisor_thread(void)
  *
  *   1) Each CPU thread has a state variable.  While the library is using the
  *      CPU thread to simulate a process, this variable is set to CPU_RUNNING.
+ *      context_switch() sets it when it puts a process on the CPU.
  *
  *   2) To "simulate" a process, we simply block on a condition variable.
- *      Each CPU thread has a dedicated condition variable.
+ *      Each CPU thread has a dedicated condition variable and lock.
  *
  *   3) For simplicity, the supervisor thread actually does all of the work.
  *      This makes synchronization in the simulator much easier, since all
@@ -215,77 +511,79 @@ static void simulator_supervisor_thread(void)
  *      variable.
  *
  *   4) Once the CPU thread unblocks, it calls the students event handler,
- *      then goes back to step 1.
+ *      tells whoever raised the event that it is done, then goes back to
+ *      step 1.
  *
  * There is one special case: idle.  Idle is simulated by the student's code,
- * not the library's.  So we simply set the state variable to CPU_IDLE, and
- * call the student's code.
+ * not the library's.  A CPU with no process has its state variable at
+ * CPU_IDLE, so we simply call the student's code.  In deterministic mode the
+ * CPU waits for the supervisor to raise CPU_IDLE instead, so every handler
+ * runs while the supervisor waits for it.
  */
 static void simulator_cpu_thread(unsigned int cpu_id)
 {
+    simulator_cpu_data_t *cpu = &sim->simulator_cpu_data[cpu_id];
     simulator_cpu_state_t state;
+    unsigned long taken;
 
-    while (1)
+    prof_mutex_lock(&cpu->lock);
+    while (!__atomic_load_n(&sim->done, __ATOMIC_ACQUIRE))
     {
-        pthread_mutex_lock(&simulator_mutex);
-
-        /* Let the simulator know the scheduler has been run */
-        pthread_cond_signal(&simulator_cpu_data[cpu_id].wakeup);
-
-        if (simulator_cpu_data[cpu_id].current == NULL)
+        /* Simulate the process, if any, until it raises an event */
+        while ((cpu->state == CPU_RUNNING ||
+                (sim->deterministic && cpu->raised == cpu->handled)) &&
+            !__atomic_load_n(&sim->done, __ATOMIC_ACQUIRE))
+            prof_cond_wait(&cpu->wakeup, &cpu->lock);
+        if (__atomic_load_n(&sim->done, __ATOMIC_ACQUIRE))
+            break;
+        state = cpu->state;
+        taken = cpu->raised;
+        if (state == CPU_PREEMPT)
         {
-            /* the idle process was selected */
-            simulator_cpu_data[cpu_id].state = CPU_IDLE;
+            metrics_ready(&sim->metrics, cpu->current->pid,
+                get_simulator_time());
+            log_event(EVENT_PREEMPT, cpu_id, cpu->current->pid, 0);
         }
-        else
+        else if (state == CPU_TERMINATE)
         {
-            /* a process was scheduled */
-            simulator_cpu_data[cpu_id].state = CPU_RUNNING;
-
-            while (simulator_cpu_data[cpu_id].state == CPU_RUNNING)
-                pthread_cond_wait(&simulator_cpu_data[cpu_id].wakeup,
-                    &simulator_mutex);
+            metrics_complete(&sim->metrics, cpu->current->pid,
+                get_simulator_time());
+            log_event(EVENT_TERMINATE, cpu_id, cpu->current->pid, 0);
+            __atomic_add_fetch(&sim->processes_terminated, 1,
+                __ATOMIC_RELEASE);
         }
-        state = simulator_cpu_data[cpu_id].state;
-        pthread_mutex_unlock(&simulator_mutex);
+        prof_mutex_unlock(&cpu->lock);
 
         /* Call student's code */
         switch (state)
         {
         case CPU_IDLE:
-            /*
-             * We can't lock the student_lock for idle(); otherwise we can't
-             * print statistics while any CPU is idling.
-             */
             idle(cpu_id);
             break;
 
         case CPU_PREEMPT:
-            IRWL_WRITER_LOCK(student_lock)
             preempt(cpu_id);
-            IRWL_WRITER_UNLOCK(student_lock)
             break;
 
         case CPU_YIELD:
-            IRWL_WRITER_LOCK(student_lock)
             yield(cpu_id);
-            IRWL_WRITER_UNLOCK(student_lock)
             break;
 
         case CPU_TERMINATE:
-            pthread_mutex_lock(&simulator_mutex);
-            processes_terminated++;
-            pthread_mutex_unlock(&simulator_mutex);
-            IRWL_WRITER_LOCK(student_lock)
             terminate(cpu_id);
-            IRWL_WRITER_UNLOCK(student_lock)
             break;
 
         case CPU_RUNNING:
             /* This should never happen!!! */
             break;
         }
+
+        /* Let the simulator know the scheduler has been run */
+        prof_mutex_lock(&cpu->lock);
+        cpu->handled = taken;
+        pthread_cond_broadcast(&cpu->scheduled);
     }
+    prof_mutex_unlock(&cpu->lock);
 }
 
 
@@ -299,131 +597,263 @@ static void print_gantt_header(void)
     unsigned int n;
 
     printf("Time  Ru Re Wa     ");
-    for (n=0; n<cpu_count; n++)
+    for (n=0; n<sim->cpu_count; n++)
         printf(" CPU %d   ", n);
     printf("     < I/O Queue <\n"
            "===== == == ==     ");
-    for (n=0; n<cpu_count; n++)
+    for (n=0; n<sim->cpu_count; n++)
         printf(" ========");
     printf("     =============\n");
 }
 
+/*
+ * count_states() updates the number of processes in each state.  Every live
+ * process is either on a CPU, in an I/O queue, or in the scheduler's ready
+ * queue, so the ready count falls out of the others.
+ */
+static void count_states(unsigned int *ready, unsigned int *running,
+                         unsigned int *waiting)
+{
+    *running = __atomic_load_n(&sim->running_count, __ATOMIC_RELAXED);
+    *waiting = sim->io_count + sim->sleep_count;
+    *ready = sim->processes_created -
+        __atomic_load_n(&sim->processes_terminated, __ATOMIC_RELAXED) -
+        *running - *waiting;
+    sim->running_counter += *running;
+    sim->waiting_counter += *waiting;
+    sim->ready_counter += *ready;
+}
+
 static void print_gantt_line(void)
 {
     io_request *r;
-    unsigned int current_ready = 0, current_running = 0, current_waiting = 0;
+    unsigned int current_ready, current_running, current_waiting;
     unsigned int n;
+    int separate = 0;
 
-
-    /*
-     * Update number of processes in each state.
-     */
-    IRWL_READER_LOCK(student_lock)
-    for (n=0; n<PROCESS_COUNT; n++)
-    {
-        switch(processes[n].state)
-        {
-        case PROCESS_READY:
-            current_ready++;
-            ready_counter++;
-            break;
-
-        case PROCESS_RUNNING:
-            current_running++;
-            running_counter++;
-            break;
-
-        case PROCESS_WAITING:
-            current_waiting++;
-            waiting_counter++;
-            break;
-
-        default:
-            break;
-        }
-    }
-    IRWL_READER_UNLOCK(student_lock)
+    count_states(&current_ready, &current_running, &current_waiting);
 
 
     /* Print time */
-    printf("%-5.1f %-2d %-2d %-2d     ", (float)simulator_time / 10.0,
+    printf("%-5.1f %-2d %-2d %-2d     ", (float)sim->simulator_time / 10.0,
         current_running, current_ready, current_waiting);
 
     /* Print running processes */
-    for (n=0; n<cpu_count; n++)
+    for (n=0; n<sim->cpu_count; n++)
     {
-        if (simulator_cpu_data[n].current != NULL)
-            printf(" %-8s", simulator_cpu_data[n].current->name);
+        prof_mutex_lock(&sim->simulator_cpu_data[n].lock);
+        if (sim->simulator_cpu_data[n].current != NULL)
+            printf(" %-8s", sim->simulator_cpu_data[n].current->name);
         else
             printf(" (IDLE)  ");
+        prof_mutex_unlock(&sim->simulator_cpu_data[n].lock);
     }
 
-    /* Print I/O requests */
+    /* Print I/O requests, the one in service first, skipping idle devices */
     printf("     <");
-    r = io_queue_head;
-    while (r != NULL)
+    for (n=0; n<sim->io_device_count; n++)
     {
-        printf(" %s", r->pcb->name);
-        r = r->next;
+        if (sim->io_devices[n].active == NULL &&
+            sim->io_devices[n].head == NULL)
+            continue;
+        if (separate)
+            printf(" |");
+        separate = 1;
+        if (sim->io_device_count > 1)
+            printf(" %u:", n);
+        if (sim->io_devices[n].active != NULL)
+            printf(" %s", sim->io_devices[n].active->pcb->name);
+        for (r = sim->io_devices[n].head; r != NULL; r = r->next)
+            printf(" %s", r->pcb->name);
     }
     printf(" <\n");
 }
 
 static void print_final_stats(void)
 {
+    unsigned int n;
+
     printf("\n\n");
-    printf("# of Context Switches: %u\n", context_switches);
-    printf("Total execution time: %.1f s\n", (float)simulator_time / 10.0);
-    printf("Total time spent in READY state: %.1f s\n", (float)ready_counter / 10.0);
+    printf("# of Context Switches: %u\n", sim->context_switches);
+    printf("Total execution time: %.1f s\n", (float)sim->simulator_time / 10.0);
+    printf("Total time spent in READY state: %.1f s\n",
+        (float)sim->ready_counter / 10.0);
+    metrics_print(&sim->metrics, sim->simulator_time, stdout);
+    rt_print_bounds(sim->processes, sim->process_count, sim->cpu_count,
+        stdout);
+    if (sim->io_device_count > 1 || sim->io_policy != IO_FIFO)
+    {
+        for (n=0; n<sim->io_device_count; n++)
+        {
+            const io_device_t *dev = &sim->io_devices[n];
+            printf("I/O device %u: %lu requests, %.1f%% busy, "
+                "mean queue wait %.1f s\n", n, dev->served,
+                100.0 * dev->busy / (sim->simulator_time ?
+                sim->simulator_time : 1),
+                dev->served ? (double) dev->queue_wait / dev->served / 10.0 :
+                0.0);
+        }
+    }
+    if (!topology_is_flat(&sim->topology) || sim->topology.core_cost > 0)
+        print_topology_stats();
+    if (sim->lock_profile)
+        print_lock_profile();
+    print_scheduler_stats();
+}
+
+/* Where a replayed run first differed from its log */
+static void print_divergence(void)
+{
+    const eventlog_t *log = &sim->replay_log;
+    const event_record_t *e = &log->expected, *a = &log->actual;
+
+    fprintf(stderr, "Replay diverged after %llu matching events:\n",
+        log->written);
+    fprintf(stderr, "  expected %s", eventlog_type_name(e->type));
+    if (e->type != UINT8_MAX)
+        fprintf(stderr, " at %.1f s: cpu %u pid %d arg %u", e->time / 10.0,
+            e->cpu, e->pid == EVENT_NO_PID ? -1 : (int) e->pid, e->arg);
+    fprintf(stderr, "\n  got      %s", eventlog_type_name(a->type));
+    if (a->type != UINT8_MAX)
+        fprintf(stderr, " at %.1f s: cpu %u pid %d arg %u", a->time / 10.0,
+            a->cpu, a->pid == EVENT_NO_PID ? -1 : (int) a->pid, a->arg);
+    fputc('\n', stderr);
+}
+
+/* Migrations by distance and how busy each node was */
+static void print_topology_stats(void)
+{
+    unsigned long long *busy = calloc(sim->topology.nodes,
+        sizeof(unsigned long long));
+    unsigned int *cpus = calloc(sim->topology.nodes, sizeof(unsigned int));
+    unsigned int n, node;
+
+    assert(busy != NULL && cpus != NULL);
+    printf("Migrations: %lu within a cache domain, %lu across cache domains, "
+        "%lu across nodes; %.1f s of penalty\n",
+        sim->migrations[MIGRATE_CORE], sim->migrations[MIGRATE_LLC],
+        sim->migrations[MIGRATE_NODE], sim->migration_penalty / 10.0);
+    for (n=0; n<sim->cpu_count; n++)
+    {
+        node = topology_node(&sim->topology, sim->cpu_count, n);
+        busy[node] += sim->metrics.cpu_busy[n];
+        cpus[node]++;
+    }
+    for (node=0; node<sim->topology.nodes; node++)
+    {
+        if (cpus[node] == 0)
+            continue;
+        printf("Node %u: %u CPUs, %.1f%% utilization\n", node, cpus[node],
+            100.0 * (double) busy[node] / cpus[node] /
+            (sim->simulator_time ? sim->simulator_time : 1));
+    }
+    free(busy);
+    free(cpus);
+}
+
+/* The simulator's side of -k; the scheduler reports its own locks */
+static void print_lock_profile(void)
+{
+    lock_stats_t cpus = { 0, 0, 0, 0, 0 };
+    unsigned int n;
+
+    for (n=0; n<sim->cpu_count; n++)
+        lockprof_add(&cpus, &sim->simulator_cpu_data[n].lock);
+    printf("\nSimulator locks:\n");
+    lockprof_print_header(stdout);
+    lockprof_print(stdout, "cpu", sim->cpu_count, &cpus);
+    if (sim->event_log.file != NULL)
+        lockprof_print(stdout, "event log", 1, &sim->event_lock.stats);
 }
 
 
 
 /*
- * context_switch() and force_preempt() are the two functions available to
- * student's code.
+ * charge_migration() makes a process that moved CPUs pay for its cold caches
+ * by lengthening the CPU burst it is about to run.
+ */
+static void charge_migration(unsigned int cpu_id, pcb_t *pcb)
+{
+    int from = sim->last_cpu[pcb->pid];
+    migration_t m;
+    unsigned int cost;
+
+    sim->last_cpu[pcb->pid] = (int) cpu_id;
+    if (from < 0)
+        return;
+    m = topology_migration(&sim->topology, sim->cpu_count,
+        (unsigned int) from, cpu_id);
+    if (m == MIGRATE_NONE)
+        return;
+    cost = topology_cost(&sim->topology, m);
+    __atomic_add_fetch(&sim->migrations[m], 1, __ATOMIC_RELAXED);
+    if (cost == 0 || pcb->pc->type != OP_CPU)
+        return;
+    __atomic_add_fetch(&sim->migration_penalty, cost, __ATOMIC_RELAXED);
+    pcb->pc->time += cost;
+    pcb->time_remaining += cost;
+}
+
+/*
+ * context_switch(), force_preempt() and set_timer() are the functions
+ * available to student's code.
  */
 extern void context_switch(unsigned int cpu_id, pcb_t *pcb,
                            int preemption_time)
 {
-    assert(cpu_id < cpu_count);
-    assert(pcb == NULL || (pcb >= processes && pcb <= processes +
-        PROCESS_COUNT - 1));
+    simulator_cpu_data_t *cpu;
+
+    assert(cpu_id < sim->cpu_count);
+    assert(pcb == NULL || (pcb >= sim->processes && pcb < sim->processes +
+        sim->process_count));
+
+    cpu = &sim->simulator_cpu_data[cpu_id];
+    prof_mutex_lock(&cpu->lock);
+    __atomic_add_fetch(&sim->context_switches, 1, __ATOMIC_RELAXED);
+    if (cpu->current != NULL)
+        __atomic_sub_fetch(&sim->running_count, 1, __ATOMIC_RELAXED);
+    if (pcb != NULL)
+    {
+        __atomic_add_fetch(&sim->running_count, 1, __ATOMIC_RELAXED);
+        metrics_dispatch(&sim->metrics, pcb->pid, get_simulator_time());
+        charge_migration(cpu_id, pcb);
+    }
+    log_event(EVENT_DISPATCH, cpu_id, pcb != NULL ? pcb->pid : EVENT_NO_PID,
+        0);
+    cpu->current = pcb;
+    cpu->state = pcb != NULL ? CPU_RUNNING : CPU_IDLE;
+    cpu->preemption_timer = preemption_time;
+    prof_mutex_unlock(&cpu->lock);
+}
 
-    context_switches++;
+extern void set_timer(unsigned int tick)
+{
+    unsigned int current = __atomic_load_n(&sim->timer, __ATOMIC_RELAXED);
 
-    IRWL_WRITER_UNLOCK(student_lock);
-    pthread_mutex_lock(&simulator_mutex);
-    simulator_cpu_data[cpu_id].current = pcb;
-    simulator_cpu_data[cpu_id].preemption_timer = preemption_time;
-    pthread_mutex_unlock(&simulator_mutex);
-    IRWL_WRITER_LOCK(student_lock);
+    while (tick < current &&
+        !__atomic_compare_exchange_n(&sim->timer, &current, tick, 0,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
 }
 
 extern void force_preempt(unsigned int cpu_id)
 {
-    assert(cpu_id < cpu_count);
+    simulator_cpu_data_t *cpu;
+
+    assert(cpu_id < sim->cpu_count);
 
-    IRWL_WRITER_UNLOCK(student_lock);
-    pthread_mutex_lock(&simulator_mutex);
+    cpu = &sim->simulator_cpu_data[cpu_id];
+    prof_mutex_lock(&cpu->lock);
 
     /*
      * It is possible that the student's code calls force_preempt() at the
      * same time the process was already going to yield or terminate.  We
      * check for that case by only preempting if the CPU is set to CPU_RUNNING.
      */
-    if (simulator_cpu_data[cpu_id].state == CPU_RUNNING)
-    {
-        simulator_cpu_data[cpu_id].state = CPU_PREEMPT;
-        pthread_cond_signal(&simulator_cpu_data[cpu_id].wakeup);
+    if (cpu->state == CPU_RUNNING)
+        raise_event(cpu, CPU_PREEMPT);
 
-        /* Ensure the scheduler gets run before the simulator */
-        pthread_cond_wait(&simulator_cpu_data[cpu_id].wakeup,
-            &simulator_mutex);
-    }
-
-    pthread_mutex_unlock(&simulator_mutex);
-    IRWL_WRITER_LOCK(student_lock);
+    prof_mutex_unlock(&cpu->lock);
 }
 
 
@@ -439,18 +869,45 @@ extern void force_preempt(unsigned int cpu_id)
  * simulate_io() simulates the I/O request at the head of the I/O queue and
  *   calls wake_up() upon completion.
  *
+ * sleep_until_release() puts a real-time task to sleep between jobs, and
+ *   simulate_releases() calls wake_up() for each task whose next job is due.
+ *
+ * simulate_timer() calls timer_expired() when the tick set_timer() asked for
+ *   comes.
+ *
  * simulate_creat() simulates initial process creation by calling the
- *   student's wake_up().
+ *   student's wake_up() for every process whose arrival time has come.
+ */
+
+/*
+ * raise_event() hands an event to a CPU running a process, then waits until
+ * the CPU thread has run the student's handler for it, so the scheduler runs
+ * before the simulator carries on.  Call with the CPU's lock held.
  */
+static void raise_event(simulator_cpu_data_t *cpu,
+                        simulator_cpu_state_t event)
+{
+    unsigned long raised = ++cpu->raised;
+
+    cpu->state = event;
+    pthread_cond_signal(&cpu->wakeup);
+    while (cpu->handled < raised)
+        prof_cond_wait(&cpu->scheduled, &cpu->lock);
+}
 
+/* CPUs with an event still being handled sit this tick out */
 static void simulate_cpus(void)
 {
     unsigned int n;
 
-    for (n=0; n<cpu_count; n++)
+    for (n=0; n<sim->cpu_count; n++)
     {
-        if (simulator_cpu_data[n].current != NULL)
-            simulate_process(n, simulator_cpu_data[n].current);
+        simulator_cpu_data_t *cpu = &sim->simulator_cpu_data[n];
+
+        prof_mutex_lock(&cpu->lock);
+        if (cpu->current != NULL && cpu->state == CPU_RUNNING)
+            simulate_process(n, cpu->current);
+        prof_mutex_unlock(&cpu->lock);
     }
 }
 
@@ -473,17 +930,13 @@ static void simulate_process(unsigned int cpu_id, pcb_t *pcb)
             /* Simulate running the process */
             pc->time--;
             pcb->time_remaining = pc->time + 1;
+            metrics_cpu_tick(&sim->metrics, cpu_id, pcb->pid);
             /* Simulate the preemption timer */
-            simulator_cpu_data[cpu_id].preemption_timer--;
-            if (simulator_cpu_data[cpu_id].preemption_timer == 0)
+            sim->simulator_cpu_data[cpu_id].preemption_timer--;
+            if (sim->simulator_cpu_data[cpu_id].preemption_timer == 0)
             {
                 /* The timer has expired; preempt the running process */
-                simulator_cpu_data[cpu_id].state = CPU_PREEMPT;
-                pthread_cond_signal(&simulator_cpu_data[cpu_id].wakeup);
-
-                /* Ensure the scheduler gets run before the simulator */
-                pthread_cond_wait(&simulator_cpu_data[cpu_id].wakeup,
-                    &simulator_mutex);
+                raise_event(&sim->simulator_cpu_data[cpu_id], CPU_PREEMPT);
             }
         }
         else
@@ -492,34 +945,34 @@ static void simulate_process(unsigned int cpu_id, pcb_t *pcb)
             pcb->pc=((op_t*)(pcb->pc))+1;
             pc++;
             pcb->time_remaining = pcb->pc->time + 1;
+
+            /* For a real-time task the burst was a job, done this tick */
+            if (rt_is_task(pcb))
+                metrics_job(&sim->metrics, pcb->pid, sim->simulator_time + 1,
+                    pcb->job_deadline);
+
             switch (pc->type)
             {
             case OP_IO:
-                /* Put a request in the I/O FIFO queue */
-                submit_io_request(pcb, pc->time);
+                /* Put a request in the device's I/O queue */
+                log_event(EVENT_IO_START, cpu_id, pcb->pid,
+                    submit_io_request(pcb, pc));
 
                 /* Generate a yield() call on the appropriate CPU */
-                simulator_cpu_data[cpu_id].state = CPU_YIELD;
-                pthread_cond_signal(&simulator_cpu_data[cpu_id].wakeup);
-
-                /* Ensure the scheduler gets run before the simulator */
-                pthread_cond_wait(&simulator_cpu_data[cpu_id].wakeup,
-                    &simulator_mutex);
+                raise_event(&sim->simulator_cpu_data[cpu_id], CPU_YIELD);
 
                 break;
 
             case OP_TERMINATE:
                 /* Generate a terminate() call on the appropriate CPU */
-                simulator_cpu_data[cpu_id].state = CPU_TERMINATE;
-                pthread_cond_signal(&simulator_cpu_data[cpu_id].wakeup);
-
-                /* Ensure the scheduler gets run before the simulator */
-                pthread_cond_wait(&simulator_cpu_data[cpu_id].wakeup,
-                    &simulator_mutex);
+                raise_event(&sim->simulator_cpu_data[cpu_id], CPU_TERMINATE);
 
                 break;
 
             case OP_CPU:
+                /* Only real-time tasks have back-to-back CPU bursts */
+                if (rt_is_task(pcb))
+                    sleep_until_release(cpu_id, pcb);
                 break;
             }
         }
@@ -537,91 +990,349 @@ static void simulate_process(unsigned int cpu_id, pcb_t *pcb)
     }
 }
 
-static void submit_io_request(pcb_t *pcb, unsigned int execution_time)
+/* Returns the device the request went to */
+static unsigned int submit_io_request(pcb_t *pcb, const op_t *op)
 {
+    unsigned int device;
+    io_device_t *dev;
     io_request *r;
 
     /* Build I/O Request */
     r = malloc(sizeof(io_request));
     assert(r != NULL);
     r->pcb = pcb;
-    r->execution_time = execution_time;
+    r->execution_time = op->time;
+    r->submitted = sim->simulator_time;
     r->next = NULL;
+    sim->io_count++;
 
-    /* Add request to head of queue */
-    if (io_queue_tail != NULL)
+    if (op->device != IO_DEVICE_ANY)
+        device = (op->device - 1) % sim->io_device_count;
+    else
+        device = pcb->pid % sim->io_device_count;
+    dev = &sim->io_devices[device];
+
+    /* Add request to tail of queue */
+    if (dev->tail != NULL)
     {
-        io_queue_tail->next = r;
-        io_queue_tail = r;
+        dev->tail->next = r;
+        dev->tail = r;
     }
     else
     {
-        io_queue_head = r;
-        io_queue_tail = r;
+        dev->head = r;
+        dev->tail = r;
+    }
+    return device;
+}
+
+/*
+ * io_next() unlinks the request a device should serve next under io_policy.
+ * The queue is kept in submission order, so the head is the oldest request.
+ */
+static io_request *io_next(io_device_t *dev)
+{
+    io_request *r, *prev, *best = dev->head, *best_prev = NULL;
+
+    if (dev->head == NULL)
+        return NULL;
+
+    if (sim->io_policy == IO_SJF || (sim->io_policy == IO_DEADLINE &&
+        sim->simulator_time - dev->head->submitted < sim->io_deadline))
+    {
+        for (prev = dev->head, r = prev->next; r != NULL;
+             prev = r, r = r->next)
+        {
+            if (r->execution_time < best->execution_time)
+            {
+                best = r;
+                best_prev = prev;
+            }
+        }
     }
+
+    if (best_prev != NULL)
+        best_prev->next = best->next;
+    else
+        dev->head = best->next;
+    if (dev->tail == best)
+        dev->tail = best_prev;
+    best->next = NULL;
+    return best;
 }
 
 static void simulate_io(void)
 {
-    if (io_queue_head == NULL)
-        return; /* There are no I/O requests */
+    unsigned int n, completed_count = 0;
 
-    if (io_queue_head->execution_time-- <= 0)
+    for (n=0; n<sim->io_device_count; n++)
     {
-        io_request *completed = io_queue_head;
-        pcb_t *pcb;
+        io_device_t *dev = &sim->io_devices[n];
+        io_request *completed;
+
+        if (dev->active == NULL)
+        {
+            if ((dev->active = io_next(dev)) == NULL)
+                continue; /* There are no I/O requests */
+            dev->queue_wait += sim->simulator_time - dev->active->submitted;
+        }
+
+        dev->busy++;
+        if (dev->active->execution_time-- > 0)
+            continue;
 
         /* Move the programs "PC" to the next "instruction" */
+        completed = dev->active;
         completed->pcb->pc = ((op_t*)completed->pcb->pc) + 1;
         completed->pcb->time_remaining = completed->pcb->pc->time + 1;
 
         /*
-         * Remove the I/O request from the queue before calling the student's
-         * code.  We must do this, because once we release the simulator_mutex,
-         * the I/O queue may have changed.
+         * Remove the I/O request from the device before calling the student's
+         * code, so the process is off the I/O queues by the time wake_up()
+         * makes it runnable again.
          */
-        pcb = completed->pcb;
-        io_queue_head = completed->next;
-        if (io_queue_head == NULL)
-            io_queue_tail = NULL;
+        sim->io_completed[completed_count++] = completed->pcb;
+        metrics_ready(&sim->metrics, completed->pcb->pid, sim->simulator_time);
+        log_event(EVENT_WAKEUP, 0, completed->pcb->pid, n);
+        dev->active = NULL;
+        dev->served++;
         free(completed);
+        sim->io_count--;
+    }
+
+    if (completed_count == 0)
+        return;
+
+    /* Call the student's wake_up() handler */
+    for (n=0; n<completed_count; n++)
+        wake_up(sim->io_completed[n]);
+}
 
-        /* Call the student's wake_up() handler */
-        pthread_mutex_unlock(&simulator_mutex);
-        IRWL_WRITER_LOCK(student_lock);
+/*
+ * Even a job released right away goes through a yield and a wake_up(), so the
+ * scheduler sees each job's deadline while the task is off its queues.
+ */
+static void sleep_until_release(unsigned int cpu_id, pcb_t *pcb)
+{
+    unsigned int pid = pcb->pid;
+
+    sim->jobs[pid]++;
+    sim->release[pid] = rt_next_release(pcb, sim->release[pid],
+        sim->jobs[pid]);
+    heap_push(&sim->sleepers, pid);
+    sim->sleep_count++;
+    log_event(EVENT_SLEEP, cpu_id, pid, 0);
+    raise_event(&sim->simulator_cpu_data[cpu_id], CPU_YIELD);
+}
+
+static void simulate_releases(void)
+{
+    unsigned int pid;
+
+    if (sim->release == NULL)
+        return;
+    while ((pid = heap_top(&sim->sleepers)) != HEAP_NONE &&
+        sim->release[pid] <= sim->simulator_time)
+    {
+        pcb_t *pcb = &sim->processes[pid];
+
+        heap_pop(&sim->sleepers);
+        sim->sleep_count--;
+        pcb->job_deadline = sim->release[pid] + rt_deadline(pcb);
+        metrics_ready(&sim->metrics, pid, sim->simulator_time);
+        log_event(EVENT_RELEASE, 0, pid, 0);
+
+        /* Call student's wake_up() handler */
         wake_up(pcb);
-        IRWL_WRITER_UNLOCK(student_lock);
-        pthread_mutex_lock(&simulator_mutex);
     }
 }
 
-static void simulate_creat(void)
+/* splitmix64, the same generator the workload generator uses */
+static uint64_t rng_next(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/*
+ * In deterministic mode idle CPUs look for work only here, once a tick and
+ * one at a time, in an order shuffled by the seed.  It stops once nothing is
+ * left ready.
+ */
+static void dispatch_idle(void)
 {
-    static int processes_created = 0;
+    unsigned int n, idle = 0;
+
+    for (n=0; n<sim->cpu_count; n++)
+        if (sim->simulator_cpu_data[n].current == NULL)
+            sim->idle_order[idle++] = n;
 
-    if ((simulator_time % 10) == 0 && processes_created < PROCESS_COUNT)
+    /* Fisher-Yates */
+    for (n=idle; n>1; n--)
     {
-        /* Call student's wake_up() handler */
-        pthread_mutex_unlock(&simulator_mutex);
-        IRWL_WRITER_LOCK(student_lock);
-        wake_up(&processes[processes_created]);
-        IRWL_WRITER_UNLOCK(student_lock);
-        pthread_mutex_lock(&simulator_mutex);
+        unsigned int k = (unsigned int)(rng_next(&sim->rng) % n);
+        unsigned int tmp = sim->idle_order[k];
+        sim->idle_order[k] = sim->idle_order[n - 1];
+        sim->idle_order[n - 1] = tmp;
+    }
+
+    for (n=0; n<idle; n++)
+    {
+        simulator_cpu_data_t *cpu =
+            &sim->simulator_cpu_data[sim->idle_order[n]];
+
+        if (sim->processes_created -
+            __atomic_load_n(&sim->processes_terminated, __ATOMIC_RELAXED) -
+            __atomic_load_n(&sim->running_count, __ATOMIC_RELAXED) -
+            sim->io_count - sim->sleep_count == 0)
+            break;
+        prof_mutex_lock(&cpu->lock);
+        raise_event(cpu, CPU_IDLE);
+        prof_mutex_unlock(&cpu->lock);
+    }
+}
+
+static void simulate_timer(void)
+{
+    unsigned int tick = __atomic_load_n(&sim->timer, __ATOMIC_ACQUIRE);
+
+    /* A set_timer() racing with this exchange simply fires next tick */
+    if (tick > sim->simulator_time ||
+        !__atomic_compare_exchange_n(&sim->timer, &tick, NO_TIMER, 0,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return;
+
+    /* Call student's timer_expired() handler */
+    timer_expired();
+}
+
+/* Sleeping tasks in order of release, then PID */
+static int release_less(unsigned int a, unsigned int b)
+{
+    if (sim->release[a] != sim->release[b])
+        return sim->release[a] < sim->release[b];
+    return a < b;
+}
+
+static void simulate_creat(void)
+{
+    /* The process table is sorted by arrival time */
+    while (sim->processes_created < sim->process_count &&
+        sim->processes[sim->processes_created].arrival <= sim->simulator_time)
+    {
+        pcb_t *pcb = &sim->processes[sim->processes_created];
+
+        /* Count it first, since wake_up() makes it visible as READY */
+        sim->processes_created++;
+        metrics_arrive(&sim->metrics, pcb->pid, sim->simulator_time);
+        if (rt_is_task(pcb))
+        {
+            /* The first job is released on arrival */
+            pcb->wcet = rt_wcet(pcb->pc);
+            pcb->job_deadline = sim->simulator_time + rt_deadline(pcb);
+            sim->release[pcb->pid] = sim->simulator_time;
+        }
+        log_event(EVENT_CREATE, 0, pcb->pid, 0);
 
-        processes_created++;
+        /* Call student's wake_up() handler */
+        wake_up(pcb);
     }
 }
 
 
 
-/* Cheap hack -- passing an int through a void pointer */
+/* A CPU thread is handed its own entry in its instance's CPU table */
 static void *simulator_cpu_thread_func(void *data)
 {
-    simulator_cpu_thread((unsigned int)(uintptr_t)data);
+    simulator_cpu_data_t *cpu = data;
+
+    sim = cpu->owner;
+    simulator_cpu_thread((unsigned int)(cpu - sim->simulator_cpu_data));
     return NULL;
 }
 
 
+extern unsigned int get_simulator_time(void)
+{
+    return __atomic_load_n(&sim->simulator_time, __ATOMIC_RELAXED);
+}
+
+
+extern void *simulator_scheduler(void)
+{
+    return sim->scheduler;
+}
+
+
+extern void simulator_config_default(simulator_config_t *config)
+{
+    config->cpu_count = 1;
+    config->io_devices = 1;
+    config->io_policy = IO_FIFO;
+    config->io_deadline = 20;
+    config->headless = 0;
+    config->quiet = 0;
+    config->csv_path = NULL;
+    config->event_log_path = NULL;
+    config->lock_profile = 0;
+    topology_default(&config->topology);
+    config->deterministic = 0;
+    config->seed = 1;
+    config->replay_path = NULL;
+}
+
+
+extern int simulator_parse_io(simulator_config_t *config, const char *spec)
+{
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+
+    assert(copy != NULL);
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save))
+    {
+        char *value = strchr(tok, '=');
+        unsigned long n;
+
+        if (value == NULL)
+        {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        if (strcmp(tok, "policy") == 0)
+        {
+            if (strcmp(value, "fifo") == 0)
+                config->io_policy = IO_FIFO;
+            else if (strcmp(value, "sjf") == 0)
+                config->io_policy = IO_SJF;
+            else if (strcmp(value, "deadline") == 0)
+                config->io_policy = IO_DEADLINE;
+            else
+                ret = -1;
+            continue;
+        }
+
+        n = strtoul(value, &end, 10);
+        if (*end != '\0' || end == value)
+            ret = -1;
+        else if (strcmp(tok, "devices") == 0 && n >= 1 && n <= MAX_IO_DEVICES)
+            config->io_devices = (unsigned int) n;
+        else if (strcmp(tok, "deadline") == 0 && n >= 1)
+            config->io_deadline = (unsigned int) n;
+        else
+            ret = -1;
+    }
+
+    if (ret != 0)
+        fprintf(stderr, "Bad I/O spec '%s'\n", spec);
+    free(copy);
+    return ret;
+}
+
+
 /* mt_safe_usleep() emulates the usleep() function, but is thread-safe */
 extern void mt_safe_usleep(long usec)
 {
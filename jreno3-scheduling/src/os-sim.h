@@ -3,13 +3,26 @@
  * Multithreaded OS Simulation for CS 2200
  *
  * The simulator library.
- *
- * YOU WILL NOT NEED TO MODIFY THIS FILE
  */
 
 #ifndef __OS_SIM_H__
 #define __OS_SIM_H__
 
+#include "metrics.h"
+#include "topology.h"
+
+
+/*
+ * Simulator limits.  The CPU and process tables are sized at runtime; these
+ * only bound what simulator_run() will accept.
+ */
+#define MAX_CPU_COUNT 1024
+#define MAX_PROCESS_COUNT 1000000
+#define MAX_IO_DEVICES 256
+
+/* Per-CPU data is padded to this size so CPU threads don't false-share. */
+#define CACHE_LINE_SIZE 64
+
 
 /*
  * The process_state_t enum contains the possible states for a process.
@@ -43,12 +56,49 @@ typedef enum {
  *
  *   next : An unused pointer to another PCB.  You may use this pointer to
  *        build a linked-list of PCBs.
+ *
+ *   arrival : The tick at which the simulator creates the process. (read-only)
+ *
+ *   priority : Static priority from the workload; lower is more important.
+ *
+ *   affinity : The CPU the process prefers to run on, or -1 for any CPU.
+ *
+ *   nice : Nice value from -20 to 19, weighting the process's CPU share under
+ *        the completely fair scheduler.
+ *
+ *   last_cpu : The CPU the process last ran on, or -1.  Maintained by the
+ *        scheduler.
+ *
+ *   period, deadline, jitter : For a real-time task (realtime.h), the ticks
+ *        between job releases, each job's relative deadline (0 for the
+ *        period) and, for a sporadic task, the most extra delay between
+ *        releases.  A period of 0 makes an ordinary process.
+ *
+ *   wcet : A real-time task's worst-case ticks per job, set by the simulator
+ *        when the process arrives. (read-only)
+ *
+ *   job_deadline : The absolute deadline of the task's current job, set by
+ *        the simulator when the job is released. (read-only)
+ *
+ *   group : The control group the process belongs to (cgroup.h), 0 for the
+ *        root group.
+ *
+ *   gang : Processes with the same nonzero gang are the threads of one
+ *        parallel job, which gang scheduling runs on as many CPUs at once.
+ *        0 for a single-threaded process.
  */
 typedef enum { OP_CPU = 0, OP_IO, OP_TERMINATE } op_type;
 
+/*
+ * An operation in a process's program.  For OP_IO, device is the I/O device
+ * to use plus one; IO_DEVICE_ANY (0) lets the simulator pick one by PID.
+ */
+#define IO_DEVICE_ANY 0
+
 typedef struct {
     op_type type;
     unsigned int time;
+    unsigned int device;
 } op_t;
 
 
@@ -59,14 +109,115 @@ typedef struct _pcb_t {
     process_state_t state;
     op_t *pc;
     struct _pcb_t *next;
+    unsigned int arrival;
+    int priority;
+    int affinity;
+    int last_cpu;
+    int nice;
+    unsigned int period;
+    unsigned int deadline;
+    unsigned int jitter;
+    unsigned int wcet;
+    unsigned int job_deadline;
+    unsigned int group;
+    unsigned int gang;
 } pcb_t;
 
 
 /*
- * start_simulator() runs the OS simulation.  The number of CPUs (1-16) should
- * be passed as the parameter.
+ * Simulator settings.
+ *
+ *   cpu_count : number of CPUs, 1 to MAX_CPU_COUNT
+ *   io_devices, io_policy, io_deadline : the I/O subsystem; see
+ *        simulator_parse_io()
+ *   headless : no Gantt chart and no pause between ticks, so a run goes as
+ *        fast as the scheduler allows
+ *   quiet : headless, and no final statistics either
+ *   csv_path : if set, per-process metrics are written here as CSV
+ *   event_log_path : if set, scheduling events are logged here (eventlog.h)
+ *   lock_profile : measure the simulator's locks and report their contention
+ *        with the final statistics (lockprof.h)
+ *   topology : CPU nodes and cache domains, and the migration penalties the
+ *        simulator charges (topology.h)
+ *   deterministic, seed : run the scheduler's handlers one at a time in an
+ *        order fixed by seed, so that runs with the same seed, workload and
+ *        scheduler make exactly the same decisions.  Idle CPUs then look for
+ *        work once per tick, in a seeded order, rather than as soon as it
+ *        arrives; the scheduler's idle() must not block (scheduler_config_t)
+ *   replay_path : if set, check the run against this event log, recorded in
+ *        deterministic mode, and fail if it diverges.  Implies deterministic
+ *        mode with the recorded seed.
  */
-extern void start_simulator(unsigned int cpu_count);
+typedef enum { IO_FIFO = 0, IO_SJF, IO_DEADLINE } io_policy_t;
+
+typedef struct {
+    unsigned int cpu_count;
+    unsigned int io_devices;
+    io_policy_t io_policy;
+    unsigned int io_deadline;
+    int headless;
+    int quiet;
+    const char *csv_path;
+    const char *event_log_path;
+    int lock_profile;
+    topology_t topology;
+    int deterministic;
+    unsigned long seed;
+    const char *replay_path;
+} simulator_config_t;
+
+/* What a run measured.  Times are in ticks, summed over every tick. */
+typedef struct {
+    unsigned int context_switches;
+    unsigned int total_time;
+    unsigned long long ready_time;
+    unsigned long long running_time;
+    unsigned long long waiting_time;
+    metrics_summary_t metrics;
+} simulator_results_t;
+
+typedef struct simulator simulator_t;
+
+
+/* simulator_config_default() fills config with one CPU and one FIFO device */
+extern void simulator_config_default(simulator_config_t *config);
+
+
+/*
+ * simulator_parse_io() configures the I/O subsystem from a spec such as
+ * "devices=4,policy=sjf,deadline=20".  Each device serves one request at a
+ * time from its own queue, picking the next request by policy:
+ *
+ *   fifo : in order of submission (the default)
+ *   sjf : shortest request first
+ *   deadline : shortest request first, unless the oldest request has waited
+ *        deadline ticks or more, in which case it goes next
+ *
+ * Requests for device d go to device d % devices.  Returns -1 on a bad spec.
+ */
+extern int simulator_parse_io(simulator_config_t *config, const char *spec);
+
+
+/*
+ * simulator_run() runs one OS simulation of the count PCBs in table, which
+ * it consumes, and returns once every process has terminated.  scheduler is
+ * handed back to the student's code by simulator_scheduler().  If results is
+ * non-NULL it receives the run's measurements.  Returns -1 if the run could
+ * not start or its output could not be written.
+ *
+ * Each call is a self-contained instance with its own CPU threads, so
+ * several may run at once on different threads.
+ */
+extern int simulator_run(const simulator_config_t *config, pcb_t *table,
+                         unsigned int count, void *scheduler,
+                         simulator_results_t *results);
+
+
+/*
+ * simulator_scheduler() returns the scheduler passed to simulator_run() for
+ * the simulation the calling thread belongs to.
+ */
+extern void *simulator_scheduler(void);
 
 
 /*
@@ -84,6 +235,15 @@ extern void context_switch(unsigned int cpu_id, pcb_t *pcb,
                            int preemption_time);
 
 
+/*
+ * set_timer() asks the simulator to call the student's timer_expired() once
+ * the simulated time reaches tick, from the same thread that calls
+ * wake_up().  Only the earliest pending request is kept, and a request for a
+ * tick already past fires on the next tick.
+ */
+extern void set_timer(unsigned int tick);
+
+
 /*
  * force_preempt() preempts a running process before its timeslice expires.
  * It should be used by the SRTF scheduler to preempt lower
@@ -92,6 +252,12 @@ extern void context_switch(unsigned int cpu_id, pcb_t *pcb,
 extern void force_preempt(unsigned int cpu_id);
 
 
+/*
+ * get_simulator_time() returns the current simulated time in ticks.
+ */
+extern unsigned int get_simulator_time(void);
+
+
 /*
  * mt_safe_usleep() is a thread-safe implementation of the usleep() function.
  * See man usleep(3) for the behavior of this function.
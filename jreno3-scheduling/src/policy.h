@@ -0,0 +1,304 @@
+/*
+ * policy.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The scheduler's internal state, shared by student.c and the policy modules
+ * (mlfq.c, cfs.c, share.c and gang.c), and the table of hooks through which
+ * student.c runs whichever policy was chosen.
+ */
+
+#ifndef __POLICY_H__
+#define __POLICY_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "cfs.h"
+#include "cgroup.h"
+#include "gang.h"
+#include "heap.h"
+#include "lockprof.h"
+#include "mlfq.h"
+#include "os-sim.h"
+#include "queue.h"
+#include "share.h"
+#include "student.h"
+#include "topology.h"
+
+/*
+ * A run queue.  FIFO and round robin use queue.  SRTF, PRIORITY, EDF,
+ * RATE_MONOTONIC and STRIDE use heap, a min-heap of PIDs ordered by
+ * runs_before().  MLFQ, CFS, LOTTERY and STRIDE keep their own state in the
+ * member named for them.  size mirrors the number of queued processes so
+ * other CPUs can peek at it without taking the lock.  Idle CPUs sleep on
+ * wakeup.
+ *
+ * By default all CPUs share runqueues[0].  With -P every CPU has its own run
+ * queue and its own wakeup, and an idle CPU steals from the others.
+ */
+typedef struct {
+    prof_mutex_t lock;
+    pthread_cond_t wakeup;
+    pcb_queue_t queue;
+    heap_t heap;
+    mlfq_rq_t mlfq;
+    cfs_rq_t cfs;
+    share_rq_t share;
+    unsigned int size;
+} __attribute__((aligned(CACHE_LINE_SIZE))) runqueue_t;
+
+/*
+ * Per-CPU scheduler state.  idle and idle_pos place the CPU on the idle
+ * stack (protected by idle_lock).  current is the process running on the
+ * CPU; it and the counters are only written by the CPU's own thread, and
+ * other CPUs only read current under running_lock.  GANG is the exception:
+ * it dispatches onto any CPU, so there current, slot (the job the CPU is
+ * reserved for, or -1) and migrations are protected by runqueues[0].lock.
+ */
+typedef struct {
+    pcb_t *current;
+    int idle;
+    unsigned int idle_pos;
+    int forced;
+    int slot;
+    long reserved;
+    int budget_limited;
+    unsigned long steals;
+    unsigned long migrations;
+    unsigned long quanta;
+    unsigned long long quantum_sum;
+    unsigned long bursts;
+    double estimate_error;
+} __attribute__((aligned(CACHE_LINE_SIZE))) cpu_info_t;
+
+/*
+ * Scheduler-private per-process state, indexed by PID.
+ *
+ *   seq : enqueue order, so equal priorities run first-come first-served
+ *   dispatched : the tick the process last went on a CPU
+ *   started, waking : CFS and STRIDE placement flags: whether the process
+ *        has been queued before, and whether it is coming back from I/O
+ *   rt : for real-time tasks under EDF and RATE_MONOTONIC, whether admission
+ *        control let it in (see admit())
+ *   estimate, burst_ran : with -a, the expected length of the process's next
+ *        CPU burst in ticks, and how much of the current one it has run
+ *   mlfq, cfs, share : the policies' own state, see their headers
+ *   job : for GANG, the index of the process's job in gang.jobs[]
+ */
+typedef enum { RT_UNSEEN = 0, RT_ADMITTED, RT_REJECTED } rt_admission_t;
+
+typedef struct {
+    unsigned long seq;
+    unsigned int dispatched;
+    int started;
+    int waking;
+    rt_admission_t rt;
+    double estimate;
+    unsigned int burst_ran;
+    mlfq_proc_t mlfq;
+    cfs_proc_t cfs;
+    share_proc_t share;
+    unsigned int job;
+} proc_info_t;
+
+/*
+ * Per-control-group state, indexed like the groups in cgroup_tree_t.
+ *
+ *   runtime : quota left in the current period; negative if it overran
+ *   period_end : when the current period ends
+ *   throttled, throttled_at : whether the group has run out, and since when
+ *   load : CFS weight runnable directly in the group: its processes' weights
+ *        plus the shares of child groups with anything runnable
+ *   parked : processes waiting for the group's next period
+ *   usage, throttles, throttled_time : CPU ticks used by the group and its
+ *        children, times it ran out, and ticks spent out
+ */
+typedef struct {
+    long runtime;
+    unsigned int period_end;
+    int throttled;
+    unsigned int throttled_at;
+    unsigned long load;
+    pcb_queue_t parked;
+    unsigned long long usage;
+    unsigned long throttles;
+    unsigned long long throttled_time;
+} group_state_t;
+
+/*
+ * A scheduling policy.  scheduler_create() picks one by algorithm, and the
+ * handlers call through it wherever policies differ.  Any hook may be NULL,
+ * meaning the policy has nothing to do there.
+ *
+ *   preemptive : a waking process may preempt a running one, by runs_before()
+ *   uses_heap : the run queue is heap, ordered by runs_before()
+ *   create, destroy : set up the policy's state from config once the
+ *        scheduler's own is in place, and release it
+ *   rq_init, rq_free : the same for run queue number index
+ *   push, pop : queue a process and pick the next one, with rq->lock held;
+ *        the caller keeps seq and size
+ *   runs_before : the policy's order, replacing the one in runs_before()
+ *   quantum : the slice for a process about to be dispatched on cpu_id, in
+ *        place of time_slice
+ *   pick : called by schedule() before it looks for a process
+ *   leave : pcb is coming off cpu_id as state, READY for a preemption
+ *   wake : pcb is becoming runnable on wake_up()
+ *   migrate : pcb was stolen from one run queue for another
+ *   print_stats : the policy's part of print_scheduler_stats()
+ *
+ * A policy that places processes on CPUs itself (GANG) sets place_leave and
+ * place_wake.  preempt(), yield() and terminate() then hand place_leave()
+ * everything, wake_up() does the same with place_wake(), and idle CPUs only
+ * wait to be dispatched onto.
+ */
+typedef struct sched_policy {
+    int preemptive;
+    int uses_heap;
+    void (*create)(const scheduler_config_t *config);
+    void (*destroy)(scheduler_t *s);
+    void (*rq_init)(runqueue_t *rq, unsigned int index);
+    void (*rq_free)(runqueue_t *rq);
+    void (*push)(runqueue_t *rq, pcb_t *pcb);
+    pcb_t *(*pop)(runqueue_t *rq);
+    int (*runs_before)(const pcb_t *a, const pcb_t *b);
+    int (*quantum)(unsigned int cpu_id, const pcb_t *pcb);
+    void (*pick)(void);
+    void (*leave)(unsigned int cpu_id, pcb_t *pcb, process_state_t state);
+    void (*wake)(pcb_t *pcb);
+    void (*migrate)(pcb_t *pcb, const runqueue_t *from, const runqueue_t *to);
+    void (*print_stats)(void);
+    void (*place_leave)(unsigned int cpu_id, process_state_t state);
+    void (*place_wake)(pcb_t *pcb);
+} sched_policy_t;
+
+/*
+ * A scheduler instance, one per simulation.  The handlers find theirs through
+ * sched, which each of them points at simulator_scheduler() on entry, so
+ * everything they call can use it.
+ */
+struct scheduler {
+    /* Settings, from scheduler_config_t */
+    algorithm_t algorithm;
+    int time_slice;
+    int per_cpu;
+    int lock_free;
+
+    /* The policy for algorithm, and its state */
+    const sched_policy_t *policy;
+    mlfq_sched_t mlfq;
+    cfs_sched_t cfs;
+    share_sched_t share;
+    gang_sched_t gang;
+
+    /*
+     * EDF (-D) and RATE_MONOTONIC (-R).  Admitted real-time tasks run ahead
+     * of everything else, by job deadline or by period.  rt_density and
+     * rt_max are the total and largest density admitted, and rt_tasks the
+     * number of admitted tasks still alive (all protected by rt_lock).  A
+     * rejected task runs behind them with the ordinary processes.
+     */
+    double rt_density;
+    double rt_max;
+    unsigned int rt_tasks;
+    unsigned long rt_admitted;
+    unsigned long rt_rejected;
+    prof_mutex_t rt_lock;
+
+    unsigned int cpu_count;
+    pcb_t *processes;
+    unsigned int process_count;
+
+    proc_info_t *info;
+    unsigned long enqueue_seq;
+
+    runqueue_t *runqueues;
+    unsigned int *heap_pos;
+    cpu_info_t *cpus;
+
+    /*
+     * Idle CPUs in per-CPU mode.  enqueue() hands new work straight to one of
+     * these and signals only that CPU.
+     */
+    unsigned int *idle_stack;
+    unsigned int idle_count;
+    prof_mutex_t idle_lock;
+
+    /*
+     * With -L, FIFO and round robin on the shared run queue use the lock-free
+     * ready_ring instead, and the run queue's lock and wakeup are only used
+     * to put idle CPUs to sleep; idle_waiters counts the sleepers so
+     * enqueue() can skip the lock when nobody is waiting.
+     */
+    pcb_mpmc_t ready_ring;
+    unsigned int idle_waiters;
+
+    /*
+     * Preemptive algorithms also keep running CPUs in running_heap, with the
+     * CPU whose process runs_before() ranks last on top (protected by
+     * running_lock, which other algorithms never take).  For SRTF, every
+     * running process loses one tick of time_remaining per tick, so
+     * running_heap stays ordered without being touched between dispatches.
+     */
+    heap_t running_heap;
+    prof_mutex_t running_lock;
+
+    /* Profile the locks above (-k) */
+    int lock_profile;
+
+    /*
+     * With -T and per-CPU queues, placement and stealing prefer nearby CPUs
+     * and wake-ups spill over to other queues when the hinted one is long.
+     */
+    topology_t topology;
+
+    /*
+     * In deterministic mode the simulator calls idle() once per tick while a
+     * CPU has nothing to run, so idle() just tries to schedule.
+     */
+    int deterministic;
+
+    /*
+     * Control groups (-G), with group_state protected by group_lock.  With
+     * quotas (bandwidth), a process is dispatched with a slice reserved from
+     * every limited group above it, which cpus[].reserved remembers, and the
+     * unused part is handed back when it stops.  A process whose group has
+     * run out is parked in the group until timer_expired() starts its next
+     * period.  CFS divides the CPU between sibling groups by their shares.
+     */
+    cgroup_tree_t groups;
+    group_state_t *group_state;
+    int bandwidth;
+    prof_mutex_t group_lock;
+
+    /*
+     * Burst estimation (-a) for round robin and SRTF, see
+     * scheduler_parse_adaptive().  The per-CPU quanta and bursts counters
+     * report how well it did.
+     */
+    int adaptive;
+    double adapt_alpha;
+    unsigned int adapt_initial;
+    unsigned int adapt_min;
+    unsigned int adapt_max;
+    unsigned int adapt_response;
+
+    /* State for random_cpu() */
+    uint64_t rng;
+
+    /* Set by stop_idle() */
+    int stopping;
+};
+
+extern __thread scheduler_t *sched;
+
+/* The run queue cpu_id takes work from, and its size without the lock */
+extern runqueue_t *rq_of(unsigned int cpu_id);
+extern unsigned int rq_size(runqueue_t *rq);
+
+/* pcb's control group, the root if its group is not defined */
+extern unsigned int group_of(const pcb_t *pcb);
+
+/* Charges pcb's control groups for its run on cpu_id, see student.c */
+extern void group_charge(unsigned int cpu_id, const pcb_t *pcb);
+
+#endif /* __POLICY_H__ */
@@ -7,7 +7,9 @@
 
 #include "os-sim.h"
 #include "process.h"
+#include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*
  * Note: The operations must alternate: OP_CPU, OP_IO, OP_CPU, ...
@@ -16,222 +18,306 @@
  */
 
 static op_t pid0_ops[] = {
-    { OP_CPU, 2 },
-    { OP_IO, 2 },
-    { OP_CPU, 3 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 2 },
-    { OP_CPU, 3 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 2 },
-    { OP_CPU, 3 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 2 },
-    { OP_CPU, 3 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid1_ops[] = {
-    { OP_CPU, 3 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 6 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 4 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 6 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 4 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 6 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 4 },
-    { OP_IO, 3 },
-    { OP_CPU, 4 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 6 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 4 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 6, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 4, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 6, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 4, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 6, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 4, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 4, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 6, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 4, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid2_ops[] = {
-    { OP_CPU, 1 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 3 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 3 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 3 },
-    { OP_IO, 4 },
-    { OP_CPU, 2 },
-    { OP_IO, 5 },
-    { OP_CPU, 1 },
-    { OP_IO, 3 },
-    { OP_CPU, 3 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_IO, 4, IO_DEVICE_ANY },
+    { OP_CPU, 2, IO_DEVICE_ANY },
+    { OP_IO, 5, IO_DEVICE_ANY },
+    { OP_CPU, 1, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 3, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid3_ops[] = {
-    { OP_CPU, 9 },
-    { OP_IO, 1 },
-    { OP_CPU, 6 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_IO, 1 },
-    { OP_CPU, 7 },
-    { OP_IO, 1 },
-    { OP_CPU, 6 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_IO, 1 },
-    { OP_CPU, 7 },
-    { OP_IO, 1 },
-    { OP_CPU, 6 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 6, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 6, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 6, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid4_ops[] = {
-    { OP_CPU, 10 }, 
-    { OP_IO, 1 },
-    { OP_CPU, 14 },
-    { OP_IO, 1 },
-    { OP_CPU, 7 },
-    { OP_IO, 2 },
-    { OP_CPU, 11 },
-    { OP_IO, 1 },
-    { OP_CPU, 14 },
-    { OP_IO, 1 },
-    { OP_CPU, 7 },
-    { OP_IO, 2 },
-    { OP_CPU, 11 },
-    { OP_IO, 1 },
-    { OP_CPU, 14 },
-    { OP_IO, 1 },
-    { OP_CPU, 7 },
-    { OP_IO, 2 },
-    { OP_CPU, 11 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 10, IO_DEVICE_ANY }, 
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 14, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 11, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 14, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 11, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 14, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 11, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid5_ops[] = {
-    { OP_CPU, 9 }, 
-    { OP_IO, 1 },
-    { OP_CPU, 10 },
-    { OP_IO, 2 },
-    { OP_CPU, 15 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_IO, 1 },
-    { OP_CPU, 10 },
-    { OP_IO, 2 },
-    { OP_CPU, 15 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_IO, 1 },
-    { OP_CPU, 10 },
-    { OP_IO, 2 },
-    { OP_CPU, 15 },
-    { OP_IO, 1 },
-    { OP_CPU, 8 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 9, IO_DEVICE_ANY }, 
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 10, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 15, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 10, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 15, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 10, IO_DEVICE_ANY },
+    { OP_IO, 2, IO_DEVICE_ANY },
+    { OP_CPU, 15, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 8, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid6_ops[] = {
-    { OP_CPU, 6 }, 
-    { OP_IO, 3 },
-    { OP_CPU, 9 },
-    { OP_IO, 1 },
-    { OP_CPU, 14 },
-    { OP_IO, 1 },
-    { OP_CPU, 11 },
-    { OP_IO, 3 },
-    { OP_CPU, 9 },
-    { OP_IO, 1 },
-    { OP_CPU, 14 },
-    { OP_IO, 1 },
-    { OP_CPU, 11 },
-    { OP_IO, 3 },
-    { OP_CPU, 9 },
-    { OP_IO, 1 },
-    { OP_CPU, 14 },
-    { OP_IO, 1 },
-    { OP_CPU, 11 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 6, IO_DEVICE_ANY }, 
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 14, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 11, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 14, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 11, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 14, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 11, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
 static op_t pid7_ops[] = {
-    { OP_CPU, 6 }, 
-    { OP_IO, 3 },
-    { OP_CPU, 12 },
-    { OP_IO, 3 },
-    { OP_CPU, 7 },
-    { OP_IO, 1 },
-    { OP_CPU, 9 },
-    { OP_IO, 3 },
-    { OP_CPU, 12 },
-    { OP_IO, 3 },
-    { OP_CPU, 7 },
-    { OP_IO, 1 },
-    { OP_CPU, 9 },
-    { OP_IO, 3 },
-    { OP_CPU, 12 },
-    { OP_IO, 3 },
-    { OP_CPU, 7 },
-    { OP_IO, 1 },
-    { OP_CPU, 9 },
-    { OP_TERMINATE, 0 }
+    { OP_CPU, 6, IO_DEVICE_ANY }, 
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 12, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 12, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 12, IO_DEVICE_ANY },
+    { OP_IO, 3, IO_DEVICE_ANY },
+    { OP_CPU, 7, IO_DEVICE_ANY },
+    { OP_IO, 1, IO_DEVICE_ANY },
+    { OP_CPU, 9, IO_DEVICE_ANY },
+    { OP_TERMINATE, 0, IO_DEVICE_ANY }
 };
 
-pcb_t processes[PROCESS_COUNT] = {
-    { 0, "Iapache", 2, PROCESS_NEW, pid0_ops, NULL },
-    { 1, "Ibash", 3, PROCESS_NEW, pid1_ops, NULL },
-    { 2, "Imozilla", 1, PROCESS_NEW, pid2_ops, NULL },
-    { 3, "Ccpu", 9, PROCESS_NEW, pid3_ops, NULL },
-    { 4, "Cgcc", 10, PROCESS_NEW, pid4_ops, NULL },
-    { 5, "Cspice", 9, PROCESS_NEW, pid5_ops, NULL },
-    { 6, "Cmysql", 6, PROCESS_NEW, pid6_ops, NULL },
-    { 7, "Csim", 6, PROCESS_NEW, pid7_ops, NULL }
+#define DEFAULT_PROCESS_COUNT 8
+
+static const struct {
+    const char *name;
+    op_t *ops;
+} default_processes[DEFAULT_PROCESS_COUNT] = {
+    { "Iapache", pid0_ops },
+    { "Ibash", pid1_ops },
+    { "Imozilla", pid2_ops },
+    { "Ccpu", pid3_ops },
+    { "Cgcc", pid4_ops },
+    { "Cspice", pid5_ops },
+    { "Cmysql", pid6_ops },
+    { "Csim", pid7_ops }
 };
 
+pcb_t *processes = NULL;
+unsigned int process_count = 0;
+
+
+/* Returns the number of operations in ops, including the OP_TERMINATE */
+static size_t ops_length(const op_t *ops)
+{
+    size_t n = 1;
+
+    while (ops[n - 1].type != OP_TERMINATE)
+        n++;
+    return n;
+}
+
+void process_table_alloc(unsigned int count)
+{
+    free(processes);
+    processes = calloc(count ? count : 1, sizeof(pcb_t));
+    assert(processes != NULL);
+    process_count = count;
+}
+
+void process_init(pcb_t *pcb, unsigned int pid, const char *name, op_t *ops)
+{
+    /* pid is const, so build the PCB on the stack and copy it in */
+    pcb_t tmp = { pid, name, ops ? ops[0].time : 0, PROCESS_NEW, ops, NULL,
+                  0, 0, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+    memcpy(pcb, &tmp, sizeof(pcb_t));
+}
+
+void process_init_default(unsigned int count)
+{
+    unsigned int n;
+
+    process_table_alloc(count);
+    for (n = 0; n < count; n++)
+    {
+        op_t *template = default_processes[n % DEFAULT_PROCESS_COUNT].ops;
+        size_t len = ops_length(template);
+        op_t *ops = malloc(len * sizeof(op_t));
+        assert(ops != NULL);
+        memcpy(ops, template, len * sizeof(op_t));
+
+        process_init(&processes[n], n,
+            default_processes[n % DEFAULT_PROCESS_COUNT].name, ops);
+        processes[n].arrival = n * 10;
+    }
+}
+
+/*
+ * The clone and its operations arrays share one allocation, since the
+ * simulator advances each PCB's pc as it runs.
+ */
+pcb_t *process_table_clone(const pcb_t *table, unsigned int count)
+{
+    size_t total = 0;
+    unsigned int n;
+    pcb_t *copy;
+    op_t *ops;
+
+    for (n = 0; n < count; n++)
+        total += ops_length(table[n].pc);
+    copy = malloc(sizeof(pcb_t) * count + sizeof(op_t) * total);
+    assert(copy != NULL);
+    memcpy(copy, table, sizeof(pcb_t) * count);
+    ops = (op_t*) (copy + count);
+    for (n = 0; n < count; n++)
+    {
+        size_t len = ops_length(table[n].pc);
+        memcpy(ops, table[n].pc, len * sizeof(op_t));
+        copy[n].pc = ops;
+        ops += len;
+    }
+    return copy;
+}
 
+void process_table_free(pcb_t *table)
+{
+    free(table);
+}
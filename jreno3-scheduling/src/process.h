@@ -9,11 +9,41 @@
 #define __PROCESS_H__
 
 
-#define PROCESS_COUNT 8
-extern pcb_t processes[PROCESS_COUNT];
+/*
+ * The process table.  It is allocated at startup and holds process_count
+ * PCBs; the simulator creates them in table order.
+ */
+extern pcb_t *processes;
+extern unsigned int process_count;
 
 
+/*
+ * process_table_alloc() allocates an empty table of count PCBs, replacing the
+ * current one.  process_init() fills in one entry; the first CPU burst of ops
+ * becomes its initial time_remaining, and the remaining fields default to
+ * arrival 0, priority 0, nice 0 and no affinity.
+ */
+extern void process_table_alloc(unsigned int count);
+extern void process_init(pcb_t *pcb, unsigned int pid, const char *name,
+                         op_t *ops);
 
 
-#endif /* __PROCESS_H__ */
+/*
+ * process_init_default() builds a process table of the given size from the
+ * eight built-in processes, repeating them as needed and creating one every
+ * 10 ticks.  Every copy gets its own operations array, since the simulator
+ * consumes them in place.
+ */
+extern void process_init_default(unsigned int count);
 
+
+/*
+ * process_table_clone() returns a fresh copy of a table of count PCBs that
+ * has not been run yet, with its own operations arrays, so it can be
+ * simulated while the original is kept.  process_table_free() frees a clone.
+ */
+extern pcb_t *process_table_clone(const pcb_t *table, unsigned int count);
+extern void process_table_free(pcb_t *table);
+
+
+#endif /* __PROCESS_H__ */
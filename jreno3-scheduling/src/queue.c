@@ -0,0 +1,151 @@
+/*
+ * queue.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Ready queues of PCBs.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "queue.h"
+
+
+void pcb_queue_init(pcb_queue_t *queue)
+{
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->size = 0;
+}
+
+void pcb_queue_push(pcb_queue_t *queue, pcb_t *pcb)
+{
+    pcb->next = NULL;
+    if (queue->tail != NULL)
+        queue->tail->next = pcb;
+    else
+        queue->head = pcb;
+    queue->tail = pcb;
+    queue->size++;
+}
+
+pcb_t *pcb_queue_pop(pcb_queue_t *queue)
+{
+    pcb_t *pcb = queue->head;
+
+    if (pcb != NULL)
+        pcb_queue_remove(queue, NULL, pcb);
+    return pcb;
+}
+
+void pcb_queue_remove(pcb_queue_t *queue, pcb_t *prev, pcb_t *pcb)
+{
+    if (prev != NULL)
+        prev->next = pcb->next;
+    else
+        queue->head = pcb->next;
+    if (queue->tail == pcb)
+        queue->tail = prev;
+    pcb->next = NULL;
+    queue->size--;
+}
+
+
+
+void pcb_mpmc_init(pcb_mpmc_t *queue, size_t capacity)
+{
+    size_t size = 2, n;
+
+    while (size < capacity)
+        size <<= 1;
+    queue->cells = malloc(size * sizeof(pcb_mpmc_cell_t));
+    assert(queue->cells != NULL);
+    for (n = 0; n < size; n++)
+    {
+        queue->cells[n].seq = n;
+        queue->cells[n].pcb = NULL;
+    }
+    queue->mask = size - 1;
+    queue->enqueue_pos = 0;
+    queue->dequeue_pos = 0;
+}
+
+void pcb_mpmc_free(pcb_mpmc_t *queue)
+{
+    free(queue->cells);
+    queue->cells = NULL;
+}
+
+int pcb_mpmc_push(pcb_mpmc_t *queue, pcb_t *pcb)
+{
+    pcb_mpmc_cell_t *cell;
+    size_t pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+
+    while (1)
+    {
+        intptr_t dif;
+
+        cell = &queue->cells[pos & queue->mask];
+        dif = (intptr_t) __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) -
+            (intptr_t) pos;
+        if (dif == 0)
+        {
+            if (__atomic_compare_exchange_n(&queue->enqueue_pos, &pos,
+                    pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (dif < 0)
+            return -1;
+        else
+            pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+    }
+
+    cell->pcb = pcb;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+pcb_t *pcb_mpmc_pop(pcb_mpmc_t *queue)
+{
+    pcb_mpmc_cell_t *cell;
+    pcb_t *pcb;
+    size_t pos = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+
+    while (1)
+    {
+        intptr_t dif;
+
+        cell = &queue->cells[pos & queue->mask];
+        dif = (intptr_t) __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) -
+            (intptr_t)(pos + 1);
+        if (dif == 0)
+        {
+            if (__atomic_compare_exchange_n(&queue->dequeue_pos, &pos,
+                    pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (dif < 0)
+            return NULL;
+        else
+            pos = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+    }
+
+    pcb = cell->pcb;
+    __atomic_store_n(&cell->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+    return pcb;
+}
+
+int pcb_mpmc_empty(pcb_mpmc_t *queue)
+{
+    return __atomic_load_n(&queue->dequeue_pos, __ATOMIC_SEQ_CST) ==
+        __atomic_load_n(&queue->enqueue_pos, __ATOMIC_SEQ_CST);
+}
+
+size_t pcb_mpmc_size(pcb_mpmc_t *queue)
+{
+    size_t dequeued = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+    size_t enqueued = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * queue.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Ready queues of PCBs.
+ */
+
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include <stddef.h>
+
+#include "os-sim.h"
+
+
+/*
+ * An intrusive FIFO queue linked through pcb->next.  Both ends are tracked,
+ * so push and pop are O(1).  It does no locking of its own.
+ */
+typedef struct {
+    pcb_t *head;
+    pcb_t *tail;
+    unsigned int size;
+} pcb_queue_t;
+
+extern void pcb_queue_init(pcb_queue_t *queue);
+extern void pcb_queue_push(pcb_queue_t *queue, pcb_t *pcb);
+extern pcb_t *pcb_queue_pop(pcb_queue_t *queue);
+
+/* Unlinks pcb, whose predecessor in the queue is prev (NULL at the head) */
+extern void pcb_queue_remove(pcb_queue_t *queue, pcb_t *prev, pcb_t *pcb);
+
+
+/*
+ * A bounded lock-free multi-producer multi-consumer FIFO of PCB pointers
+ * (Vyukov's array queue).  Every cell carries a sequence number that tells
+ * producers and consumers whose turn it is, so each operation is a single
+ * compare-and-swap on the shared position plus a release store.
+ *
+ * A PCB is in at most one ready queue at a time, so a capacity of the process
+ * count can never fill up.
+ */
+typedef struct {
+    size_t seq;
+    pcb_t *pcb;
+} pcb_mpmc_cell_t;
+
+typedef struct {
+    pcb_mpmc_cell_t *cells;
+    size_t mask;
+    size_t enqueue_pos __attribute__((aligned(CACHE_LINE_SIZE)));
+    size_t dequeue_pos __attribute__((aligned(CACHE_LINE_SIZE)));
+} pcb_mpmc_t;
+
+/* capacity is rounded up to a power of two */
+extern void pcb_mpmc_init(pcb_mpmc_t *queue, size_t capacity);
+extern void pcb_mpmc_free(pcb_mpmc_t *queue);
+
+/* Returns 0 on success, -1 if the queue is full */
+extern int pcb_mpmc_push(pcb_mpmc_t *queue, pcb_t *pcb);
+
+/* Returns NULL if the queue is empty */
+extern pcb_t *pcb_mpmc_pop(pcb_mpmc_t *queue);
+
+/* A snapshot; only meaningful if producers are excluded some other way */
+extern int pcb_mpmc_empty(pcb_mpmc_t *queue);
+
+/* Also a snapshot, which may be off by the operations in flight */
+extern size_t pcb_mpmc_size(pcb_mpmc_t *queue);
+
+#endif /* __QUEUE_H__ */
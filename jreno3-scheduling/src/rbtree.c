@@ -0,0 +1,268 @@
+/*
+ * rbtree.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * An intrusive red-black tree, following CLRS with NULL leaves.
+ */
+
+#include <stdlib.h>
+
+#include "rbtree.h"
+
+
+void rb_init(rbtree_t *tree, rb_less_t less)
+{
+    tree->root = NULL;
+    tree->leftmost = NULL;
+    tree->size = 0;
+    tree->less = less;
+}
+
+rb_node_t *rb_first(const rbtree_t *tree)
+{
+    return tree->leftmost;
+}
+
+rb_node_t *rb_next(rb_node_t *node)
+{
+    rb_node_t *parent;
+
+    if (node->right != NULL)
+    {
+        node = node->right;
+        while (node->left != NULL)
+            node = node->left;
+        return node;
+    }
+    while ((parent = node->parent) != NULL && node == parent->right)
+        node = parent;
+    return parent;
+}
+
+/* Points whatever referred to old (its parent, or the root) at new */
+static void replace_child(rbtree_t *tree, rb_node_t *old, rb_node_t *new)
+{
+    if (old->parent == NULL)
+        tree->root = new;
+    else if (old == old->parent->left)
+        old->parent->left = new;
+    else
+        old->parent->right = new;
+    if (new != NULL)
+        new->parent = old->parent;
+}
+
+static void rotate_left(rbtree_t *tree, rb_node_t *x)
+{
+    rb_node_t *y = x->right;
+
+    x->right = y->left;
+    if (y->left != NULL)
+        y->left->parent = x;
+    replace_child(tree, x, y);
+    y->left = x;
+    x->parent = y;
+}
+
+static void rotate_right(rbtree_t *tree, rb_node_t *x)
+{
+    rb_node_t *y = x->left;
+
+    x->left = y->right;
+    if (y->right != NULL)
+        y->right->parent = x;
+    replace_child(tree, x, y);
+    y->right = x;
+    x->parent = y;
+}
+
+void rb_insert(rbtree_t *tree, rb_node_t *node)
+{
+    rb_node_t *parent = NULL, **link = &tree->root;
+    int leftmost = 1;
+
+    while (*link != NULL)
+    {
+        parent = *link;
+        if (tree->less(node, parent))
+            link = &parent->left;
+        else
+        {
+            link = &parent->right;
+            leftmost = 0;
+        }
+    }
+    node->parent = parent;
+    node->left = node->right = NULL;
+    node->red = 1;
+    *link = node;
+    if (leftmost)
+        tree->leftmost = node;
+    tree->size++;
+
+    /* Fix up red-red violations on the way back to the root */
+    while ((parent = node->parent) != NULL && parent->red)
+    {
+        rb_node_t *grandparent = parent->parent;
+        rb_node_t *uncle;
+
+        if (parent == grandparent->left)
+        {
+            uncle = grandparent->right;
+            if (uncle != NULL && uncle->red)
+            {
+                parent->red = uncle->red = 0;
+                grandparent->red = 1;
+                node = grandparent;
+                continue;
+            }
+            if (node == parent->right)
+            {
+                rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->red = 0;
+            grandparent->red = 1;
+            rotate_right(tree, grandparent);
+        }
+        else
+        {
+            uncle = grandparent->left;
+            if (uncle != NULL && uncle->red)
+            {
+                parent->red = uncle->red = 0;
+                grandparent->red = 1;
+                node = grandparent;
+                continue;
+            }
+            if (node == parent->left)
+            {
+                rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->red = 0;
+            grandparent->red = 1;
+            rotate_left(tree, grandparent);
+        }
+    }
+    tree->root->red = 0;
+}
+
+void rb_erase(rbtree_t *tree, rb_node_t *node)
+{
+    rb_node_t *child, *parent;
+    int removed_red;
+
+    if (tree->leftmost == node)
+        tree->leftmost = rb_next(node);
+    tree->size--;
+
+    /*
+     * Unlink node, or its successor if it has two children, remembering
+     * where the removed color was lost: child takes its place under parent.
+     */
+    if (node->left == NULL || node->right == NULL)
+    {
+        child = node->left != NULL ? node->left : node->right;
+        parent = node->parent;
+        removed_red = node->red;
+        replace_child(tree, node, child);
+    }
+    else
+    {
+        rb_node_t *succ = node->right;
+
+        while (succ->left != NULL)
+            succ = succ->left;
+        child = succ->right;
+        removed_red = succ->red;
+        if (succ->parent == node)
+            parent = succ;
+        else
+        {
+            parent = succ->parent;
+            replace_child(tree, succ, child);
+            succ->right = node->right;
+            succ->right->parent = succ;
+        }
+        replace_child(tree, node, succ);
+        succ->left = node->left;
+        succ->left->parent = succ;
+        succ->red = node->red;
+    }
+
+    if (removed_red)
+        return;
+
+    /* child carries an extra black; push it up until it can be absorbed */
+    while (child != tree->root && (child == NULL || !child->red))
+    {
+        rb_node_t *sibling;
+
+        if (child == parent->left)
+        {
+            sibling = parent->right;
+            if (sibling->red)
+            {
+                sibling->red = 0;
+                parent->red = 1;
+                rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+            if ((sibling->left == NULL || !sibling->left->red) &&
+                (sibling->right == NULL || !sibling->right->red))
+            {
+                sibling->red = 1;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+            if (sibling->right == NULL || !sibling->right->red)
+            {
+                sibling->left->red = 0;
+                sibling->red = 1;
+                rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->right->red = 0;
+            rotate_left(tree, parent);
+        }
+        else
+        {
+            sibling = parent->left;
+            if (sibling->red)
+            {
+                sibling->red = 0;
+                parent->red = 1;
+                rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+            if ((sibling->left == NULL || !sibling->left->red) &&
+                (sibling->right == NULL || !sibling->right->red))
+            {
+                sibling->red = 1;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+            if (sibling->left == NULL || !sibling->left->red)
+            {
+                sibling->right->red = 0;
+                sibling->red = 1;
+                rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->left->red = 0;
+            rotate_right(tree, parent);
+        }
+        child = tree->root;
+    }
+    if (child != NULL)
+        child->red = 0;
+}
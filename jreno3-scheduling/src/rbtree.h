@@ -0,0 +1,53 @@
+/*
+ * rbtree.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * An intrusive red-black tree.
+ */
+
+#ifndef __RBTREE_H__
+#define __RBTREE_H__
+
+#include <stddef.h>
+
+/*
+ * A node is embedded in whatever it orders; rb_entry() gets back to the
+ * containing structure.
+ */
+typedef struct rb_node {
+    struct rb_node *parent;
+    struct rb_node *left;
+    struct rb_node *right;
+    int red;
+} rb_node_t;
+
+#define rb_entry(node, type, member) \
+    ((type*)((char*)(node) - offsetof(type, member)))
+#define rb_const_entry(node, type, member) \
+    ((const type*)((const char*)(node) - offsetof(type, member)))
+
+/* less(a, b) returns nonzero if a sorts before b; keys must be distinct */
+typedef int (*rb_less_t)(const rb_node_t *a, const rb_node_t *b);
+
+/*
+ * The tree caches its leftmost node, so finding the minimum is O(1) and
+ * insertion and removal are O(log n).  It does no locking of its own.
+ */
+typedef struct {
+    rb_node_t *root;
+    rb_node_t *leftmost;
+    unsigned int size;
+    rb_less_t less;
+} rbtree_t;
+
+extern void rb_init(rbtree_t *tree, rb_less_t less);
+extern void rb_insert(rbtree_t *tree, rb_node_t *node);
+extern void rb_erase(rbtree_t *tree, rb_node_t *node);
+
+/* rb_first() returns the smallest node, or NULL if the tree is empty */
+extern rb_node_t *rb_first(const rbtree_t *tree);
+
+/* rb_next() returns the node after node in order, or NULL */
+extern rb_node_t *rb_next(rb_node_t *node);
+
+#endif /* __RBTREE_H__ */
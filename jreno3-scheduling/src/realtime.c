@@ -0,0 +1,113 @@
+/*
+ * realtime.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Periodic and sporadic real-time tasks.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "realtime.h"
+
+int rt_is_task(const pcb_t *pcb)
+{
+    return pcb->period > 0;
+}
+
+unsigned int rt_deadline(const pcb_t *pcb)
+{
+    return pcb->deadline ? pcb->deadline : pcb->period;
+}
+
+unsigned int rt_wcet(const op_t *ops)
+{
+    unsigned int wcet = 0;
+
+    for (; ops->type != OP_TERMINATE; ops++)
+        if (ops->type == OP_CPU && ops->time + 1 > wcet)
+            wcet = ops->time + 1;
+    return wcet;
+}
+
+unsigned int rt_next_release(const pcb_t *pcb, unsigned int prev,
+                             unsigned int job)
+{
+    uint64_t z;
+
+    if (pcb->jitter == 0)
+        return prev + pcb->period;
+
+    /* One splitmix64 step over the PID and job number */
+    z = ((uint64_t) pcb->pid << 32 | job) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return prev + pcb->period + (unsigned int)(z % (pcb->jitter + 1ull));
+}
+
+double rt_utilization(const pcb_t *pcb)
+{
+    return (double) pcb->wcet / pcb->period;
+}
+
+double rt_density(const pcb_t *pcb)
+{
+    unsigned int d = rt_deadline(pcb);
+
+    return (double) pcb->wcet / (d < pcb->period ? d : pcb->period);
+}
+
+double rt_edf_bound(unsigned int cpus, double max)
+{
+    if (max > 1.0)
+        return -1.0;
+    return cpus - (cpus - 1) * max;
+}
+
+double rt_rm_bound(unsigned int cpus, unsigned int tasks, double max)
+{
+    if (cpus == 1)
+    {
+        if (max > 1.0)
+            return -1.0;
+        return tasks ? tasks * (pow(2.0, 1.0 / tasks) - 1.0) : 1.0;
+    }
+    if (max > (double) cpus / (3 * cpus - 2))
+        return -1.0;
+    return (double) cpus * cpus / (3 * cpus - 2);
+}
+
+void rt_print_bounds(const pcb_t *table, unsigned int count,
+                     unsigned int cpus, FILE *out)
+{
+    double total = 0.0, density = 0.0, max = 0.0, edf, rm;
+    unsigned int n, tasks = 0;
+
+    for (n = 0; n < count; n++)
+    {
+        double d;
+
+        if (!rt_is_task(&table[n]))
+            continue;
+        tasks++;
+        total += rt_utilization(&table[n]);
+        d = rt_density(&table[n]);
+        density += d;
+        if (d > max)
+            max = d;
+    }
+    if (tasks == 0)
+        return;
+
+    edf = rt_edf_bound(cpus, max);
+    rm = rt_rm_bound(cpus, tasks, max);
+    fprintf(out, "Real-time tasks: %u, utilization %.3f, density %.3f "
+        "(max %.3f) on %u CPU%s\n", tasks, total, density, max, cpus,
+        cpus == 1 ? "" : "s");
+    fprintf(out, "  EDF bound: %.3f, %s\n", edf < 0 ? 0.0 : edf,
+        edf >= 0 && density <= edf ? "schedulable" : "not guaranteed");
+    fprintf(out, "  RM bound:  %.3f, %s\n", rm < 0 ? 0.0 : rm,
+        rm >= 0 && density <= rm ? "schedulable" : "not guaranteed");
+}
@@ -0,0 +1,72 @@
+/*
+ * realtime.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Periodic and sporadic real-time tasks.
+ *
+ * A task is a process with a period (see pcb_t).  Each of its CPU bursts is
+ * one job: the first is released when the process arrives, and each later one
+ * a period after the last, plus for a sporadic task (nonzero jitter) a
+ * further 0 to jitter ticks.  A job is due its relative deadline after its
+ * release.  Between jobs the task sleeps, neither ready nor in I/O.
+ */
+
+#ifndef __REALTIME_H__
+#define __REALTIME_H__
+
+#include <stdio.h>
+
+#include "os-sim.h"
+
+/* Nonzero if pcb is a real-time task */
+extern int rt_is_task(const pcb_t *pcb);
+
+/* The task's relative deadline, which defaults to its period */
+extern unsigned int rt_deadline(const pcb_t *pcb);
+
+/*
+ * rt_wcet() is the worst-case execution time of a job in ops, in ticks.  A
+ * burst of t ticks holds the CPU for t + 1, as the simulator counts them.
+ */
+extern unsigned int rt_wcet(const op_t *ops);
+
+/*
+ * rt_next_release() is the release of job number job, given that job - 1 was
+ * released at prev.  The jitter is a hash of the PID and job number, so runs
+ * are repeatable.
+ */
+extern unsigned int rt_next_release(const pcb_t *pcb, unsigned int prev,
+                                    unsigned int job);
+
+/*
+ * rt_utilization() is wcet / period, and rt_density() is wcet over the
+ * smaller of the period and the deadline, which is what the admission tests
+ * below use for constrained deadlines.
+ */
+extern double rt_utilization(const pcb_t *pcb);
+extern double rt_density(const pcb_t *pcb);
+
+/*
+ * Sufficient schedulability tests on cpus CPUs, given the total and largest
+ * density of the task set.
+ *
+ *   rt_edf_bound() : global EDF (Goossens, Funk and Baruah), total at most
+ *        cpus - (cpus - 1) * max; plain U <= 1 on one CPU
+ *   rt_rm_bound() : on one CPU, Liu and Layland's n (2^(1/n) - 1) for n
+ *        tasks; on several, Andersson, Baruah and Jonsson's cpus^2 /
+ *        (3 cpus - 2), provided no task's density exceeds cpus / (3 cpus - 2)
+ *
+ * Each returns the bound the total must not exceed, or -1 if max rules the
+ * set out regardless.
+ */
+extern double rt_edf_bound(unsigned int cpus, double max);
+extern double rt_rm_bound(unsigned int cpus, unsigned int tasks, double max);
+
+/*
+ * rt_print_bounds() prints the total utilization of the tasks in table and
+ * whether the set passes each test on cpus CPUs.  wcet must be filled in.
+ */
+extern void rt_print_bounds(const pcb_t *table, unsigned int count,
+                            unsigned int cpus, FILE *out);
+
+#endif /* __REALTIME_H__ */
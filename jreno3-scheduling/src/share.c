@@ -0,0 +1,347 @@
+/*
+ * share.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The lottery and stride proportional-share policies (-t).
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfs.h"
+#include "policy.h"
+#include "share.h"
+
+/* LOTTERY and STRIDE tickets, which follow the CFS weights */
+static unsigned int tickets_of(const pcb_t *pcb)
+{
+    return weight_of(pcb);
+}
+
+/* Brings the share clock up to now; share.lock held */
+static void share_update(void)
+{
+    unsigned int now = get_simulator_time();
+    unsigned int busy = sched->share.runnable < sched->cpu_count ?
+        sched->share.runnable : sched->cpu_count;
+
+    if (sched->share.tickets > 0) {
+        sched->share.clock += (double) (now - sched->share.updated) * busy /
+            sched->share.tickets;
+    }
+    sched->share.updated = now;
+}
+
+/*
+ * share_join() and share_leave() track a process becoming runnable (on
+ * wake_up()) and ceasing to be (on yield() or terminate()).  While it is
+ * runnable, it is owed its tickets' worth of every tick of the share clock.
+ */
+static void share_join(pcb_t *pcb)
+{
+    prof_mutex_lock(&sched->share.lock);
+    share_update();
+    sched->info[pcb->pid].share.start = sched->share.clock;
+    sched->share.runnable++;
+    sched->share.tickets += tickets_of(pcb);
+    prof_mutex_unlock(&sched->share.lock);
+}
+
+static void share_leave(const pcb_t *pcb)
+{
+    share_proc_t *ps = &sched->info[pcb->pid].share;
+
+    prof_mutex_lock(&sched->share.lock);
+    share_update();
+    ps->ideal += tickets_of(pcb) * (sched->share.clock - ps->start);
+    sched->share.runnable--;
+    sched->share.tickets -= tickets_of(pcb);
+    prof_mutex_unlock(&sched->share.lock);
+}
+
+/*
+ * share_charge() accounts for the ticks pcb just ran, noting how far ahead
+ * of or behind its exact share that leaves it.  STRIDE advances its pass by
+ * them, so a process that ran part of its quantum pays for only that part.
+ * Under LOTTERY, a process that blocked for I/O after ran ticks of its
+ * quantum has its tickets inflated by quantum / ran for its next draw, with
+ * compensation on, which evens out its share the same way.
+ */
+static void share_charge(const pcb_t *pcb, int blocked)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    share_proc_t *ps = &pi->share;
+    unsigned int ran = get_simulator_time() - pi->dispatched;
+    double lag;
+
+    ps->received += ran;
+    prof_mutex_lock(&sched->share.lock);
+    share_update();
+    lag = ps->received - (ps->ideal + tickets_of(pcb) *
+        (sched->share.clock - ps->start));
+    prof_mutex_unlock(&sched->share.lock);
+    if (fabs(lag) > fabs(ps->max_lag)) {
+        ps->max_lag = lag;
+    }
+    if (sched->algorithm == STRIDE) {
+        ps->pass += ran * STRIDE1 / tickets_of(pcb);
+    } else if (blocked && sched->share.compensation && ran > 0 &&
+               ran < sched->share.quantum) {
+        ps->compensation = (double) sched->share.quantum / ran;
+    }
+}
+
+/* A draw in [0, bound) from rq's generator, one splitmix64 step */
+static unsigned long long lottery_draw(runqueue_t *rq,
+                                       unsigned long long bound)
+{
+    uint64_t z = (rq->share.rng += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (z ^ (z >> 31)) % bound;
+}
+
+/* Moves a STRIDE pass from one run queue's min_pass onto another's */
+static unsigned long long stride_rebase(unsigned long long pass,
+                                        const runqueue_t *from,
+                                        const runqueue_t *to)
+{
+    unsigned long long base = __atomic_load_n(&from->share.min_pass,
+        __ATOMIC_RELAXED);
+    return (pass > base ? pass - base : 0) +
+        __atomic_load_n(&to->share.min_pass, __ATOMIC_RELAXED);
+}
+
+static void lottery_push(runqueue_t *rq, pcb_t *pcb)
+{
+    share_proc_t *ps = &sched->info[pcb->pid].share;
+    ps->held = (unsigned long long) (tickets_of(pcb) *
+        (ps->compensation > 1.0 ? ps->compensation : 1.0));
+    ps->compensation = 1.0;
+    fenwick_add(&rq->share.tickets, pcb->pid, (long long) ps->held);
+}
+
+static pcb_t *lottery_pop(runqueue_t *rq)
+{
+    unsigned int pid;
+    if (rq->share.tickets.total == 0) {
+        return NULL;
+    }
+    pid = fenwick_find(&rq->share.tickets,
+        lottery_draw(rq, rq->share.tickets.total));
+    fenwick_add(&rq->share.tickets, pid,
+        -(long long) sched->info[pid].share.held);
+    sched->info[pid].share.held = 0;
+    return &sched->processes[pid];
+}
+
+/*
+ * As with CFS, newcomers start at min_pass and processes keep their place
+ * relative to min_pass across queues.  A process waking from I/O may be at
+ * most one quantum's pass behind, with compensation, or else none.
+ */
+static void stride_push(runqueue_t *rq, pcb_t *pcb)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    runqueue_t *from = pcb->last_cpu >= 0 ?
+        rq_of((unsigned int) pcb->last_cpu) : rq;
+    if (!pi->started) {
+        pi->share.pass = rq->share.min_pass;
+        pi->started = 1;
+    } else if (from != rq) {
+        pi->share.pass = stride_rebase(pi->share.pass, from, rq);
+    }
+    if (pi->waking) {
+        unsigned long long credit = sched->share.compensation ?
+            sched->share.quantum * STRIDE1 / tickets_of(pcb) : 0;
+        unsigned long long floor = rq->share.min_pass > credit ?
+            rq->share.min_pass - credit : 0;
+        if (pi->share.pass < floor) {
+            pi->share.pass = floor;
+        }
+        pi->waking = 0;
+    }
+    heap_push(&rq->heap, pcb->pid);
+}
+
+static pcb_t *stride_pop(runqueue_t *rq)
+{
+    unsigned int pid = heap_pop(&rq->heap);
+    if (pid == HEAP_NONE) {
+        return NULL;
+    }
+    if (sched->info[pid].share.pass > rq->share.min_pass) {
+        __atomic_store_n(&rq->share.min_pass, sched->info[pid].share.pass,
+            __ATOMIC_RELAXED);
+    }
+    return &sched->processes[pid];
+}
+
+/* Lowest pass first, equal passes in enqueue order */
+static int stride_runs_before(const pcb_t *a, const pcb_t *b)
+{
+    const proc_info_t *x = &sched->info[a->pid], *y = &sched->info[b->pid];
+    if (x->share.pass != y->share.pass) {
+        return x->share.pass < y->share.pass;
+    }
+    return x->seq < y->seq;
+}
+
+static void stride_migrate(pcb_t *pcb, const runqueue_t *from,
+                           const runqueue_t *to)
+{
+    share_proc_t *ps = &sched->info[pcb->pid].share;
+    ps->pass = stride_rebase(ps->pass, from, to);
+}
+
+static int share_quantum(unsigned int cpu_id, const pcb_t *pcb)
+{
+    (void) cpu_id;
+    (void) pcb;
+    return (int) sched->share.quantum;
+}
+
+/* A process coming off the CPU, which stops being runnable unless READY */
+static void share_off_cpu(unsigned int cpu_id, pcb_t *pcb,
+                          process_state_t state)
+{
+    (void) cpu_id;
+    share_charge(pcb, state == PROCESS_WAITING);
+    if (state != PROCESS_READY) {
+        share_leave(pcb);
+    }
+}
+
+static void share_create(const scheduler_config_t *config)
+{
+    sched->share.quantum = config->share_quantum;
+    sched->share.compensation = config->share_compensation;
+    sched->share.seed = config->share_seed;
+    prof_mutex_init(&sched->share.lock, sched->lock_profile);
+}
+
+static void share_destroy(scheduler_t *s)
+{
+    prof_mutex_destroy(&s->share.lock);
+}
+
+static void share_rq_init(runqueue_t *rq, unsigned int index)
+{
+    rq->share.tickets.tree = NULL;
+    if (sched->algorithm == LOTTERY) {
+        fenwick_init(&rq->share.tickets, sched->process_count);
+    }
+    rq->share.rng = sched->share.seed + index;
+    rq->share.min_pass = 0;
+}
+
+static void share_rq_free(runqueue_t *rq)
+{
+    fenwick_free(&rq->share.tickets);
+}
+
+/*
+ * share_print_error() lists the CPU time each process received against its
+ * exact proportional share: the error left at exit, and the largest lag
+ * (positive when ahead) along the way.
+ */
+static void share_print_error(void)
+{
+    double total = 0.0, total_lag = 0.0, worst = 0.0;
+
+    printf("\nProportional share:\n");
+    printf("%5s %-16s %7s %10s %12s %9s %11s\n", "pid", "name", "tickets",
+        "ideal (s)", "received (s)", "error (s)", "max lag (s)");
+    for (unsigned int n = 0; n < sched->process_count; n++) {
+        const share_proc_t *ps = &sched->info[n].share;
+        double error = (double) ps->received - ps->ideal;
+        printf("%5u %-16s %7u %10.1f %12.1f %+9.1f %+11.1f\n", n,
+            sched->processes[n].name, tickets_of(&sched->processes[n]),
+            ps->ideal / 10.0, ps->received / 10.0, error / 10.0,
+            ps->max_lag / 10.0);
+        total += fabs(error);
+        total_lag += fabs(ps->max_lag);
+        if (fabs(ps->max_lag) > fabs(worst)) {
+            worst = ps->max_lag;
+        }
+    }
+    if (sched->process_count > 0) {
+        printf("Share error: mean |error| %.2f s, mean |max lag| %.2f s, "
+            "worst lag %+.2f s\n", total / sched->process_count / 10.0,
+            total_lag / sched->process_count / 10.0, worst / 10.0);
+    }
+}
+
+const sched_policy_t lottery_policy = {
+    .create = share_create,
+    .destroy = share_destroy,
+    .rq_init = share_rq_init,
+    .rq_free = share_rq_free,
+    .push = lottery_push,
+    .pop = lottery_pop,
+    .quantum = share_quantum,
+    .leave = share_off_cpu,
+    .wake = share_join,
+    .print_stats = share_print_error,
+};
+
+const sched_policy_t stride_policy = {
+    .uses_heap = 1,
+    .create = share_create,
+    .destroy = share_destroy,
+    .rq_init = share_rq_init,
+    .rq_free = share_rq_free,
+    .push = stride_push,
+    .pop = stride_pop,
+    .runs_before = stride_runs_before,
+    .quantum = share_quantum,
+    .leave = share_off_cpu,
+    .wake = share_join,
+    .migrate = stride_migrate,
+    .print_stats = share_print_error,
+};
+
+extern int scheduler_parse_share(scheduler_config_t *config,
+                                 const char *spec) {
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+    assert(copy != NULL);
+    tok = strtok_r(copy, ",", &save);
+    if (tok != NULL && strcmp(tok, "lottery") == 0) {
+        config->algorithm = LOTTERY;
+    } else if (tok != NULL && strcmp(tok, "stride") == 0) {
+        config->algorithm = STRIDE;
+    } else {
+        ret = -1;
+    }
+    config->time_slice = -1;
+    while (ret == 0 && (tok = strtok_r(NULL, ",", &save)) != NULL) {
+        char *value = strchr(tok, '=');
+        unsigned long n;
+        if (value == NULL) {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        n = strtoul(value, &end, 0);
+        if (*end != '\0' || end == value) {
+            ret = -1;
+        } else if (strcmp(tok, "quantum") == 0 && n >= 1 && n <= 1000000) {
+            config->share_quantum = (unsigned int) n;
+        } else if (strcmp(tok, "compensation") == 0 && n <= 1) {
+            config->share_compensation = (int) n;
+        } else if (strcmp(tok, "seed") == 0) {
+            config->share_seed = n;
+        } else {
+            ret = -1;
+        }
+    }
+    free(copy);
+    if (ret != 0) {
+        fprintf(stderr, "Bad proportional share spec '%s'\n", spec);
+    }
+    return ret;
+}
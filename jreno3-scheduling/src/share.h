@@ -0,0 +1,79 @@
+/*
+ * share.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The lottery and stride proportional-share policies (-t).
+ *
+ * Each process holds tickets in proportion to its nice weight and runs for a
+ * quantum at a time, see scheduler_parse_share().  Both policies measure how
+ * far each process strays from the share an exact proportional scheduler
+ * would give it.
+ */
+
+#ifndef __SHARE_H__
+#define __SHARE_H__
+
+#include <stdint.h>
+
+#include "fenwick.h"
+#include "lockprof.h"
+
+/* A STRIDE process's pass advances STRIDE1 / tickets per tick it runs */
+#define STRIDE1 (1ull << 20)
+
+/*
+ * Per-process state.
+ *
+ *   held, compensation : LOTTERY tickets the process holds in its run
+ *        queue, and the factor they are inflated by for its next draw after
+ *        blocking early (see share_charge())
+ *   pass : STRIDE pass, in STRIDE1 units per tick at one ticket
+ *   received, ideal, start, max_lag : CPU ticks the process got, what an
+ *        exact proportional share would have given it by when it last
+ *        stopped being runnable, the share clock when it last became
+ *        runnable, and the furthest apart the two have been
+ */
+typedef struct {
+    unsigned long long held;
+    double compensation;
+    unsigned long long pass;
+    unsigned long long received;
+    double ideal;
+    double start;
+    double max_lag;
+} share_proc_t;
+
+/*
+ * Per run queue: LOTTERY keeps each queued process's tickets in tickets and
+ * draws from it with rng.  STRIDE queues by pass in the run queue's heap and
+ * keeps min_pass, the pass of the last process dispatched, as a floor for
+ * newcomers.
+ */
+typedef struct {
+    fenwick_t tickets;
+    uint64_t rng;
+    unsigned long long min_pass;
+} share_rq_t;
+
+/*
+ * The settings from scheduler_config_t, and the share clock.  clock
+ * measures the share an exact proportional scheduler would give each ticket,
+ * by integrating the CPUs in use over the tickets of the runnable processes
+ * (runnable and tickets), all protected by lock.  The gap between a
+ * process's ideal and what it received is its share error.
+ */
+typedef struct {
+    unsigned int quantum;
+    int compensation;
+    unsigned long seed;
+    double clock;
+    unsigned int updated;
+    unsigned int runnable;
+    unsigned long long tickets;
+    prof_mutex_t lock;
+} share_sched_t;
+
+extern const struct sched_policy lottery_policy;
+extern const struct sched_policy stride_policy;
+
+#endif /* __SHARE_H__ */
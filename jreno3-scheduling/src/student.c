@@ -6,13 +6,25 @@
  */
 
 #include <assert.h>
+#include <math.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "heap.h"
+#include "lockprof.h"
 #include "os-sim.h"
+#include "policy.h"
+#include "process.h"
+#include "queue.h"
+#include "realtime.h"
+#include "student.h"
+#include "sweep.h"
+#include "workload.h"
 
 #include <string.h>
+#include <unistd.h>
 
 /** Function prototypes **/
 extern void idle(unsigned int cpu_id);
@@ -21,33 +33,466 @@ extern void yield(unsigned int cpu_id);
 extern void terminate(unsigned int cpu_id);
 extern void wake_up(pcb_t *process);
 
-void enqueue(pcb_t *proc_to_add);
-pcb_t* dequeue(void);
-pcb_t* other_dequeue(void);
+void enqueue(pcb_t *proc_to_add, int cpu_hint);
+pcb_t* dequeue(unsigned int cpu_id);
+static int ready_less(unsigned int a, unsigned int b);
+static int running_less(unsigned int a, unsigned int b);
+static int runs_before(const pcb_t *a, const pcb_t *b);
+static void make_runnable(pcb_t *process);
+
+__thread scheduler_t *sched;
+
+runqueue_t *rq_of(unsigned int cpu_id)
+{
+    return &sched->runqueues[sched->per_cpu ? cpu_id : 0];
+}
+
+/* Algorithms that schedule real-time tasks by their timing */
+static int real_time(void)
+{
+    return sched->algorithm == EDF || sched->algorithm == RATE_MONOTONIC;
+}
 
 /*
- * current[] is an array of pointers to the currently running processes.
- * There is one array element corresponding to each CPU in the simulation.
- *
- * current[] should be updated by schedule() each time a process is scheduled
- * on a CPU.  Since the current[] array is accessed by multiple threads, you
- * will need to use a mutex to protect it.  current_mutex has been provided
- * for your use.
+ * admit() runs admission control when a real-time task first arrives: it is
+ * admitted if the tasks admitted so far plus it still pass the policy's
+ * utilization test (see realtime.h), and otherwise runs as best effort.
+ * Densities are released again on terminate, though rt_max is kept, which
+ * only makes the test more cautious.
+ */
+static void admit(pcb_t *process)
+{
+    proc_info_t *pi = &sched->info[process->pid];
+    double density, max, bound;
+
+    if (pi->rt != RT_UNSEEN || !rt_is_task(process)) {
+        return;
+    }
+    density = rt_density(process);
+    prof_mutex_lock(&sched->rt_lock);
+    max = density > sched->rt_max ? density : sched->rt_max;
+    if (sched->algorithm == EDF) {
+        bound = rt_edf_bound(sched->cpu_count, max);
+    } else {
+        bound = rt_rm_bound(sched->cpu_count, sched->rt_tasks + 1, max);
+    }
+    if (bound >= 0 && sched->rt_density + density <= bound) {
+        pi->rt = RT_ADMITTED;
+        sched->rt_density += density;
+        sched->rt_max = max;
+        sched->rt_tasks++;
+        sched->rt_admitted++;
+    } else {
+        pi->rt = RT_REJECTED;
+        sched->rt_rejected++;
+    }
+    prof_mutex_unlock(&sched->rt_lock);
+}
+
+/* Algorithms where a waking process may preempt a running one */
+static int preemptive(void)
+{
+    return sched->policy->preemptive;
+}
+
+/* Algorithms whose run queue is heap */
+static int uses_heap(void)
+{
+    return sched->policy->uses_heap;
+}
+
+static void queue_push(runqueue_t *rq, pcb_t *pcb)
+{
+    pcb_queue_push(&rq->queue, pcb);
+}
+
+static pcb_t *queue_pop(runqueue_t *rq)
+{
+    return pcb_queue_pop(&rq->queue);
+}
+
+static void heap_rq_push(runqueue_t *rq, pcb_t *pcb)
+{
+    heap_push(&rq->heap, pcb->pid);
+}
+
+static pcb_t *heap_rq_pop(runqueue_t *rq)
+{
+    unsigned int pid = heap_pop(&rq->heap);
+    return pid != HEAP_NONE ? &sched->processes[pid] : NULL;
+}
+
+/* FIFO and round robin, in arrival order */
+static const sched_policy_t queue_policy = {
+    .push = queue_push,
+    .pop = queue_pop,
+};
+
+/* SRTF, PRIORITY, EDF and RATE_MONOTONIC, in runs_before() order */
+static const sched_policy_t heap_policy = {
+    .preemptive = 1,
+    .uses_heap = 1,
+    .push = heap_rq_push,
+    .pop = heap_rq_pop,
+};
+
+static const sched_policy_t *policy_for(algorithm_t algorithm)
+{
+    switch (algorithm) {
+    case SRTF:
+    case PRIORITY:
+    case EDF:
+    case RATE_MONOTONIC:
+        return &heap_policy;
+    case MLFQ:
+        return &mlfq_policy;
+    case CFS:
+        return &cfs_policy;
+    case LOTTERY:
+        return &lottery_policy;
+    case STRIDE:
+        return &stride_policy;
+    case GANG:
+        return &gang_policy;
+    default:
+        return &queue_policy;
+    }
+}
+
+unsigned int group_of(const pcb_t *pcb)
+{
+    return pcb->group < sched->groups.count ? pcb->group : 0;
+}
+
+unsigned int rq_size(runqueue_t *rq)
+{
+    return __atomic_load_n(&rq->size, __ATOMIC_RELAXED);
+}
+
+/*
+ * How much of its current burst a process is expected to have left under
+ * -a.  A running process counts down a tick per tick, as its true time
+ * remaining does; see leave_cpu() for keeping this steady as it stops.
+ */
+static double predicted_remaining(const pcb_t *pcb)
+{
+    const proc_info_t *pi = &sched->info[pcb->pid];
+    double left = pi->estimate - pi->burst_ran;
+    if (pcb->state == PROCESS_RUNNING) {
+        left -= get_simulator_time() - pi->dispatched;
+    }
+    return left;
+}
+
+/*
+ * An adaptive round robin quantum: enough for the rest of the expected
+ * burst, plus a tick, so the burst usually ends without a preemption.  The
+ * processes waiting behind it share response ticks, which caps it.
+ */
+static int adaptive_quantum(unsigned int cpu_id, const pcb_t *pcb)
+{
+    double left = predicted_remaining(pcb);
+    size_t waiting = sched->lock_free ?
+        pcb_mpmc_size(&sched->ready_ring) : rq_size(rq_of(cpu_id));
+    unsigned int quantum = left > 0 ? (unsigned int) ceil(left) + 1 : 1;
+    unsigned int cap = sched->adapt_response / (unsigned int) (waiting + 1);
+
+    if (quantum > cap) {
+        quantum = cap;
+    }
+    if (quantum > sched->adapt_max) {
+        quantum = sched->adapt_max;
+    }
+    if (quantum < sched->adapt_min) {
+        quantum = sched->adapt_min;
+    }
+    sched->cpus[cpu_id].quanta++;
+    sched->cpus[cpu_id].quantum_sum += quantum;
+    return (int) quantum;
+}
+
+/* The time slice for a process about to be dispatched */
+static int quantum_for(unsigned int cpu_id, const pcb_t *pcb)
+{
+    if (sched->policy->quantum) {
+        return sched->policy->quantum(cpu_id, pcb);
+    }
+    if (sched->algorithm == ROUND_ROBIN && sched->adaptive) {
+        return adaptive_quantum(cpu_id, pcb);
+    }
+    return sched->time_slice;
+}
+
+/*
+ * leave_cpu() sets the state of the process coming off cpu_id.  With -a it
+ * first adds the ticks it ran to its burst and, if the burst is over
+ * (anything but a preemption), folds the burst into its estimate.  SRTF
+ * orders by predicted_remaining(), which depends on both, so there they
+ * change together under running_lock.
+ */
+static void leave_cpu(unsigned int cpu_id, pcb_t *pcb, process_state_t state)
+{
+    proc_info_t *pi = &sched->info[pcb->pid];
+    cpu_info_t *cpu = &sched->cpus[cpu_id];
+    int locked = sched->adaptive && preemptive();
+    unsigned int ran;
+
+    if (!sched->adaptive) {
+        pcb->state = state;
+        return;
+    }
+    if (locked) {
+        prof_mutex_lock(&sched->running_lock);
+    }
+    ran = pi->burst_ran + (get_simulator_time() - pi->dispatched);
+    if (state == PROCESS_READY) {
+        pi->burst_ran = ran;
+    } else {
+        cpu->estimate_error += fabs(pi->estimate - ran);
+        cpu->bursts++;
+        pi->estimate = sched->adapt_alpha * ran +
+            (1.0 - sched->adapt_alpha) * pi->estimate;
+        pi->burst_ran = 0;
+    }
+    pcb->state = state;
+    if (locked) {
+        prof_mutex_unlock(&sched->running_lock);
+    }
+}
+
+/*
+ * Starts a new period for limited group g if its last one has ended, keeping
+ * any overrun as debt.  group_lock held.
+ */
+static void group_refresh(unsigned int g, unsigned int now)
+{
+    const cgroup_t *cg = &sched->groups.groups[g];
+    group_state_t *gs = &sched->group_state[g];
+
+    if (now < gs->period_end) {
+        return;
+    }
+    gs->runtime = (long) cg->quota + (gs->runtime < 0 ? gs->runtime : 0);
+    gs->period_end = (now / cg->period + 1) * cg->period;
+    if (gs->throttled && gs->runtime > 0) {
+        gs->throttled = 0;
+        gs->throttled_time += now - gs->throttled_at;
+    }
+}
+
+/* Marks group g out of quota until its next period; group_lock held */
+static void group_throttle(unsigned int g, unsigned int now)
+{
+    group_state_t *gs = &sched->group_state[g];
+
+    if (!gs->throttled) {
+        gs->throttled = 1;
+        gs->throttled_at = now;
+        gs->throttles++;
+    }
+    set_timer(gs->period_end);
+}
+
+/*
+ * group_dispatch() is called before pcb runs on cpu_id for *quantum ticks
+ * (-1 for no limit).  If pcb's group or one above it is out of quota, it
+ * parks pcb there and returns 0.  Otherwise it reserves the slice from every
+ * limited group, cutting *quantum down to what they have left, and returns 1.
+ */
+static int group_dispatch(unsigned int cpu_id, pcb_t *pcb, int *quantum)
+{
+    unsigned int now = get_simulator_time();
+    cpu_info_t *cpu = &sched->cpus[cpu_id];
+    long avail = -1;
+    int g;
+
+    prof_mutex_lock(&sched->group_lock);
+    for (g = (int) group_of(pcb); g >= 0; g = sched->groups.groups[g].parent) {
+        group_state_t *gs = &sched->group_state[g];
+        if (!sched->groups.groups[g].quota) {
+            continue;
+        }
+        group_refresh((unsigned int) g, now);
+        if (gs->runtime <= 0) {
+            group_throttle((unsigned int) g, now);
+            pcb_queue_push(&gs->parked, pcb);
+            prof_mutex_unlock(&sched->group_lock);
+            return 0;
+        }
+        if (avail < 0 || gs->runtime < avail) {
+            avail = gs->runtime;
+        }
+    }
+
+    cpu->budget_limited = avail >= 0 && (*quantum < 0 || *quantum > avail);
+    if (cpu->budget_limited) {
+        *quantum = (int) avail;
+    }
+    cpu->reserved = avail >= 0 ? *quantum : 0;
+    for (g = (int) group_of(pcb); g >= 0; g = sched->groups.groups[g].parent) {
+        if (sched->groups.groups[g].quota) {
+            sched->group_state[g].runtime -= cpu->reserved;
+        }
+    }
+    prof_mutex_unlock(&sched->group_lock);
+    return 1;
+}
+
+/*
+ * group_charge() accounts for pcb leaving cpu_id: every group above it is
+ * charged for the ticks it ran, and limited ones get back what it reserved,
+ * running out if that leaves them nothing.
  */
+void group_charge(unsigned int cpu_id, const pcb_t *pcb)
+{
+    unsigned int now = get_simulator_time();
+    long ran = (long) (now - sched->info[pcb->pid].dispatched);
+    int g;
+
+    prof_mutex_lock(&sched->group_lock);
+    for (g = (int) group_of(pcb); g >= 0; g = sched->groups.groups[g].parent) {
+        group_state_t *gs = &sched->group_state[g];
+        gs->usage += (unsigned long long) ran;
+        if (!sched->groups.groups[g].quota) {
+            continue;
+        }
+        gs->runtime += sched->cpus[cpu_id].reserved - ran;
+        if (gs->runtime <= 0) {
+            group_throttle((unsigned int) g, now);
+        }
+    }
+    prof_mutex_unlock(&sched->group_lock);
+}
+
+/* A cheap, thread-safe pseudo-random CPU number for placement and stealing */
+static unsigned int random_cpu(void)
+{
+    uint64_t z = __atomic_add_fetch(&sched->rng, 0x9e3779b97f4a7c15ull,
+        __ATOMIC_RELAXED);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (unsigned int)((z ^ (z >> 31)) % sched->cpu_count);
+}
+
+/* rq_push() and rq_pop() must be called with rq->lock held */
+static void rq_push(runqueue_t *rq, pcb_t *pcb)
+{
+    sched->info[pcb->pid].seq = __atomic_fetch_add(&sched->enqueue_seq, 1,
+        __ATOMIC_RELAXED);
+    sched->policy->push(rq, pcb);
+    __atomic_store_n(&rq->size, rq->size + 1, __ATOMIC_RELAXED);
+}
+
+static pcb_t *rq_pop(runqueue_t *rq)
+{
+    pcb_t *pcb = sched->policy->pop(rq);
+    if (pcb) {
+        __atomic_store_n(&rq->size, rq->size - 1, __ATOMIC_RELAXED);
+    }
+    return pcb;
+}
 
-typedef enum {
-    FIFO,
-    ROUND_ROBIN,
-    SRTF
-} scheduler;
-static pcb_t **current;
-static pthread_mutex_t current_mutex;
-static pcb_t *queue_head;
-static pthread_mutex_t mutex;
-static pthread_cond_t cond;
-static scheduler algorithm;
-static int time_slice;
-static unsigned int srtf;
+/* idle_add() and idle_remove() must be called with idle_lock held */
+static void idle_add(unsigned int cpu_id)
+{
+    sched->cpus[cpu_id].idle_pos = sched->idle_count;
+    sched->idle_stack[sched->idle_count++] = cpu_id;
+    __atomic_store_n(&sched->cpus[cpu_id].idle, 1, __ATOMIC_RELAXED);
+}
+
+static void idle_remove(unsigned int cpu_id)
+{
+    unsigned int last = sched->idle_stack[--sched->idle_count];
+    sched->idle_stack[sched->cpus[cpu_id].idle_pos] = last;
+    sched->cpus[last].idle_pos = sched->cpus[cpu_id].idle_pos;
+    __atomic_store_n(&sched->cpus[cpu_id].idle, 0, __ATOMIC_RELAXED);
+}
+
+/*
+ * A woken process leaves its last CPU's queue for another only if that one is
+ * shorter by more than this.
+ */
+#define BALANCE_SLACK 2
+
+/* How far a process would move going from CPU a to CPU b */
+static migration_t distance(unsigned int a, unsigned int b)
+{
+    return topology_migration(&sched->topology, sched->cpu_count, a, b);
+}
+
+/*
+ * nearest_idle() picks the idle CPU closest to hint, or the most recently
+ * idled one if there is no hint.  Call with idle_lock held and at least one
+ * CPU idle.
+ */
+static unsigned int nearest_idle(int hint)
+{
+    unsigned int best = sched->idle_stack[sched->idle_count - 1];
+    if (hint < 0 || topology_is_flat(&sched->topology)) {
+        return best;
+    }
+    for (unsigned int i = sched->idle_count; i-- > 0;) {
+        unsigned int cpu = sched->idle_stack[i];
+        if (distance((unsigned int) hint, cpu) <
+                distance((unsigned int) hint, best)) {
+            best = cpu;
+        }
+        if (distance((unsigned int) hint, best) <= MIGRATE_CORE) {
+            break;
+        }
+    }
+    return best;
+}
+
+/*
+ * steal() takes a process from another CPU's run queue, starting the search
+ * at a random victim so idle CPUs don't all pile onto the same one.  Empty
+ * queues are skipped without taking their lock.  Victims in the thief's own
+ * cache domain are tried first, then its node, then the other nodes.
+ */
+static pcb_t *steal(unsigned int cpu_id)
+{
+    unsigned int start = random_cpu();
+    migration_t farthest = topology_is_flat(&sched->topology) ?
+        MIGRATE_CORE : MIGRATE_NODE;
+    for (unsigned int n = 0;
+         n < sched->cpu_count * (unsigned int) farthest; n++) {
+        unsigned int victim = (start + n) % sched->cpu_count;
+        migration_t level =
+            (migration_t) (MIGRATE_CORE + n / sched->cpu_count);
+        pcb_t *pcb;
+        if (victim == cpu_id || rq_size(&sched->runqueues[victim]) == 0 ||
+                distance(cpu_id, victim) != level) {
+            continue;
+        }
+        prof_mutex_lock(&sched->runqueues[victim].lock);
+        pcb = rq_pop(&sched->runqueues[victim]);
+        prof_mutex_unlock(&sched->runqueues[victim].lock);
+        if (pcb && sched->policy->migrate) {
+            sched->policy->migrate(pcb, &sched->runqueues[victim],
+                rq_of(cpu_id));
+        }
+        if (pcb) {
+            sched->cpus[cpu_id].steals++;
+            return pcb;
+        }
+    }
+    return NULL;
+}
+
+/* Whether this CPU could find anything to run, by its own queue or stealing */
+static int work_available(unsigned int cpu_id)
+{
+    if (rq_size(rq_of(cpu_id)) > 0) {
+        return 1;
+    }
+    for (unsigned int i = 0; sched->per_cpu && i < sched->cpu_count; i++) {
+        if (rq_size(&sched->runqueues[i]) > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
 /*
  * schedule() is your CPU scheduler.  It should perform the following tasks:
@@ -60,7 +505,7 @@ static unsigned int srtf;
  *   3. Call context_switch(), to tell the simulator which process to execute
  *      next on the CPU.  If no process is runnable, call context_switch()
  *      with a pointer to NULL to select the idle process.
- *	The current array (see above) is how you access the currently running process indexed by the cpu id.
+ *	sched->cpus[cpu_id].current (see above) is the process running on a CPU.
  *	See above for full description.
  *	context_switch() is prototyped in os-sim.h. Look there for more information
  *	about it and its parameters.
@@ -68,19 +513,42 @@ static unsigned int srtf;
 static void schedule(unsigned int cpu_id)
 {
     pcb_t* pcb;
-    if (algorithm != SRTF) {
-        pcb = dequeue();
+    int quantum = 0;
+    if (sched->policy->pick) {
+        sched->policy->pick();
+    }
+    /* Skip over processes whose group is out of quota, parking them */
+    do {
+        pcb = dequeue(cpu_id);
+        if (pcb) {
+            quantum = quantum_for(cpu_id, pcb);
+        }
+    } while (pcb && sched->bandwidth &&
+             !group_dispatch(cpu_id, pcb, &quantum));
+    sched->cpus[cpu_id].forced = 0;
+    if (pcb) {
+        if (pcb->last_cpu >= 0 && (unsigned int) pcb->last_cpu != cpu_id) {
+            sched->cpus[cpu_id].migrations++;
+        }
+        pcb->last_cpu = (int) cpu_id;
+        sched->info[pcb->pid].dispatched = get_simulator_time();
+        pcb->state = PROCESS_RUNNING;
+    }
+    if (preemptive()) {
+        prof_mutex_lock(&sched->running_lock);
+        sched->cpus[cpu_id].current = pcb;
+        if (heap_contains(&sched->running_heap, cpu_id))
+            heap_remove(&sched->running_heap, cpu_id);
+        if (pcb)
+            heap_push(&sched->running_heap, cpu_id);
+        prof_mutex_unlock(&sched->running_lock);
     } else {
-        pcb = other_dequeue();
+        sched->cpus[cpu_id].current = pcb;
     }
-    pthread_mutex_lock(&current_mutex);
-    current[cpu_id] = pcb;
-    pthread_mutex_unlock(&current_mutex);
     if (pcb) {
-    	pcb->state = PROCESS_RUNNING;
-        context_switch(cpu_id, pcb, time_slice);
+        context_switch(cpu_id, pcb, quantum);
     } else {
-        context_switch(cpu_id, NULL, time_slice);
+        context_switch(cpu_id, NULL, sched->time_slice);
     }
 }
 
@@ -93,15 +561,120 @@ static void schedule(unsigned int cpu_id)
  */
 extern void idle(unsigned int cpu_id)
 {
-    /* FIX ME */
-    pthread_mutex_lock(&mutex);
-    while(!queue_head) {
-        pthread_cond_wait(&cond, &mutex);
+    runqueue_t *rq;
+
+    sched = simulator_scheduler();
+    rq = rq_of(cpu_id);
+
+    /* GANG dispatches onto idle CPUs itself, so they only wait for it */
+    if (sched->policy->place_wake) {
+        if (!sched->deterministic) {
+            prof_mutex_lock(&rq->lock);
+            while (sched->cpus[cpu_id].current == NULL && !sched->stopping) {
+                prof_cond_wait(&rq->wakeup, &rq->lock);
+            }
+            prof_mutex_unlock(&rq->lock);
+        }
+        return;
+    }
+
+    if (sched->deterministic) {
+        if (!__atomic_load_n(&sched->stopping, __ATOMIC_RELAXED) &&
+            (sched->lock_free ? !pcb_mpmc_empty(&sched->ready_ring) :
+             work_available(cpu_id))) {
+            schedule(cpu_id);
+        }
+        return;
+    }
+
+    if (!sched->per_cpu) {
+        int stopping;
+        prof_mutex_lock(&rq->lock);
+        if (sched->lock_free) {
+            __atomic_add_fetch(&sched->idle_waiters, 1, __ATOMIC_SEQ_CST);
+            while (pcb_mpmc_empty(&sched->ready_ring) && !sched->stopping) {
+                prof_cond_wait(&rq->wakeup, &rq->lock);
+            }
+            __atomic_sub_fetch(&sched->idle_waiters, 1, __ATOMIC_SEQ_CST);
+        } else {
+            while (!rq->size && !sched->stopping) {
+                prof_cond_wait(&rq->wakeup, &rq->lock);
+            }
+        }
+        stopping = sched->stopping;
+        prof_mutex_unlock(&rq->lock);
+        if (!stopping) {
+            schedule(cpu_id);
+        }
+        return;
+    }
+
+    /*
+     * Go on the idle stack, then look once more: anything enqueued before we
+     * got on the stack is visible now, and anything after will be handed to
+     * us directly.
+     */
+    while (!work_available(cpu_id)) {
+        prof_mutex_lock(&sched->idle_lock);
+        idle_add(cpu_id);
+        prof_mutex_unlock(&sched->idle_lock);
+
+        if (!work_available(cpu_id)) {
+            prof_mutex_lock(&rq->lock);
+            while (!rq->size &&
+                    !__atomic_load_n(&sched->stopping, __ATOMIC_RELAXED) &&
+                    __atomic_load_n(&sched->cpus[cpu_id].idle,
+                    __ATOMIC_RELAXED)) {
+                prof_cond_wait(&rq->wakeup, &rq->lock);
+            }
+            prof_mutex_unlock(&rq->lock);
+        }
+
+        prof_mutex_lock(&sched->idle_lock);
+        if (sched->cpus[cpu_id].idle) {
+            idle_remove(cpu_id);
+        }
+        prof_mutex_unlock(&sched->idle_lock);
+
+        if (__atomic_load_n(&sched->stopping, __ATOMIC_RELAXED)) {
+            return;
+        }
     }
-    pthread_mutex_unlock(&mutex);
     schedule(cpu_id);
 }
 
+/*
+ * stop_idle() wakes every idle CPU for the last time.  stopping is set under
+ * each run queue's lock, so a CPU either sees it before it waits or is woken
+ * by the broadcast.
+ */
+extern void stop_idle(void)
+{
+    sched = simulator_scheduler();
+    for (unsigned int i = 0; i < (sched->per_cpu ? sched->cpu_count : 1);
+         i++) {
+        runqueue_t *rq = &sched->runqueues[i];
+        prof_mutex_lock(&rq->lock);
+        __atomic_store_n(&sched->stopping, 1, __ATOMIC_RELAXED);
+        pthread_cond_broadcast(&rq->wakeup);
+        prof_mutex_unlock(&rq->lock);
+    }
+}
+
+/*
+ * charge() lets the policy and the control groups account for pcb coming off
+ * cpu_id as state.
+ */
+static void charge(unsigned int cpu_id, pcb_t *pcb, process_state_t state)
+{
+    if (sched->policy->leave) {
+        sched->policy->leave(cpu_id, pcb, state);
+    }
+    if (sched->groups.count > 1) {
+        group_charge(cpu_id, pcb);
+    }
+}
+
 /*
  * preempt() is the handler called by the simulator when a process is
  * preempted due to its timeslice expiring.
@@ -111,11 +684,16 @@ extern void idle(unsigned int cpu_id)
  */
 extern void preempt(unsigned int cpu_id)
 {
-    /* FIX ME */
-    pthread_mutex_lock(&current_mutex);
-    current[cpu_id]->state = PROCESS_READY;
-    enqueue(current[cpu_id]);
-    pthread_mutex_unlock(&current_mutex);
+    pcb_t *current;
+    sched = simulator_scheduler();
+    if (sched->policy->place_leave) {
+        sched->policy->place_leave(cpu_id, PROCESS_READY);
+        return;
+    }
+    current = sched->cpus[cpu_id].current;
+    charge(cpu_id, current, PROCESS_READY);
+    leave_cpu(cpu_id, current, PROCESS_READY);
+    enqueue(current, (int) cpu_id);
     schedule(cpu_id);
 }
 
@@ -128,17 +706,16 @@ extern void preempt(unsigned int cpu_id)
  */
 extern void yield(unsigned int cpu_id)
 {
-    pthread_mutex_lock(&current_mutex);
-    current[cpu_id]->state = PROCESS_WAITING;
-    pthread_mutex_unlock(&current_mutex);
+    sched = simulator_scheduler();
+    if (sched->policy->place_leave) {
+        sched->policy->place_leave(cpu_id, PROCESS_WAITING);
+        return;
+    }
+    charge(cpu_id, sched->cpus[cpu_id].current, PROCESS_WAITING);
+    leave_cpu(cpu_id, sched->cpus[cpu_id].current, PROCESS_WAITING);
     schedule(cpu_id);
 }
 
-// preempt, wake up,
-// schedule
-// find the one in ready queue with smallest one
-// whenever waking up process, longest time, don't wake up one
-
 /*
  * terminate() is the handler called by the simulator when a process completes.
  * It should mark the process as terminated, then call schedule() to select
@@ -146,9 +723,19 @@ extern void yield(unsigned int cpu_id)
  */
 extern void terminate(unsigned int cpu_id)
 {
-    pthread_mutex_lock(&current_mutex);
-    current[cpu_id]->state = PROCESS_TERMINATED;
-    pthread_mutex_unlock(&current_mutex);
+    sched = simulator_scheduler();
+    if (sched->policy->place_leave) {
+        sched->policy->place_leave(cpu_id, PROCESS_TERMINATED);
+        return;
+    }
+    charge(cpu_id, sched->cpus[cpu_id].current, PROCESS_TERMINATED);
+    if (sched->info[sched->cpus[cpu_id].current->pid].rt == RT_ADMITTED) {
+        prof_mutex_lock(&sched->rt_lock);
+        sched->rt_density -= rt_density(sched->cpus[cpu_id].current);
+        sched->rt_tasks--;
+        prof_mutex_unlock(&sched->rt_lock);
+    }
+    leave_cpu(cpu_id, sched->cpus[cpu_id].current, PROCESS_TERMINATED);
     schedule(cpu_id);
 }
 
@@ -169,122 +756,824 @@ extern void terminate(unsigned int cpu_id)
  */
 extern void wake_up(pcb_t *process)
 {
+    sched = simulator_scheduler();
+    if (sched->policy->place_wake) {
+        sched->policy->place_wake(process);
+        return;
+    }
     process->state = PROCESS_READY;
-    enqueue(process);
-    if (algorithm == SRTF) {
-        int cpus = 0;
-        pthread_mutex_lock(&current_mutex);
-        for (unsigned int i = 0; i < srtf; i++) {
-            if (!current[i]) {cpus++;}
-        }
-        pthread_mutex_unlock(&current_mutex);
-        if (cpus == 0) {
-            int x = -1;
-            pthread_mutex_lock(&current_mutex);
-            for (unsigned int i = 0; i < srtf; i++) {
-                if (current[i]->time_remaining > process->time_remaining) {
-                    if (x == -1 || current[i]->time_remaining > current[x]->time_remaining) {
-                        x = (int) i;
-                    }
-                }
+    sched->info[process->pid].waking = process->last_cpu >= 0;
+    if (real_time()) {
+        admit(process);
+    }
+    if (sched->policy->wake) {
+        sched->policy->wake(process);
+    }
+    make_runnable(process);
+}
+
+/*
+ * make_runnable() queues a ready process, preempting a CPU for it if the
+ * algorithm says it should run before one of them.
+ */
+static void make_runnable(pcb_t *process)
+{
+    unsigned int x = HEAP_NONE;
+    if (preemptive()) {
+        prof_mutex_lock(&sched->running_lock);
+        /* Only preempt if every CPU is busy */
+        if (sched->running_heap.size == sched->cpu_count) {
+            unsigned int top = heap_top(&sched->running_heap);
+            if (runs_before(process, sched->cpus[top].current)) {
+                x = top;
+                sched->cpus[x].forced = 1;
             }
-            pthread_mutex_unlock(&current_mutex);
-            if (x != -1) {
-                force_preempt((unsigned int)x);
+        }
+        prof_mutex_unlock(&sched->running_lock);
+    }
+    /* Queue it where it will run next: the victim, else where it last ran */
+    enqueue(process, x != HEAP_NONE ? (int) x : process->last_cpu);
+    if (x != HEAP_NONE) {
+        force_preempt(x);
+    }
+}
+
+/*
+ * timer_expired() is called by the simulator at the tick asked for with
+ * set_timer(), which is the end of a throttled group's period.  Groups whose
+ * new period has quota again have their parked processes queued.
+ */
+extern void timer_expired(void)
+{
+    unsigned int now;
+    pcb_queue_t released;
+    pcb_t *pcb;
+
+    sched = simulator_scheduler();
+    now = get_simulator_time();
+    pcb_queue_init(&released);
+    prof_mutex_lock(&sched->group_lock);
+    for (unsigned int g = 0; g < sched->groups.count; g++) {
+        group_state_t *gs = &sched->group_state[g];
+        if (!sched->groups.groups[g].quota) {
+            continue;
+        }
+        group_refresh(g, now);
+        if (gs->throttled) {
+            if (gs->parked.head) {
+                set_timer(gs->period_end);
             }
+            continue;
         }
+        while ((pcb = pcb_queue_pop(&gs->parked)) != NULL) {
+            pcb_queue_push(&released, pcb);
+        }
+    }
+    prof_mutex_unlock(&sched->group_lock);
+
+    while ((pcb = pcb_queue_pop(&released)) != NULL) {
+        make_runnable(pcb);
     }
 }
 
 /*
- * main() simply parses command line arguments, then calls start_simulator().
+ * print_scheduler_stats() is called by the simulator after its own final
+ * statistics.
+ */
+extern void print_scheduler_stats(void)
+{
+    unsigned long steals = 0, migrations = 0, quanta = 0, bursts = 0;
+    unsigned long long quantum_sum = 0;
+    double estimate_error = 0.0;
+    sched = simulator_scheduler();
+    for (unsigned int i = 0; i < sched->cpu_count; i++) {
+        steals += sched->cpus[i].steals;
+        migrations += sched->cpus[i].migrations;
+        quanta += sched->cpus[i].quanta;
+        quantum_sum += sched->cpus[i].quantum_sum;
+        bursts += sched->cpus[i].bursts;
+        estimate_error += sched->cpus[i].estimate_error;
+    }
+    if (sched->per_cpu) {
+        printf("# of Steals: %lu\n", steals);
+        printf("# of Migrations: %lu\n", migrations);
+    }
+    if (sched->adaptive) {
+        printf("Burst estimate error: mean %.2f ticks over %lu bursts\n",
+            bursts ? estimate_error / bursts : 0.0, bursts);
+    }
+    if (quanta) {
+        printf("Adaptive quantum: mean %.2f ticks\n",
+            (double) quantum_sum / quanta);
+    }
+    if (real_time()) {
+        printf("# of Real-Time Tasks Admitted: %lu\n", sched->rt_admitted);
+        printf("# of Real-Time Tasks Rejected: %lu\n", sched->rt_rejected);
+    }
+    if (sched->policy->print_stats) {
+        sched->policy->print_stats();
+    }
+    if (sched->groups.count > 1) {
+        unsigned int now = get_simulator_time();
+        printf("\nControl groups:\n");
+        printf("%-20s %7s %13s %9s %9s %12s\n", "group", "shares",
+            "quota/period", "cpu (s)", "throttles", "throttled (s)");
+        for (unsigned int g = 0; g < sched->groups.count; g++) {
+            const cgroup_t *cg = &sched->groups.groups[g];
+            const group_state_t *gs = &sched->group_state[g];
+            unsigned long long throttled = gs->throttled_time +
+                (gs->throttled ? now - gs->throttled_at : 0);
+            char limit[24];
+            if (cg->quota) {
+                snprintf(limit, sizeof(limit), "%u/%u", cg->quota, cg->period);
+            } else {
+                snprintf(limit, sizeof(limit), "-");
+            }
+            printf("%-20s %7u %13s %9.1f %9lu %12.1f\n", cg->name, cg->shares,
+                limit, gs->usage / 10.0, gs->throttles, throttled / 10.0);
+        }
+    }
+    if (sched->lock_profile) {
+        lock_stats_t rqs = { 0, 0, 0, 0, 0 };
+        unsigned int nr_runqueues = sched->per_cpu ? sched->cpu_count : 1;
+        for (unsigned int i = 0; i < nr_runqueues; i++) {
+            lockprof_add(&rqs, &sched->runqueues[i].lock);
+        }
+        printf("\nScheduler locks:\n");
+        lockprof_print_header(stdout);
+        lockprof_print(stdout, "runqueue", nr_runqueues, &rqs);
+        if (sched->per_cpu) {
+            lockprof_print(stdout, "idle", 1, &sched->idle_lock.stats);
+        }
+        if (preemptive()) {
+            lockprof_print(stdout, "running", 1, &sched->running_lock.stats);
+        }
+    }
+}
+
+extern void scheduler_config_default(scheduler_config_t *config)
+{
+    config->algorithm = FIFO;
+    config->time_slice = -1;
+    config->per_cpu = 0;
+    config->lock_free = 0;
+    config->lock_profile = 0;
+    topology_default(&config->topology);
+    config->deterministic = 0;
+    cgroup_default(&config->groups);
+    config->adaptive = 0;
+    config->adapt_alpha = 0.5;
+    config->adapt_initial = 5;
+    config->adapt_min = 1;
+    config->adapt_max = 20;
+    config->adapt_response = 30;
+    config->share_quantum = 2;
+    config->share_compensation = 1;
+    config->share_seed = 1;
+    config->gang_quantum = 4;
+    config->gang_pack = 1;
+    config->gang_patience = 20;
+    config->mlfq_levels = 3;
+    config->mlfq_quantum[0] = 2;
+    config->mlfq_quantum[1] = 4;
+    config->mlfq_quantum[2] = 8;
+    config->mlfq_boost = 100;
+    config->cfs_latency = 6;
+    config->cfs_granularity = 1;
+}
+
+extern scheduler_t *scheduler_create(const scheduler_config_t *config,
+                                     unsigned int cpu_count,
+                                     pcb_t *table,
+                                     unsigned int count)
+{
+    unsigned int nr_runqueues;
+
+    sched = calloc(1, sizeof(scheduler_t));
+    assert(sched != NULL);
+    sched->algorithm = config->algorithm;
+    sched->time_slice = config->time_slice;
+    sched->per_cpu = config->per_cpu;
+    sched->lock_free = config->lock_free;
+    sched->policy = policy_for(sched->algorithm);
+    sched->lock_profile = config->lock_profile;
+    sched->topology = config->topology;
+    sched->deterministic = config->deterministic;
+    sched->groups = config->groups;
+    sched->bandwidth = cgroup_has_quota(&sched->groups);
+    sched->adaptive = config->adaptive &&
+        (sched->algorithm == ROUND_ROBIN || sched->algorithm == SRTF);
+    sched->adapt_alpha = config->adapt_alpha;
+    sched->adapt_initial = config->adapt_initial;
+    sched->adapt_min = config->adapt_min;
+    sched->adapt_max = config->adapt_max;
+    sched->adapt_response = config->adapt_response;
+    sched->cpu_count = cpu_count;
+    sched->processes = table;
+    sched->process_count = count;
+
+    /*
+     * Only FIFO and round robin take processes in plain arrival order, and
+     * per-CPU queues are locked, so the lock-free ring is only used for those
+     * two on one queue.
+     */
+    if ((sched->algorithm != FIFO && sched->algorithm != ROUND_ROBIN) ||
+        sched->per_cpu)
+        sched->lock_free = 0;
+
+    /* GANG places jobs across all CPUs at once, from one queue */
+    if (sched->policy->place_leave)
+        sched->per_cpu = 0;
+
+    /* Allocate the run queues and per-CPU state */
+    nr_runqueues = sched->per_cpu ? cpu_count : 1;
+    if (posix_memalign((void**)&sched->runqueues, CACHE_LINE_SIZE,
+            sizeof(runqueue_t) * nr_runqueues) != 0)
+        sched->runqueues = NULL;
+    if (posix_memalign((void**)&sched->cpus, CACHE_LINE_SIZE,
+            sizeof(cpu_info_t) * cpu_count) != 0)
+        sched->cpus = NULL;
+    sched->idle_stack = malloc(sizeof(unsigned int) * cpu_count);
+    assert(sched->runqueues != NULL && sched->cpus != NULL &&
+        sched->idle_stack != NULL);
+    memset(sched->runqueues, 0, sizeof(runqueue_t) * nr_runqueues);
+    memset(sched->cpus, 0, sizeof(cpu_info_t) * cpu_count);
+    for (unsigned int i = 0; i < cpu_count; i++)
+        sched->cpus[i].slot = -1;
+    prof_mutex_init(&sched->idle_lock, sched->lock_profile);
+    sched->info = calloc(count, sizeof(proc_info_t));
+    assert(sched->info != NULL);
+    for (unsigned int i = 0; i < count; i++)
+        sched->info[i].estimate = sched->adapt_initial;
+    if (sched->policy->create)
+        sched->policy->create(config);
+    if (uses_heap())
+        sched->heap_pos = heap_pos_alloc(count);
+    for (unsigned int i = 0; i < nr_runqueues; i++)
+    {
+        runqueue_t *rq = &sched->runqueues[i];
+        prof_mutex_init(&rq->lock, sched->lock_profile);
+        pthread_cond_init(&rq->wakeup, NULL);
+        pcb_queue_init(&rq->queue);
+        if (uses_heap())
+            heap_init_shared(&rq->heap, count, ready_less,
+                sched->heap_pos);
+        if (sched->policy->rq_init)
+            sched->policy->rq_init(rq, i);
+        rq->size = 0;
+    }
+    if (preemptive())
+        heap_init(&sched->running_heap, cpu_count, running_less);
+    if (sched->lock_free)
+        pcb_mpmc_init(&sched->ready_ring, count);
+    prof_mutex_init(&sched->running_lock, sched->lock_profile);
+    prof_mutex_init(&sched->rt_lock, sched->lock_profile);
+
+    sched->group_state = calloc(sched->groups.count, sizeof(group_state_t));
+    assert(sched->group_state != NULL);
+    for (unsigned int g = 0; g < sched->groups.count; g++)
+    {
+        sched->group_state[g].runtime = sched->groups.groups[g].quota;
+        sched->group_state[g].period_end = sched->groups.groups[g].period;
+        pcb_queue_init(&sched->group_state[g].parked);
+    }
+    prof_mutex_init(&sched->group_lock, sched->lock_profile);
+    return sched;
+}
+
+extern void scheduler_destroy(scheduler_t *s)
+{
+    unsigned int nr_runqueues = s->per_cpu ? s->cpu_count : 1;
+
+    for (unsigned int i = 0; i < nr_runqueues; i++)
+    {
+        runqueue_t *rq = &s->runqueues[i];
+        prof_mutex_destroy(&rq->lock);
+        pthread_cond_destroy(&rq->wakeup);
+        if (s->heap_pos != NULL)
+            heap_free(&rq->heap);
+        if (s->policy->rq_free)
+            s->policy->rq_free(rq);
+    }
+    if (s->running_heap.pos != NULL)
+        heap_free(&s->running_heap);
+    if (s->lock_free)
+        pcb_mpmc_free(&s->ready_ring);
+    prof_mutex_destroy(&s->idle_lock);
+    prof_mutex_destroy(&s->running_lock);
+    prof_mutex_destroy(&s->rt_lock);
+    prof_mutex_destroy(&s->group_lock);
+    if (s->policy->destroy)
+        s->policy->destroy(s);
+    free(s->group_state);
+    free(s->heap_pos);
+    free(s->runqueues);
+    free(s->cpus);
+    free(s->idle_stack);
+    free(s->info);
+    if (sched == s)
+        sched = NULL;
+    free(s);
+}
+
+static void print_comparison(const char *label, const simulator_results_t *r)
+{
+    printf("  %-9s %9u %11.2f %11.1f %11.1f\n", label, r->context_switches,
+        r->total_time ? r->context_switches / (r->total_time / 10.0) : 0.0,
+        r->metrics.response / 10.0, r->metrics.turnaround / 10.0);
+}
+
+/*
+ * compare_baseline() quietly reruns the workload in table without -a and
+ * prints the adaptive run's context switch rate next to the baseline's.
+ */
+static int compare_baseline(const scheduler_config_t *config,
+                            const simulator_config_t *sim_config,
+                            pcb_t *table, unsigned int count,
+                            const simulator_results_t *adaptive)
+{
+    scheduler_config_t base_config = *config;
+    simulator_config_t base_sim = *sim_config;
+    simulator_results_t base;
+    scheduler_t *scheduler;
+    int ret;
+
+    base_config.adaptive = 0;
+    base_sim.quiet = 1;
+    base_sim.csv_path = NULL;
+    base_sim.event_log_path = NULL;
+    base_sim.replay_path = NULL;
+    scheduler = scheduler_create(&base_config, base_sim.cpu_count, table,
+        count);
+    ret = simulator_run(&base_sim, table, count, scheduler, &base);
+    scheduler_destroy(scheduler);
+    if (ret != 0)
+        return -1;
+
+    if (config->algorithm == ROUND_ROBIN)
+        printf("\nAdaptive quanta against a fixed quantum of %d:\n",
+            config->time_slice);
+    else
+        printf("\nEstimated against true time remaining:\n");
+    printf("  %-9s %9s %11s %11s %11s\n", "", "switches", "switches/s",
+        "response", "turnaround");
+    print_comparison("adaptive", adaptive);
+    print_comparison("baseline", &base);
+    return 0;
+}
+
+/*
+ * main() simply parses command line arguments, then runs the simulator.
  * You will need to modify it to support the -r and -s command-line parameters.
  */
 int main(int argc, char *argv[])
 {
+    unsigned int count = 8;
+    const char *workload = NULL, *save_path = NULL, *sweep = NULL;
+    workload_params_t params;
+    scheduler_config_t config;
+    simulator_config_t sim_config;
+    scheduler_t *scheduler;
+    simulator_results_t results;
+    pcb_t *baseline = NULL;
+    int generate = 0, save_binary = 0, bad_args = 0;
+    int opt, ret;
+
     /* Parse command-line arguments */
-    unsigned int cpu_count = strtoul(argv[1], NULL, 0);
-    srtf = cpu_count;
-    if (argc < 2 || argc > 5)
+    scheduler_config_default(&config);
+    simulator_config_default(&sim_config);
+    workload_params_default(&params);
+    while ((opt = getopt(argc, argv, "r:spm:c:DRt:j:a:LPn:w:g:o:O:x:i:qe:d:y:kT:G:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            config.algorithm = ROUND_ROBIN;
+            config.time_slice = (int) strtol(optarg, NULL, 10);
+            break;
+        case 's':
+            config.algorithm = SRTF;
+            config.time_slice = -1;
+            break;
+        case 'p':
+            config.algorithm = PRIORITY;
+            config.time_slice = -1;
+            break;
+        case 'D':
+            config.algorithm = EDF;
+            config.time_slice = -1;
+            break;
+        case 'R':
+            config.algorithm = RATE_MONOTONIC;
+            config.time_slice = -1;
+            break;
+        case 'm':
+            if (scheduler_parse_mlfq(&config, optarg) != 0)
+                return -1;
+            break;
+        case 'c':
+            if (scheduler_parse_cfs(&config, optarg) != 0)
+                return -1;
+            break;
+        case 't':
+            if (scheduler_parse_share(&config, optarg) != 0)
+                return -1;
+            break;
+        case 'j':
+            if (scheduler_parse_gang(&config, optarg) != 0)
+                return -1;
+            break;
+        case 'a':
+            if (scheduler_parse_adaptive(&config, optarg) != 0)
+                return -1;
+            break;
+        case 'L':
+            config.lock_free = 1;
+            break;
+        case 'P':
+            config.per_cpu = 1;
+            break;
+        case 'n':
+            count = (unsigned int) strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            workload = optarg;
+            break;
+        case 'g':
+            generate = 1;
+            if (workload_parse_params(optarg, &params) != 0)
+                return -1;
+            break;
+        case 'o':
+        case 'O':
+            save_path = optarg;
+            save_binary = (opt == 'O');
+            break;
+        case 'x':
+            sim_config.csv_path = optarg;
+            break;
+        case 'i':
+            if (simulator_parse_io(&sim_config, optarg) != 0)
+                return -1;
+            break;
+        case 'q':
+            sim_config.headless = 1;
+            break;
+        case 'e':
+            sim_config.event_log_path = optarg;
+            break;
+        case 'd':
+            config.deterministic = 1;
+            sim_config.deterministic = 1;
+            sim_config.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'y':
+            config.deterministic = 1;
+            sim_config.replay_path = optarg;
+            break;
+        case 'k':
+            config.lock_profile = 1;
+            sim_config.lock_profile = 1;
+            break;
+        case 'T':
+            if (topology_parse(&sim_config.topology, optarg) != 0)
+                return -1;
+            config.topology = sim_config.topology;
+            break;
+        case 'G':
+            if (cgroup_parse(&config.groups, optarg) != 0)
+                return -1;
+            break;
+        case 'S':
+            sweep = optarg;
+            break;
+        default:
+            bad_args = 1;
+            break;
+        }
+    }
+    if (bad_args || (optind != argc - 1 &&
+        !((save_path != NULL || sweep != NULL) && optind == argc)))
     {
         fprintf(stderr, "CS 2200 OS Sim -- Multithreaded OS Simulator\n"
-            "Usage: ./os-sim <# CPUs> [ -r <time slice> | -s ]\n"
+            "Usage: ./os-sim <# CPUs> [ -r <time slice> | -s | -p | -m <spec> |\n"
+            "                  -c <spec> | -D | -R | -t <spec> | -j <spec> ]\n"
+            "                [ -a <spec> ] [ -L | -P ]\n"
+            "                [ -n <# processes> | -w <workload> | -g <spec> ]\n"
+            "                [ -o <text file> | -O <binary file> ]\n"
+            "                [ -i <spec> ] [ -x <csv file> ] [ -q ]\n"
+            "                [ -e <event log> ] [ -d <seed> | -y <event log> ]\n"
+            "                [ -k ] [ -T <spec> ] [ -G <spec> ]\n"
+            "       ./os-sim -S <spec> [ options as above ]\n"
             "    Default : FIFO Scheduler\n"
             "         -r : Round-Robin Scheduler\n"
-            "         -s : Shortest Remaining Time First Scheduler\n\n");
+            "         -s : Shortest Remaining Time First Scheduler\n"
+            "         -p : Preemptive Static Priority Scheduler\n"
+            "         -m : Multi-Level Feedback Queue Scheduler, e.g.\n"
+            "              levels=3,quanta=2:4:8,boost=100 (or -m default)\n"
+            "         -c : Completely Fair Scheduler, e.g.\n"
+            "              latency=6,granularity=1 (or -c default)\n"
+            "         -D : Earliest Deadline First for real-time tasks\n"
+            "         -R : Rate-Monotonic for real-time tasks\n"
+            "         -t : Proportional share by nice weight, e.g.\n"
+            "              lottery|stride,quantum=2,compensation=1,seed=1\n"
+            "              (compensation tickets in place of ticket transfer)\n"
+            "         -j : Gang scheduling of the gang workload attribute's\n"
+            "              jobs, e.g. quantum=4,policy=fifo|pack,patience=20\n"
+            "              (or -j default)\n"
+            "         -a : Estimate CPU bursts: with -r, size each quantum to\n"
+            "              the expected burst and compare against the fixed\n"
+            "              quantum; with -s, order by estimate rather than the\n"
+            "              true time remaining, e.g. alpha=0.5,initial=5,min=1,\n"
+            "              max=20,response=30 (or -a default)\n"
+            "         -L : Lock-free ready queue (FIFO and Round-Robin only)\n"
+            "         -P : Per-CPU run queues with work stealing\n"
+            "         -n : Repeat the built-in processes (default 8)\n"
+            "         -w : Load a text or binary workload file\n"
+            "         -g : Generate a workload, e.g. n=1000,seed=7,arrival=5,\n"
+            "              bursts=10,mix=0.3,dist=exp|pareto,cpu=8,io=2,priorities=4,\n"
+            "              devices=0\n"
+            "      -o/-O : Save the workload as text/binary and exit\n"
+            "         -i : I/O devices, e.g. devices=4,policy=fifo|sjf|deadline,\n"
+            "              deadline=20\n"
+            "         -x : Write per-process metrics to a CSV file\n"
+            "         -q : Headless: no Gantt chart, no pause between ticks\n"
+            "         -e : Log scheduling events to a binary file\n"
+            "         -d : Deterministic: the same seed always gives the same run\n"
+            "         -y : Replay a run logged with -d and -e, checking that\n"
+            "              every event matches; give the same options\n"
+            "         -k : Report lock contention with the final statistics\n"
+            "         -T : CPU topology and migration penalties in ticks, e.g.\n"
+            "              nodes=2,llcs=2,core=0,llc=1,node=4; with -P, placement\n"
+            "              and stealing prefer nearby CPUs\n"
+            "         -G : Control groups for the group workload attribute, e.g.\n"
+            "              web:shares=2048;batch:quota=50,period=100;batch/etl\n"
+            "              (shares apply to -c, quotas to every scheduler)\n"
+            "         -S : Run a parameter sweep in parallel, e.g.\n"
+            "              cpus=1:2:4,algo=fifo:rr:srtf,quantum=2:4,\n"
+            "              workload=a.txt:b.bin,jobs=8,csv=out.csv\n\n");
         return -1;
-    } else if (argc == 3) {
-    	if (strcmp(argv[2], "-s") == 0) {
-            algorithm = SRTF;
-            time_slice = -1;
-        }
-    } else if (argc == 4) {
-    	if (strcmp(argv[2], "-r") == 0) {
-            algorithm = ROUND_ROBIN;
-            time_slice = (int) strtol(argv[3], NULL, 10);
-        }
-    } else if (argc == 2) {
-    	algorithm = FIFO;
-        time_slice = -1;
-    }
-    /* Allocate the current[] array and its mutex */
-    current = malloc(sizeof(pcb_t*) * cpu_count);
-    assert(current != NULL);
-    pthread_mutex_init(&current_mutex, NULL);
+    }
+
+    /* Build the process table */
+    if (workload != NULL)
+    {
+        if (workload_load(workload) != 0)
+            return -1;
+    }
+    else if (generate)
+        workload_generate(&params);
+    else
+        process_init_default(count);
+
+    if (save_path != NULL)
+        return workload_save(save_path, save_binary) == 0 ? 0 : -1;
+
+    for (unsigned int n = 0; n < process_count; n++)
+    {
+        if (processes[n].group >= config.groups.count)
+        {
+            fprintf(stderr, "Process %u is in group %u, but only %u groups "
+                "are defined (-G)\n", n, processes[n].group,
+                config.groups.count);
+            return -1;
+        }
+    }
+
+    if (sweep != NULL)
+        return sweep_run(sweep, &config, &sim_config) == 0 ? 0 : -1;
+
+    sim_config.cpu_count = (unsigned int) strtoul(argv[optind], NULL, 0);
+    if (sim_config.cpu_count < 1 || sim_config.cpu_count > MAX_CPU_COUNT)
+    {
+        fprintf(stderr, "CPU Count must be an integer from 1 to %d!\n\n",
+            MAX_CPU_COUNT);
+        return -1;
+    }
+
+    if (config.algorithm == GANG && cgroup_has_quota(&config.groups))
+    {
+        fprintf(stderr, "-j does not enforce control group quotas\n");
+        return -1;
+    }
+
+    if (config.adaptive && config.algorithm != ROUND_ROBIN &&
+        config.algorithm != SRTF)
+    {
+        fprintf(stderr, "-a works with -r or -s only\n");
+        return -1;
+    }
+
+    /* With -a, a pristine copy of the workload is kept for the baseline */
+    if (config.adaptive)
+        baseline = process_table_clone(processes, process_count);
+
     /* Start the simulator in the library */
-    start_simulator(cpu_count);
-    return 0;
+    scheduler = scheduler_create(&config, sim_config.cpu_count, processes,
+        process_count);
+    ret = simulator_run(&sim_config, processes, process_count, scheduler,
+        &results);
+    scheduler_destroy(scheduler);
+    if (baseline != NULL)
+    {
+        if (ret == 0)
+            ret = compare_baseline(&config, &sim_config, baseline,
+                process_count, &results);
+        process_table_free(baseline);
+    }
+    return ret == 0 ? 0 : -1;
 }
 
-void enqueue(pcb_t *proc_to_add) {
-    pthread_mutex_lock(&mutex);
-    pcb_t *head = queue_head;
-    if (head) {
-    	while(head->next != NULL) {
-            head = head->next;
+/*
+ * enqueue() makes a process runnable.  cpu_hint is the CPU it should
+ * preferably run on, or -1; a process with an affinity uses that instead.
+ * With per-CPU run queues an idle CPU always wins, the hinted one if it is
+ * idle, and only that CPU is woken.
+ */
+void enqueue(pcb_t *proc_to_add, int cpu_hint) {
+    runqueue_t *rq;
+    int target = proc_to_add->affinity >= 0 ?
+        proc_to_add->affinity % (int) sched->cpu_count : cpu_hint;
+    int kick = 0;
+
+    if (sched->lock_free) {
+        int pushed = pcb_mpmc_push(&sched->ready_ring, proc_to_add);
+        assert(pushed == 0);
+        (void) pushed;
+        /* Pairs with the increment in idle() */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sched->idle_waiters, __ATOMIC_SEQ_CST) > 0) {
+            rq = &sched->runqueues[0];
+            prof_mutex_lock(&rq->lock);
+            pthread_cond_signal(&rq->wakeup);
+            prof_mutex_unlock(&rq->lock);
+        }
+        return;
+    }
+
+    if (sched->per_cpu) {
+        prof_mutex_lock(&sched->idle_lock);
+        if (sched->idle_count > 0) {
+            if (target < 0 || !sched->cpus[target].idle) {
+                target = (int) nearest_idle(target);
+            }
+            idle_remove((unsigned int) target);
+            kick = 1;
+        }
+        prof_mutex_unlock(&sched->idle_lock);
+
+        /* Nobody idle and no preference: the shorter of two random queues */
+        if (target < 0) {
+            unsigned int a = random_cpu(), b = random_cpu();
+            target = (int) (rq_size(&sched->runqueues[a]) <=
+                rq_size(&sched->runqueues[b]) ? a : b);
+        } else if (!kick && !topology_is_flat(&sched->topology) &&
+                proc_to_add->affinity < 0) {
+            /*
+             * Stay with the cache that is still warm unless its queue is
+             * clearly longer than some other CPU's, which evens out load
+             * across nodes over time.
+             */
+            unsigned int other = random_cpu();
+            if (rq_size(&sched->runqueues[other]) + BALANCE_SLACK <
+                    rq_size(&sched->runqueues[target])) {
+                target = (int) other;
+            }
         }
-        head->next = proc_to_add;
-    } else {
-        queue_head = proc_to_add;
     }
-    pthread_cond_signal(&cond);
-    pthread_mutex_unlock(&mutex);
+
+    rq = rq_of(target < 0 ? 0 : (unsigned int) target);
+    prof_mutex_lock(&rq->lock);
+    rq_push(rq, proc_to_add);
+    if (kick || !sched->per_cpu) {
+        pthread_cond_signal(&rq->wakeup);
+    }
+    prof_mutex_unlock(&rq->lock);
 }
 
-pcb_t* dequeue() {
-    pthread_mutex_lock(&mutex);
-    pcb_t *head = queue_head;
-    if (queue_head) {
-        queue_head = head->next;
-        head->next = NULL;
+/*
+ * dequeue() picks the next process for a CPU from its run queue, stealing
+ * from another CPU's if its own is empty.
+ */
+pcb_t* dequeue(unsigned int cpu_id) {
+    runqueue_t *rq = rq_of(cpu_id);
+    pcb_t *pcb;
+    if (sched->lock_free) {
+        return pcb_mpmc_pop(&sched->ready_ring);
     }
-    pthread_mutex_unlock(&mutex);
-    return head;
+    prof_mutex_lock(&rq->lock);
+    pcb = rq_pop(rq);
+    prof_mutex_unlock(&rq->lock);
+    if (!pcb && sched->per_cpu) {
+        pcb = steal(cpu_id);
+    }
+    return pcb;
 }
 
-pcb_t* other_dequeue() {
-    pthread_mutex_lock(&mutex);
-    pcb_t *first = queue_head;
-    pcb_t *second = queue_head;
-    if (first != NULL) {
-        while (second != NULL) {
-            if (second->time_remaining < first->time_remaining) {
-                first = second;
+/*
+ * runs_before() is the ordering for heap-based and preemptive algorithms:
+ * the policy's own if it has one (MLFQ and STRIDE), else shortest remaining
+ * time for SRTF and lowest priority value for PRIORITY.  EDF and
+ * RATE_MONOTONIC put admitted real-time tasks first, by earliest job deadline
+ * or shortest period.  Equal processes go in enqueue order.
+ */
+static int runs_before(const pcb_t *a, const pcb_t *b) {
+    if (sched->policy->runs_before) {
+        return sched->policy->runs_before(a, b);
+    }
+    switch (sched->algorithm) {
+    case SRTF:
+        if (sched->adaptive) {
+            double pa = predicted_remaining(a), pb = predicted_remaining(b);
+            if (pa != pb) {
+                return pa < pb;
             }
-            second = second->next;
+            break;
+        }
+        if (a->time_remaining != b->time_remaining) {
+            return a->time_remaining < b->time_remaining;
+        }
+        break;
+    case PRIORITY:
+        if (a->priority != b->priority) {
+            return a->priority < b->priority;
+        }
+        break;
+    case EDF:
+    case RATE_MONOTONIC: {
+        int ra = sched->info[a->pid].rt == RT_ADMITTED;
+        int rb = sched->info[b->pid].rt == RT_ADMITTED;
+        if (ra != rb) {
+            return ra;
+        }
+        if (ra && sched->algorithm == EDF &&
+                a->job_deadline != b->job_deadline) {
+            return a->job_deadline < b->job_deadline;
         }
-        second = queue_head;
-        if (second == first) {
-            queue_head = first->next;
-            first->next = NULL;
+        if (ra && sched->algorithm == RATE_MONOTONIC &&
+                a->period != b->period) {
+            return a->period < b->period;
+        }
+        break;
+    }
+    default:
+        return 0;
+    }
+    return sched->info[a->pid].seq < sched->info[b->pid].seq;
+}
+
+static int ready_less(unsigned int a, unsigned int b) {
+    return runs_before(&sched->processes[a], &sched->processes[b]);
+}
+
+/* The running process that should be preempted first is on top */
+static int running_less(unsigned int a, unsigned int b) {
+    return runs_before(sched->cpus[b].current, sched->cpus[a].current);
+}
+
+extern int scheduler_parse_adaptive(scheduler_config_t *config,
+                                    const char *spec) {
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+    assert(copy != NULL);
+    config->adaptive = 1;
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(tok, '=');
+        double n;
+        if (strcmp(tok, "default") == 0) {
+            continue;
+        }
+        if (value == NULL) {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        n = strtod(value, &end);
+        if (*end != '\0' || end == value) {
+            ret = -1;
+        } else if (strcmp(tok, "alpha") == 0 && n > 0 && n <= 1) {
+            config->adapt_alpha = n;
+        } else if (n < 1 || n > 1000000 || n != (unsigned int) n) {
+            ret = -1;
+        } else if (strcmp(tok, "initial") == 0) {
+            config->adapt_initial = (unsigned int) n;
+        } else if (strcmp(tok, "min") == 0) {
+            config->adapt_min = (unsigned int) n;
+        } else if (strcmp(tok, "max") == 0) {
+            config->adapt_max = (unsigned int) n;
+        } else if (strcmp(tok, "response") == 0) {
+            config->adapt_response = (unsigned int) n;
         } else {
-            while (second->next != first) {
-                second = second->next;
-            }
-            second->next = second->next->next;
-            first->next = NULL;
+            ret = -1;
         }
     }
-    pthread_mutex_unlock(&mutex);
-    return first;
-}
\ No newline at end of file
+    free(copy);
+    if (config->adapt_min > config->adapt_max) {
+        ret = -1;
+    }
+    if (ret != 0) {
+        fprintf(stderr, "Bad adaptive spec '%s'\n", spec);
+    }
+    return ret;
+}
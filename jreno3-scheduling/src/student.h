@@ -2,13 +2,13 @@
  * student.h
  * Multithreaded OS Simulation for CS 2200
  *
- * YOU WILL NOT NEED TO MODIFY THIS FILE
- *
+ * The scheduler's handlers and their configuration.
  */
 
 #ifndef __STUDENT_H__
 #define __STUDENT_H__
 
+#include "cgroup.h"
 #include "os-sim.h"
 
 /* Function declarations */
@@ -18,4 +18,148 @@ extern void yield(unsigned int cpu_id);
 extern void terminate(unsigned int cpu_id);
 extern void wake_up(pcb_t *process);
 
+/* timer_expired() is called by the simulator when a set_timer() tick comes */
+extern void timer_expired(void);
+extern void print_scheduler_stats(void);
+
+/*
+ * stop_idle() is called by the simulator once every process has terminated.
+ * It makes every CPU blocked in idle() return without scheduling, as will
+ * any later call to idle().
+ */
+extern void stop_idle(void);
+
+
+typedef enum {
+    FIFO,
+    ROUND_ROBIN,
+    SRTF,
+    PRIORITY,
+    MLFQ,
+    CFS,
+    EDF,
+    RATE_MONOTONIC,
+    LOTTERY,
+    STRIDE,
+    GANG
+} algorithm_t;
+
+#define MLFQ_MAX_LEVELS 32
+
+/*
+ * Scheduler settings.
+ *
+ *   algorithm : the scheduling policy
+ *   time_slice : round robin quantum in ticks, -1 for none
+ *   per_cpu : per-CPU run queues with work stealing (-P)
+ *   lock_free : lock-free shared run queue (-L, FIFO and round robin only)
+ *   lock_profile : report the scheduler's lock contention (-k, lockprof.h)
+ *   topology : CPU layout, which per-CPU placement and stealing take into
+ *        account (-T, topology.h)
+ *   deterministic : idle() never blocks, as the simulator's deterministic
+ *        mode requires (-d, -y)
+ *   groups : control groups, whose shares CFS honours and whose quotas every
+ *        algorithm enforces (-G, cgroup.h)
+ *   adaptive, adapt_* : estimate each process's next CPU burst, and size
+ *        round robin quanta or order SRTF by the estimate (-a, see
+ *        scheduler_parse_adaptive())
+ *   share_quantum, share_compensation, share_seed : lottery and stride
+ *        scheduling, see scheduler_parse_share()
+ *   gang_quantum, gang_pack, gang_patience : gang scheduling, see
+ *        scheduler_parse_gang()
+ *   mlfq_levels, mlfq_quantum, mlfq_boost : see scheduler_parse_mlfq()
+ *   cfs_latency, cfs_granularity : see scheduler_parse_cfs()
+ */
+typedef struct {
+    algorithm_t algorithm;
+    int time_slice;
+    int per_cpu;
+    int lock_free;
+    int lock_profile;
+    topology_t topology;
+    int deterministic;
+    cgroup_tree_t groups;
+    int adaptive;
+    double adapt_alpha;
+    unsigned int adapt_initial;
+    unsigned int adapt_min;
+    unsigned int adapt_max;
+    unsigned int adapt_response;
+    unsigned int share_quantum;
+    int share_compensation;
+    unsigned long share_seed;
+    unsigned int gang_quantum;
+    int gang_pack;
+    unsigned int gang_patience;
+    unsigned int mlfq_levels;
+    int mlfq_quantum[MLFQ_MAX_LEVELS];
+    unsigned int mlfq_boost;
+    unsigned int cfs_latency;
+    unsigned int cfs_granularity;
+} scheduler_config_t;
+
+typedef struct scheduler scheduler_t;
+
+/* scheduler_config_default() fills config with FIFO and default parameters */
+extern void scheduler_config_default(scheduler_config_t *config);
+
+/*
+ * scheduler_parse_mlfq() reads "levels=N,quanta=q0:q1:...,boost=T" and
+ * scheduler_parse_cfs() reads "latency=L,granularity=G" into config, also
+ * selecting that algorithm.  "default" keeps the defaults.  Both return -1 on
+ * a bad spec.
+ */
+extern int scheduler_parse_mlfq(scheduler_config_t *config, const char *spec);
+extern int scheduler_parse_cfs(scheduler_config_t *config, const char *spec);
+
+/*
+ * scheduler_parse_adaptive() reads "alpha=A,initial=I,min=M,max=X,
+ * response=R" and turns on burst estimation.  Each process's estimate starts
+ * at I ticks, and every finished CPU burst of b ticks moves it to
+ * A * b + (1 - A) * estimate.  Round robin then gives each process a quantum
+ * just long enough for the burst it is expected to run, between M and X
+ * ticks, but no more than R ticks shared among the processes waiting, so
+ * response time stays bounded.  SRTF orders by estimate in place of the
+ * true time remaining.  "default" keeps the defaults.  Returns -1 on a bad
+ * spec.
+ */
+extern int scheduler_parse_adaptive(scheduler_config_t *config,
+                                    const char *spec);
+
+/*
+ * scheduler_parse_share() reads "lottery" or "stride", optionally followed
+ * by ",quantum=Q,compensation=0|1,seed=S", and selects that algorithm.  Both
+ * give each process tickets in proportion to its nice weight and run it for
+ * Q ticks at a time.  Lottery draws the next process at random, weighted by
+ * tickets, from a generator seeded with S; stride runs the process with the
+ * lowest pass, which advances by the ticks it runs over its tickets.  With
+ * compensation (the default), a process that blocks for I/O before its
+ * quantum is up keeps the unused part for when it wakes.  This stands in for
+ * ticket transfer, since processes here wait on I/O devices rather than on
+ * each other.  Returns -1 on a bad spec.
+ */
+extern int scheduler_parse_share(scheduler_config_t *config, const char *spec);
+
+/*
+ * scheduler_parse_gang() reads "quantum=Q,policy=fifo|pack,patience=P" and
+ * selects gang scheduling.  Every job, whether the threads of a gang (see
+ * pcb_t) or a single process, runs for slices of Q ticks on as many CPUs as
+ * it has threads, all dispatched in the same tick.  CPUs of a thread blocked
+ * on I/O stay reserved for it until the slice ends.  Jobs take turns in
+ * arrival order; with fifo, a job that does not fit in the free CPUs holds
+ * up those behind it, while pack lets the job that best fills the free CPUs
+ * go first, unless the one at the head has waited P ticks.  "default" keeps
+ * the defaults.  Returns -1 on a bad spec.
+ */
+extern int scheduler_parse_gang(scheduler_config_t *config, const char *spec);
+
+/*
+ * scheduler_create() builds a scheduler for one simulation of cpu_count CPUs
+ * over the count PCBs in table, to be passed to simulator_run().
+ */
+extern scheduler_t *scheduler_create(const scheduler_config_t *config,
+                                     unsigned int cpu_count,
+                                     pcb_t *table, unsigned int count);
+extern void scheduler_destroy(scheduler_t *scheduler);
+
 #endif /* __STUDENT_H__ */
@@ -0,0 +1,330 @@
+/*
+ * sweep.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Parameter sweeps.  Each run is its own simulator and scheduler instance on
+ * its own copy of the workload, so worker threads just pull the next run off
+ * a shared counter.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sweep.h"
+#include "process.h"
+#include "workload.h"
+
+#define SWEEP_MAX_VALUES 64
+
+static const char *algorithm_names[] = {
+    "fifo", "rr", "srtf", "priority", "mlfq", "cfs", "edf", "rm", "lottery",
+    "stride", "gang"
+};
+#define ALGORITHM_COUNT (sizeof(algorithm_names) / sizeof(algorithm_names[0]))
+
+/* A workload, kept pristine and cloned for every run */
+typedef struct {
+    const char *name;
+    pcb_t *table;
+    unsigned int count;
+} sweep_workload_t;
+
+typedef struct {
+    const sweep_workload_t *workload;
+    unsigned int cpus;
+    algorithm_t algorithm;
+    int quantum;
+    int status;
+    simulator_results_t results;
+} sweep_job_t;
+
+typedef struct {
+    sweep_job_t *jobs;
+    unsigned int job_count;
+    unsigned int next;
+    const scheduler_config_t *config;
+    const simulator_config_t *sim_config;
+} sweep_t;
+
+
+/* Splits a colon-separated list of unsigned numbers; returns -1 if bad */
+static int parse_numbers(char *list, unsigned int *values, unsigned int *count)
+{
+    char *save, *tok, *end;
+
+    *count = 0;
+    for (tok = strtok_r(list, ":", &save); tok != NULL;
+         tok = strtok_r(NULL, ":", &save))
+    {
+        unsigned long n = strtoul(tok, &end, 10);
+        if (*end != '\0' || end == tok || n < 1 || *count == SWEEP_MAX_VALUES)
+            return -1;
+        values[(*count)++] = (unsigned int) n;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+static int parse_algorithms(char *list, algorithm_t *values,
+                            unsigned int *count)
+{
+    char *save, *tok;
+    unsigned int a;
+
+    *count = 0;
+    for (tok = strtok_r(list, ":", &save); tok != NULL;
+         tok = strtok_r(NULL, ":", &save))
+    {
+        for (a = 0; a < ALGORITHM_COUNT; a++)
+            if (strcmp(tok, algorithm_names[a]) == 0)
+                break;
+        if (a == ALGORITHM_COUNT || *count == SWEEP_MAX_VALUES)
+            return -1;
+        values[(*count)++] = (algorithm_t) a;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+static void *sweep_worker(void *data)
+{
+    sweep_t *sweep = data;
+    unsigned int n;
+
+    while ((n = __atomic_fetch_add(&sweep->next, 1, __ATOMIC_RELAXED)) <
+           sweep->job_count)
+    {
+        sweep_job_t *job = &sweep->jobs[n];
+        scheduler_config_t config = *sweep->config;
+        simulator_config_t sim_config = *sweep->sim_config;
+        scheduler_t *scheduler;
+        pcb_t *table;
+
+        config.algorithm = job->algorithm;
+        config.time_slice = job->algorithm == ROUND_ROBIN ? job->quantum : -1;
+        sim_config.cpu_count = job->cpus;
+        sim_config.quiet = 1;
+        sim_config.csv_path = NULL;
+        sim_config.event_log_path = NULL;
+        sim_config.replay_path = NULL;
+
+        table = process_table_clone(job->workload->table,
+            job->workload->count);
+        scheduler = scheduler_create(&config, job->cpus, table,
+            job->workload->count);
+        job->status = simulator_run(&sim_config, table, job->workload->count,
+            scheduler, &job->results);
+        scheduler_destroy(scheduler);
+        process_table_free(table);
+    }
+    return NULL;
+}
+
+static void print_row(FILE *out, const sweep_job_t *job, int csv)
+{
+    const simulator_results_t *r = &job->results;
+    char quantum[16];
+
+    if (job->algorithm == ROUND_ROBIN)
+        snprintf(quantum, sizeof(quantum), "%d", job->quantum);
+    else
+        snprintf(quantum, sizeof(quantum), "-");
+
+    if (job->status != 0)
+    {
+        fprintf(out, csv ? "%s,%u,%s,%s,failed\n" :
+            "%-16s %4u %-8s %7s  failed\n", job->workload->name, job->cpus,
+            algorithm_names[job->algorithm], quantum);
+        return;
+    }
+    fprintf(out, csv ?
+        "%s,%u,%s,%s,%u,%.1f,%.1f,%.3f,%.1f,%.1f,%.1f,%.1f,%.4f,%.1f\n" :
+        "%-16s %4u %-8s %7s %9u %9.1f %10.1f %8.3f %6.1f %10.1f %8.1f "
+        "%8.1f %8.4f %7.1f\n",
+        job->workload->name, job->cpus, algorithm_names[job->algorithm],
+        quantum, r->context_switches, r->total_time / 10.0,
+        r->ready_time / 10.0, r->metrics.throughput,
+        100.0 * r->metrics.utilization, r->metrics.turnaround / 10.0,
+        r->metrics.waiting / 10.0, r->metrics.response / 10.0,
+        r->metrics.fairness, 100.0 * r->metrics.deadline_misses);
+}
+
+static int load_workloads(char *list, sweep_workload_t *workloads,
+                          unsigned int *count)
+{
+    char *save, *tok;
+
+    *count = 0;
+    if (list == NULL)
+    {
+        workloads[0].name = "-";
+        workloads[0].table = process_table_clone(processes, process_count);
+        workloads[0].count = process_count;
+        *count = 1;
+        return 0;
+    }
+    for (tok = strtok_r(list, ":", &save); tok != NULL;
+         tok = strtok_r(NULL, ":", &save))
+    {
+        if (*count == SWEEP_MAX_VALUES || workload_load(tok) != 0)
+            return -1;
+        workloads[*count].name = tok;
+        workloads[*count].table = process_table_clone(processes,
+            process_count);
+        workloads[*count].count = process_count;
+        (*count)++;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+extern int sweep_run(const char *spec, const scheduler_config_t *config,
+                     const simulator_config_t *sim_config)
+{
+    char *copy = strdup(spec), *save, *tok, *workload_list = NULL, *end;
+    const char *csv_path = NULL;
+    unsigned int cpus[SWEEP_MAX_VALUES] = { 1 }, cpu_count = 1;
+    algorithm_t algos[SWEEP_MAX_VALUES];
+    unsigned int algo_count = 1;
+    unsigned int quanta[SWEEP_MAX_VALUES], quanta_count = 1;
+    sweep_workload_t workloads[SWEEP_MAX_VALUES];
+    unsigned int workload_count = 0, jobs, w, c, a, q, n;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_t *threads;
+    sweep_t sweep;
+    int ret = 0;
+
+    assert(copy != NULL);
+    algos[0] = config->algorithm;
+    quanta[0] = config->time_slice > 0 ? (unsigned int) config->time_slice : 4;
+    jobs = cores > 0 ? (unsigned int) cores : 1;
+
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save))
+    {
+        char *value = strchr(tok, '=');
+
+        if (value == NULL)
+        {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        if (strcmp(tok, "cpus") == 0)
+        {
+            ret = parse_numbers(value, cpus, &cpu_count);
+            for (n = 0; ret == 0 && n < cpu_count; n++)
+                if (cpus[n] > MAX_CPU_COUNT)
+                    ret = -1;
+        }
+        else if (strcmp(tok, "algo") == 0)
+            ret = parse_algorithms(value, algos, &algo_count);
+        else if (strcmp(tok, "quantum") == 0)
+            ret = parse_numbers(value, quanta, &quanta_count);
+        else if (strcmp(tok, "workload") == 0)
+            workload_list = value;
+        else if (strcmp(tok, "csv") == 0)
+            csv_path = value;
+        else if (strcmp(tok, "jobs") == 0)
+        {
+            unsigned long j = strtoul(value, &end, 10);
+            if (*end != '\0' || end == value || j < 1)
+                ret = -1;
+            jobs = (unsigned int) j;
+        }
+        else
+            ret = -1;
+    }
+    if (ret != 0)
+    {
+        fprintf(stderr, "Bad sweep spec '%s'\n", spec);
+        free(copy);
+        return -1;
+    }
+
+    /* Workloads are loaded one at a time, since loading uses the global table */
+    if (load_workloads(workload_list, workloads, &workload_count) != 0)
+    {
+        fprintf(stderr, "Could not load the sweep's workloads\n");
+        for (w = 0; w < workload_count; w++)
+            process_table_free(workloads[w].table);
+        free(copy);
+        return -1;
+    }
+
+    /* Lay out every combination; round robin is the only one with a quantum */
+    sweep.job_count = 0;
+    for (a = 0; a < algo_count; a++)
+        sweep.job_count += algos[a] == ROUND_ROBIN ? quanta_count : 1;
+    sweep.job_count *= workload_count * cpu_count;
+    sweep.jobs = calloc(sweep.job_count, sizeof(sweep_job_t));
+    assert(sweep.jobs != NULL);
+    n = 0;
+    for (w = 0; w < workload_count; w++)
+        for (c = 0; c < cpu_count; c++)
+            for (a = 0; a < algo_count; a++)
+                for (q = 0; q < (algos[a] == ROUND_ROBIN ? quanta_count : 1);
+                     q++)
+                {
+                    sweep.jobs[n].workload = &workloads[w];
+                    sweep.jobs[n].cpus = cpus[c];
+                    sweep.jobs[n].algorithm = algos[a];
+                    sweep.jobs[n].quantum = (int) quanta[q];
+                    n++;
+                }
+    sweep.next = 0;
+    sweep.config = config;
+    sweep.sim_config = sim_config;
+
+    if (jobs > sweep.job_count)
+        jobs = sweep.job_count;
+    threads = malloc(sizeof(pthread_t) * jobs);
+    assert(threads != NULL);
+    for (n = 0; n < jobs; n++)
+        pthread_create(&threads[n], NULL, sweep_worker, &sweep);
+    for (n = 0; n < jobs; n++)
+        pthread_join(threads[n], NULL);
+
+    printf("%-16s %4s %-8s %7s %9s %9s %10s %8s %6s %10s %8s %8s %8s %7s\n",
+        "workload", "cpus", "algo", "quantum", "switches", "time(s)",
+        "ready(s)", "thruput", "util%", "turnaround", "waiting", "response",
+        "fairness", "missed%");
+    for (n = 0; n < sweep.job_count; n++)
+    {
+        print_row(stdout, &sweep.jobs[n], 0);
+        if (sweep.jobs[n].status != 0)
+            ret = -1;
+    }
+
+    if (csv_path != NULL)
+    {
+        FILE *f = fopen(csv_path, "w");
+
+        if (f == NULL)
+        {
+            perror(csv_path);
+            ret = -1;
+        }
+        else
+        {
+            fprintf(f, "workload,cpus,algo,quantum,switches,time,ready,"
+                "throughput,utilization,turnaround,waiting,response,"
+                "fairness,missed\n");
+            for (n = 0; n < sweep.job_count; n++)
+                print_row(f, &sweep.jobs[n], 1);
+            if (ferror(f) | fclose(f))
+            {
+                fprintf(stderr, "%s: write failed\n", csv_path);
+                ret = -1;
+            }
+        }
+    }
+
+    for (w = 0; w < workload_count; w++)
+        process_table_free(workloads[w].table);
+    free(threads);
+    free(sweep.jobs);
+    free(copy);
+    return ret;
+}
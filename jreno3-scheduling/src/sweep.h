@@ -0,0 +1,35 @@
+/*
+ * sweep.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Parameter sweeps: many independent simulations run in parallel.
+ */
+
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include "os-sim.h"
+#include "student.h"
+
+/*
+ * sweep_run() runs one simulation for every combination of the values in
+ * spec and prints a table of the results.  spec is comma-separated, with
+ * lists separated by colons:
+ *
+ *   cpus=1:2:4 : CPU counts (default 1)
+ *   algo=fifo:rr:srtf:priority:mlfq:cfs:edf:rm : algorithms (default that
+ *        of config)
+ *   quantum=2:4:8 : round robin time slices (default that of config, or 4);
+ *        other algorithms run once regardless
+ *   workload=a.txt:b.bin : workload files (default the current process
+ *        table)
+ *   jobs=N : simulations to run at once (default the number of cores)
+ *   csv=path : also write the table to path as CSV
+ *
+ * Every run starts from config and sim_config, made quiet.  Returns -1 on a
+ * bad spec or if any run fails.
+ */
+extern int sweep_run(const char *spec, const scheduler_config_t *config,
+                     const simulator_config_t *sim_config);
+
+#endif /* __SWEEP_H__ */
@@ -0,0 +1,110 @@
+/*
+ * topology.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * CPU topology and migration costs.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "topology.h"
+
+void topology_default(topology_t *t)
+{
+    t->nodes = 1;
+    t->llcs = 1;
+    t->core_cost = 0;
+    t->llc_cost = 1;
+    t->node_cost = 4;
+}
+
+int topology_parse(topology_t *t, const char *spec)
+{
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+
+    assert(copy != NULL);
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save))
+    {
+        char *value = strchr(tok, '=');
+        unsigned long n;
+
+        if (value == NULL)
+        {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        n = strtoul(value, &end, 10);
+        if (*end != '\0' || end == value || n > 1000000)
+            ret = -1;
+        else if (strcmp(tok, "nodes") == 0 && n >= 1)
+            t->nodes = (unsigned int) n;
+        else if (strcmp(tok, "llcs") == 0 && n >= 1)
+            t->llcs = (unsigned int) n;
+        else if (strcmp(tok, "core") == 0)
+            t->core_cost = (unsigned int) n;
+        else if (strcmp(tok, "llc") == 0)
+            t->llc_cost = (unsigned int) n;
+        else if (strcmp(tok, "node") == 0)
+            t->node_cost = (unsigned int) n;
+        else
+            ret = -1;
+    }
+
+    if (ret != 0)
+        fprintf(stderr, "Bad topology spec '%s'\n", spec);
+    free(copy);
+    return ret;
+}
+
+int topology_is_flat(const topology_t *t)
+{
+    return t->nodes * t->llcs == 1;
+}
+
+unsigned int topology_domain(const topology_t *t, unsigned int cpu_count,
+                             unsigned int cpu)
+{
+    return (unsigned int) ((unsigned long) cpu * t->nodes * t->llcs /
+        cpu_count);
+}
+
+unsigned int topology_node(const topology_t *t, unsigned int cpu_count,
+                           unsigned int cpu)
+{
+    return topology_domain(t, cpu_count, cpu) / t->llcs;
+}
+
+migration_t topology_migration(const topology_t *t, unsigned int cpu_count,
+                               unsigned int from, unsigned int to)
+{
+    unsigned int a, b;
+
+    if (from == to)
+        return MIGRATE_NONE;
+    a = topology_domain(t, cpu_count, from);
+    b = topology_domain(t, cpu_count, to);
+    if (a == b)
+        return MIGRATE_CORE;
+    return a / t->llcs == b / t->llcs ? MIGRATE_LLC : MIGRATE_NODE;
+}
+
+unsigned int topology_cost(const topology_t *t, migration_t m)
+{
+    switch (m)
+    {
+    case MIGRATE_CORE:
+        return t->core_cost;
+    case MIGRATE_LLC:
+        return t->llc_cost;
+    case MIGRATE_NODE:
+        return t->node_cost;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * topology.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * The machine's layout: CPUs grouped into cache domains, grouped into NUMA
+ * nodes, and what it costs a process to move between them.
+ */
+
+#ifndef __TOPOLOGY_H__
+#define __TOPOLOGY_H__
+
+/*
+ * nodes : NUMA nodes
+ * llcs : cache domains (CPUs sharing a last-level cache) per node
+ * core_cost, llc_cost, node_cost : ticks added to a process's CPU burst when
+ *      it is dispatched on a different CPU than it last ran on, in the same
+ *      cache domain, in another cache domain of the same node, or on another
+ *      node
+ *
+ * CPUs are split into nodes * llcs domains of consecutive CPU numbers, as
+ * evenly as the CPU count allows.  The default is one node with one cache
+ * domain, which makes every migration free.
+ */
+typedef struct {
+    unsigned int nodes;
+    unsigned int llcs;
+    unsigned int core_cost;
+    unsigned int llc_cost;
+    unsigned int node_cost;
+} topology_t;
+
+/* How far a process moved, nearest first */
+typedef enum {
+    MIGRATE_NONE = 0,
+    MIGRATE_CORE,
+    MIGRATE_LLC,
+    MIGRATE_NODE
+} migration_t;
+
+extern void topology_default(topology_t *t);
+
+/*
+ * topology_parse() reads "nodes=2,llcs=2,core=0,llc=1,node=4" into t.
+ * Returns -1 on a bad spec.
+ */
+extern int topology_parse(topology_t *t, const char *spec);
+
+/* Whether t is a single cache domain */
+extern int topology_is_flat(const topology_t *t);
+
+/* The cache domain and node of cpu, out of cpu_count CPUs */
+extern unsigned int topology_domain(const topology_t *t,
+                                    unsigned int cpu_count, unsigned int cpu);
+extern unsigned int topology_node(const topology_t *t, unsigned int cpu_count,
+                                  unsigned int cpu);
+
+/* How far apart CPUs from and to are, and what moving between them costs */
+extern migration_t topology_migration(const topology_t *t,
+                                      unsigned int cpu_count,
+                                      unsigned int from, unsigned int to);
+extern unsigned int topology_cost(const topology_t *t, migration_t m);
+
+#endif /* __TOPOLOGY_H__ */
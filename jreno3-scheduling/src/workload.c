@@ -0,0 +1,759 @@
+/*
+ * workload.c
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Loading, saving and generating process workloads.  See workload.h for the
+ * text format.
+ *
+ * The binary format is, with every integer an unsigned LEB128 varint:
+ *
+ *     "OSWL" version count
+ *     then per process:
+ *         name_len name[name_len]
+ *         attr_count { attr_id zigzag(value) } * attr_count
+ *         op_count { (ticks << 1) | is_io [device] } * op_count
+ *
+ * device follows I/O bursts only, as stored in op_t (device number plus one,
+ * or IO_DEVICE_ANY); version 1 files lack it.  The trailing OP_TERMINATE is
+ * implied.  attr_id indexes attr_names[] below,
+ * so new attributes only ever get appended to it.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cgroup.h"
+#include "os-sim.h"
+#include "process.h"
+#include "workload.h"
+
+
+/*
+ * Per-process attributes, shared by both file formats.  Adding one means
+ * adding it to attr_t, attr_names[], attr_get() and attr_set().
+ */
+typedef enum {
+    ATTR_ARRIVAL = 0,
+    ATTR_PRIORITY,
+    ATTR_AFFINITY,
+    ATTR_NICE,
+    ATTR_PERIOD,
+    ATTR_DEADLINE,
+    ATTR_JITTER,
+    ATTR_GROUP,
+    ATTR_GANG,
+    ATTR_COUNT
+} attr_t;
+
+static const char *attr_names[ATTR_COUNT] = {
+    "arrival",
+    "priority",
+    "affinity",
+    "nice",
+    "period",
+    "deadline",
+    "jitter",
+    "group",
+    "gang"
+};
+
+static long attr_get(const pcb_t *pcb, attr_t attr)
+{
+    switch (attr)
+    {
+    case ATTR_ARRIVAL:
+        return (long) pcb->arrival;
+    case ATTR_PRIORITY:
+        return pcb->priority;
+    case ATTR_AFFINITY:
+        return pcb->affinity;
+    case ATTR_NICE:
+        return pcb->nice;
+    case ATTR_PERIOD:
+        return (long) pcb->period;
+    case ATTR_DEADLINE:
+        return (long) pcb->deadline;
+    case ATTR_JITTER:
+        return (long) pcb->jitter;
+    case ATTR_GROUP:
+        return (long) pcb->group;
+    case ATTR_GANG:
+        return (long) pcb->gang;
+    default:
+        return 0;
+    }
+}
+
+static int attr_set(pcb_t *pcb, attr_t attr, long value)
+{
+    switch (attr)
+    {
+    case ATTR_ARRIVAL:
+        if (value < 0)
+            return -1;
+        pcb->arrival = (unsigned int) value;
+        return 0;
+    case ATTR_PRIORITY:
+        pcb->priority = (int) value;
+        return 0;
+    case ATTR_AFFINITY:
+        if (value < -1 || value >= MAX_CPU_COUNT)
+            return -1;
+        pcb->affinity = (int) value;
+        return 0;
+    case ATTR_NICE:
+        if (value < -20 || value > 19)
+            return -1;
+        pcb->nice = (int) value;
+        return 0;
+    case ATTR_PERIOD:
+    case ATTR_DEADLINE:
+    case ATTR_JITTER:
+        if (value < 0 || value > INT32_MAX)
+            return -1;
+        if (attr == ATTR_PERIOD)
+            pcb->period = (unsigned int) value;
+        else if (attr == ATTR_DEADLINE)
+            pcb->deadline = (unsigned int) value;
+        else
+            pcb->jitter = (unsigned int) value;
+        return 0;
+    case ATTR_GROUP:
+        if (value < 0 || value >= CGROUP_MAX)
+            return -1;
+        pcb->group = (unsigned int) value;
+        return 0;
+    case ATTR_GANG:
+        if (value < 0 || value > GANG_MAX)
+            return -1;
+        pcb->gang = (unsigned int) value;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+
+/*
+ * A growable list of loaded processes.  Entries are collected in file order
+ * with their file index as a provisional PID, then sorted by arrival.
+ */
+typedef struct {
+    pcb_t *pcbs;
+    unsigned int count;
+    unsigned int capacity;
+} pcb_list_t;
+
+static pcb_t *pcb_list_add(pcb_list_t *list)
+{
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->pcbs = realloc(list->pcbs, list->capacity * sizeof(pcb_t));
+        assert(list->pcbs != NULL);
+    }
+    return &list->pcbs[list->count++];
+}
+
+static int pcb_arrival_cmp(const void *a, const void *b)
+{
+    const pcb_t *x = a, *y = b;
+
+    if (x->arrival != y->arrival)
+        return x->arrival < y->arrival ? -1 : 1;
+    return x->pid < y->pid ? -1 : (x->pid > y->pid);
+}
+
+/* Sorts the loaded processes and moves them into the process table */
+static void pcb_list_install(pcb_list_t *list)
+{
+    unsigned int n;
+    int a;
+
+    qsort(list->pcbs, list->count, sizeof(pcb_t), pcb_arrival_cmp);
+    process_table_alloc(list->count);
+    for (n = 0; n < list->count; n++)
+    {
+        process_init(&processes[n], n, list->pcbs[n].name, list->pcbs[n].pc);
+        for (a = 0; a < ATTR_COUNT; a++)
+            attr_set(&processes[n], (attr_t) a,
+                attr_get(&list->pcbs[n], (attr_t) a));
+    }
+    free(list->pcbs);
+}
+
+/* A growable operations array that always ends in OP_TERMINATE */
+typedef struct {
+    op_t *ops;
+    size_t count;
+    size_t capacity;
+} ops_builder_t;
+
+static void ops_add(ops_builder_t *b, op_type type, unsigned int time,
+                    unsigned int device)
+{
+    if (b->count + 2 > b->capacity)
+    {
+        b->capacity = b->capacity ? b->capacity * 2 : 16;
+        b->ops = realloc(b->ops, b->capacity * sizeof(op_t));
+        assert(b->ops != NULL);
+    }
+    b->ops[b->count].type = type;
+    b->ops[b->count].time = time;
+    b->ops[b->count].device = device;
+    b->count++;
+    b->ops[b->count].type = OP_TERMINATE;
+    b->ops[b->count].time = 0;
+    b->ops[b->count].device = IO_DEVICE_ANY;
+}
+
+/*
+ * Bursts must alternate CPU and I/O, starting and ending with CPU.  A
+ * real-time task's bursts are its jobs, so they must all be CPU bursts.
+ */
+static int ops_valid(const ops_builder_t *b, const pcb_t *pcb)
+{
+    size_t n;
+
+    if (b->count == 0 || (b->count % 2 == 0 && pcb->period == 0))
+        return 0;
+    for (n = 0; n < b->count; n++)
+        if (b->ops[n].type != (n % 2 && pcb->period == 0 ? OP_IO : OP_CPU))
+            return 0;
+    return 1;
+}
+
+static void pcb_list_init_entry(pcb_t *pcb, unsigned int index,
+                                const char *name, op_t *ops)
+{
+    char *copy = strdup(name);
+    assert(copy != NULL);
+    process_init(pcb, index, copy, ops);
+}
+
+
+
+/*
+ * Text format
+ */
+
+static int load_text(FILE *f, const char *path, pcb_list_t *list)
+{
+    char *line = NULL, *save, *tok, *end;
+    size_t cap = 0;
+    unsigned int lineno = 0;
+
+    while (getline(&line, &cap, f) != -1)
+    {
+        ops_builder_t b = { NULL, 0, 0 };
+        pcb_t *pcb;
+        char *hash;
+
+        lineno++;
+        if ((hash = strchr(line, '#')) != NULL)
+            *hash = '\0';
+        if ((tok = strtok_r(line, " \t\r\n", &save)) == NULL)
+            continue;
+
+        pcb = pcb_list_add(list);
+        pcb_list_init_entry(pcb, list->count - 1, tok, NULL);
+
+        while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL)
+        {
+            char *eq = strchr(tok, '=');
+
+            if (eq != NULL)
+            {
+                int a;
+                long value;
+
+                *eq = '\0';
+                for (a = 0; a < ATTR_COUNT; a++)
+                    if (strcmp(tok, attr_names[a]) == 0)
+                        break;
+                errno = 0;
+                value = strtol(eq + 1, &end, 0);
+                if (a == ATTR_COUNT || errno != 0 || *end != '\0' ||
+                    end == eq + 1 || attr_set(pcb, (attr_t) a, value) != 0)
+                {
+                    fprintf(stderr, "%s:%u: bad attribute '%s=%s'\n",
+                        path, lineno, tok, eq + 1);
+                    goto fail;
+                }
+            }
+            else if (tok[0] == 'C' || tok[0] == 'I')
+            {
+                unsigned long ticks, device = IO_DEVICE_ANY;
+
+                errno = 0;
+                ticks = strtoul(tok + 1, &end, 10);
+                if (tok[0] == 'I' && *end == '@' && end != tok + 1)
+                {
+                    char *at = end + 1;
+
+                    device = strtoul(at, &end, 10) + 1;
+                    if (end == at || device > MAX_IO_DEVICES)
+                        errno = EINVAL;
+                }
+                if (errno != 0 || *end != '\0' || end == tok + 1 ||
+                    ticks > UINT32_MAX)
+                {
+                    fprintf(stderr, "%s:%u: bad burst '%s'\n",
+                        path, lineno, tok);
+                    goto fail;
+                }
+                ops_add(&b, tok[0] == 'C' ? OP_CPU : OP_IO,
+                    (unsigned int) ticks, (unsigned int) device);
+            }
+            else
+            {
+                fprintf(stderr, "%s:%u: unexpected '%s'\n", path, lineno, tok);
+                goto fail;
+            }
+        }
+
+        if (!ops_valid(&b, pcb))
+        {
+            if (pcb->period > 0)
+                fprintf(stderr, "%s:%u: a periodic task's bursts must all be "
+                    "C\n", path, lineno);
+            else
+                fprintf(stderr, "%s:%u: bursts must alternate C and I, "
+                    "starting and ending with C\n", path, lineno);
+            goto fail;
+        }
+        pcb->pc = b.ops;
+        pcb->time_remaining = b.ops[0].time;
+        continue;
+
+fail:
+        free(b.ops);
+        free(line);
+        return -1;
+    }
+
+    free(line);
+    return 0;
+}
+
+static int save_text(FILE *f)
+{
+    unsigned int n;
+    int a;
+
+    fprintf(f, "# os-sim workload: name");
+    for (a = 0; a < ATTR_COUNT; a++)
+        fprintf(f, " %s=", attr_names[a]);
+    fprintf(f, " bursts...\n");
+
+    for (n = 0; n < process_count; n++)
+    {
+        const op_t *op;
+
+        fprintf(f, "%s", processes[n].name);
+        for (a = 0; a < ATTR_COUNT; a++)
+            fprintf(f, " %s=%ld", attr_names[a],
+                attr_get(&processes[n], (attr_t) a));
+        for (op = processes[n].pc; op->type != OP_TERMINATE; op++)
+        {
+            fprintf(f, " %c%u", op->type == OP_CPU ? 'C' : 'I', op->time);
+            if (op->type == OP_IO && op->device != IO_DEVICE_ANY)
+                fprintf(f, "@%u", op->device - 1);
+        }
+        fputc('\n', f);
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+
+
+/*
+ * Binary format
+ */
+
+static void put_varint(FILE *f, uint64_t v)
+{
+    do
+    {
+        uint8_t byte = v & 0x7f;
+        v >>= 7;
+        fputc(byte | (v ? 0x80 : 0), f);
+    } while (v);
+}
+
+static int get_varint(FILE *f, uint64_t *v)
+{
+    unsigned int shift = 0;
+    int c;
+
+    *v = 0;
+    do
+    {
+        if ((c = fgetc(f)) == EOF || shift > 63)
+            return -1;
+        *v |= (uint64_t)(c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return 0;
+}
+
+static uint64_t zigzag(long v)
+{
+    return ((uint64_t) v << 1) ^ (uint64_t)(v >> (sizeof(long) * 8 - 1));
+}
+
+static long unzigzag(uint64_t v)
+{
+    return (long)(v >> 1) ^ -(long)(v & 1);
+}
+
+static int load_binary(FILE *f, const char *path, pcb_list_t *list)
+{
+    uint64_t version, count, n, k, len, v;
+    char *name;
+
+    if (get_varint(f, &version) || get_varint(f, &count))
+        goto truncated;
+    if (version < 1 || version > WORKLOAD_VERSION)
+    {
+        fprintf(stderr, "%s: unsupported workload version %lu\n", path,
+            (unsigned long) version);
+        return -1;
+    }
+    if (count > MAX_PROCESS_COUNT)
+    {
+        fprintf(stderr, "%s: too many processes\n", path);
+        return -1;
+    }
+
+    for (n = 0; n < count; n++)
+    {
+        ops_builder_t b = { NULL, 0, 0 };
+        pcb_t *pcb;
+
+        if (get_varint(f, &len) || len > 4096)
+            goto truncated;
+        name = malloc(len + 1);
+        assert(name != NULL);
+        if (fread(name, 1, len, f) != len)
+        {
+            free(name);
+            goto truncated;
+        }
+        name[len] = '\0';
+        pcb = pcb_list_add(list);
+        process_init(pcb, list->count - 1, name, NULL);
+
+        if (get_varint(f, &len))
+            goto truncated;
+        for (k = 0; k < len; k++)
+        {
+            uint64_t id;
+
+            if (get_varint(f, &id) || get_varint(f, &v))
+                goto truncated;
+            /* Skip attributes from newer writers */
+            if (id < ATTR_COUNT &&
+                attr_set(pcb, (attr_t) id, unzigzag(v)) != 0)
+            {
+                fprintf(stderr, "%s: process %lu: bad %s\n", path,
+                    (unsigned long) n, attr_names[id]);
+                return -1;
+            }
+        }
+
+        if (get_varint(f, &len))
+            goto truncated;
+        for (k = 0; k < len; k++)
+        {
+            uint64_t device = IO_DEVICE_ANY;
+
+            if (get_varint(f, &v) || (v >> 1) > UINT32_MAX ||
+                ((v & 1) && version >= 2 && (get_varint(f, &device) ||
+                device > MAX_IO_DEVICES)))
+            {
+                free(b.ops);
+                goto truncated;
+            }
+            ops_add(&b, (v & 1) ? OP_IO : OP_CPU, (unsigned int)(v >> 1),
+                (unsigned int) device);
+        }
+        if (!ops_valid(&b, pcb))
+        {
+            fprintf(stderr, "%s: process %lu: bursts must alternate CPU and "
+                "I/O, starting and ending with CPU, or for a periodic task "
+                "all be CPU\n", path, (unsigned long) n);
+            free(b.ops);
+            return -1;
+        }
+        pcb->pc = b.ops;
+        pcb->time_remaining = b.ops[0].time;
+    }
+    return 0;
+
+truncated:
+    fprintf(stderr, "%s: truncated or corrupt binary workload\n", path);
+    return -1;
+}
+
+static int save_binary(FILE *f)
+{
+    unsigned int n;
+    int a;
+
+    fwrite(WORKLOAD_MAGIC, 1, strlen(WORKLOAD_MAGIC), f);
+    put_varint(f, WORKLOAD_VERSION);
+    put_varint(f, process_count);
+
+    for (n = 0; n < process_count; n++)
+    {
+        const op_t *op;
+        size_t len = strlen(processes[n].name);
+
+        put_varint(f, len);
+        fwrite(processes[n].name, 1, len, f);
+        put_varint(f, ATTR_COUNT);
+        for (a = 0; a < ATTR_COUNT; a++)
+        {
+            put_varint(f, (uint64_t) a);
+            put_varint(f, zigzag(attr_get(&processes[n], (attr_t) a)));
+        }
+        for (op = processes[n].pc; op->type != OP_TERMINATE; op++)
+            ;
+        put_varint(f, (uint64_t)(op - processes[n].pc));
+        for (op = processes[n].pc; op->type != OP_TERMINATE; op++)
+        {
+            put_varint(f, ((uint64_t) op->time << 1) | (op->type == OP_IO));
+            if (op->type == OP_IO)
+                put_varint(f, op->device);
+        }
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+
+
+extern int workload_load(const char *path)
+{
+    pcb_list_t list = { NULL, 0, 0 };
+    char magic[sizeof(WORKLOAD_MAGIC) - 1];
+    FILE *f;
+    int ret;
+
+    if ((f = fopen(path, "rb")) == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    if (fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+        memcmp(magic, WORKLOAD_MAGIC, sizeof(magic)) == 0)
+    {
+        ret = load_binary(f, path, &list);
+    }
+    else
+    {
+        rewind(f);
+        ret = load_text(f, path, &list);
+    }
+    fclose(f);
+
+    if (ret == 0 && list.count == 0)
+    {
+        fprintf(stderr, "%s: workload has no processes\n", path);
+        ret = -1;
+    }
+    if (ret != 0)
+    {
+        /* Exiting on failure anyway, so the partial list is not freed */
+        return -1;
+    }
+
+    pcb_list_install(&list);
+    return 0;
+}
+
+extern int workload_save(const char *path, int binary)
+{
+    FILE *f;
+    int ret;
+
+    if ((f = fopen(path, binary ? "wb" : "w")) == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    ret = binary ? save_binary(f) : save_text(f);
+    if (fclose(f) != 0)
+        ret = -1;
+    if (ret != 0)
+        fprintf(stderr, "%s: write failed\n", path);
+    return ret;
+}
+
+
+
+/*
+ * Synthetic workload generator
+ */
+
+/* splitmix64, so workloads don't depend on the C library's rand() */
+static uint64_t rng_next(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/* Uniform on (0, 1] */
+static double rng_uniform(uint64_t *state)
+{
+    return ((double)(rng_next(state) >> 11) + 1.0) / 9007199254740992.0;
+}
+
+/* Pareto shape parameter; 1.5 gives a heavy tail with a finite mean */
+#define PARETO_ALPHA 1.5
+
+static double sample(uint64_t *state, dist_t dist, double mean)
+{
+    double u = rng_uniform(state);
+
+    if (dist == DIST_PARETO)
+        return mean * (PARETO_ALPHA - 1) / PARETO_ALPHA /
+            pow(u, 1.0 / PARETO_ALPHA);
+    return -mean * log(u);
+}
+
+/* Burst lengths are at least one tick and capped to keep the tail sane */
+static unsigned int sample_ticks(uint64_t *state, dist_t dist, double mean)
+{
+    double x = sample(state, dist, mean);
+
+    if (x > mean * 1000.0)
+        x = mean * 1000.0;
+    return x < 1.0 ? 1 : (unsigned int)(x + 0.5);
+}
+
+extern void workload_params_default(workload_params_t *params)
+{
+    params->count = 100;
+    params->seed = 1;
+    params->arrival_mean = 10.0;
+    params->bursts = 10;
+    params->io_fraction = 0.5;
+    params->dist = DIST_EXPONENTIAL;
+    params->cpu_mean = 8.0;
+    params->io_mean = 2.0;
+    params->priorities = 4;
+    params->devices = 0;
+}
+
+extern int workload_parse_params(const char *spec, workload_params_t *params)
+{
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+
+    assert(copy != NULL);
+    for (tok = strtok_r(copy, ",", &save); tok != NULL && ret == 0;
+         tok = strtok_r(NULL, ",", &save))
+    {
+        char *value = strchr(tok, '=');
+        double d;
+
+        if (value == NULL)
+        {
+            ret = -1;
+            break;
+        }
+        *value++ = '\0';
+        if (strcmp(tok, "dist") == 0)
+        {
+            if (strcmp(value, "exp") == 0)
+                params->dist = DIST_EXPONENTIAL;
+            else if (strcmp(value, "pareto") == 0)
+                params->dist = DIST_PARETO;
+            else
+                ret = -1;
+            continue;
+        }
+
+        d = strtod(value, &end);
+        if (*end != '\0' || end == value || d < 0)
+            ret = -1;
+        else if (strcmp(tok, "n") == 0 && d >= 1 && d <= MAX_PROCESS_COUNT)
+            params->count = (unsigned int) d;
+        else if (strcmp(tok, "seed") == 0)
+            params->seed = (unsigned long) d;
+        else if (strcmp(tok, "arrival") == 0)
+            params->arrival_mean = d;
+        else if (strcmp(tok, "bursts") == 0 && d >= 1)
+            params->bursts = (unsigned int) d;
+        else if (strcmp(tok, "mix") == 0 && d <= 1)
+            params->io_fraction = d;
+        else if (strcmp(tok, "cpu") == 0 && d > 0)
+            params->cpu_mean = d;
+        else if (strcmp(tok, "io") == 0 && d > 0)
+            params->io_mean = d;
+        else if (strcmp(tok, "priorities") == 0 && d >= 1)
+            params->priorities = (unsigned int) d;
+        else if (strcmp(tok, "devices") == 0 && d <= MAX_IO_DEVICES)
+            params->devices = (unsigned int) d;
+        else
+            ret = -1;
+    }
+
+    if (ret != 0)
+        fprintf(stderr, "Bad workload generator spec '%s'\n", spec);
+    free(copy);
+    return ret;
+}
+
+extern void workload_generate(const workload_params_t *params)
+{
+    uint64_t state = params->seed;
+    double arrival = 0.0;
+    unsigned int n, k, half = params->priorities / 2;
+
+    process_table_alloc(params->count);
+    for (n = 0; n < params->count; n++)
+    {
+        int io_bound = rng_uniform(&state) <= params->io_fraction;
+        double cpu_mean = io_bound ? params->io_mean : params->cpu_mean;
+        double io_mean = io_bound ? params->cpu_mean : params->io_mean;
+        op_t *ops = malloc((2 * params->bursts) * sizeof(op_t));
+        char name[16];
+
+        assert(ops != NULL);
+        for (k = 0; k < 2 * params->bursts - 1; k++)
+        {
+            ops[k].type = (k % 2) ? OP_IO : OP_CPU;
+            ops[k].time = sample_ticks(&state, params->dist,
+                (k % 2) ? io_mean : cpu_mean);
+            ops[k].device = IO_DEVICE_ANY;
+            if ((k % 2) && params->devices > 0)
+                ops[k].device = 1 + (unsigned int)(rng_next(&state) %
+                    params->devices);
+        }
+        ops[k].type = OP_TERMINATE;
+        ops[k].time = 0;
+        ops[k].device = IO_DEVICE_ANY;
+
+        snprintf(name, sizeof(name), "%c%u", io_bound ? 'I' : 'C', n);
+        pcb_list_init_entry(&processes[n], n, name, ops);
+        processes[n].arrival = (unsigned int) arrival;
+        if (io_bound)
+            processes[n].priority = (int)(rng_next(&state) % (half ? half : 1));
+        else
+            processes[n].priority = (int)(half + rng_next(&state) %
+                (params->priorities - half));
+
+        if (params->arrival_mean > 0)
+            arrival += sample(&state, DIST_EXPONENTIAL, params->arrival_mean);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * workload.h
+ * Multithreaded OS Simulation for CS 2200
+ *
+ * Loading, saving and generating process workloads.
+ *
+ * A text workload has one process per line:
+ *
+ *     <name> [<attribute>=<value> ...] <burst> <burst> ...
+ *
+ * Attributes are arrival, priority, affinity (a CPU number, or -1), nice
+ * (-20 to 19), period, deadline and jitter for real-time tasks (see
+ * realtime.h), group, a control group number (see cgroup.h), and gang,
+ * which makes processes sharing a number the threads of one parallel job (0
+ * to GANG_MAX; see pcb_t).  Bursts alternate C<ticks> (CPU) and I<ticks>
+ * (I/O), starting and ending with a CPU burst.  An I/O burst may name its device, as in I5@2; otherwise the
+ * simulator picks one.  A real-time task has only CPU bursts, one per job.
+ * Blank lines and anything after a '#' are ignored.  For example:
+ *
+ *     Iapache arrival=0 priority=1 C2 I2@0 C3 I5@1 C1
+ *     Rsensor period=20 deadline=15 C3 C4 C3 C3
+ *
+ * The binary variant starts with WORKLOAD_MAGIC and stores the same records
+ * with every integer as an LEB128 varint; see workload.c for the layout.
+ * workload_load() accepts either, telling them apart by the magic.
+ */
+
+#ifndef __WORKLOAD_H__
+#define __WORKLOAD_H__
+
+#define WORKLOAD_MAGIC "OSWL"
+#define WORKLOAD_VERSION 2
+
+#define GANG_MAX 65535
+
+typedef enum { DIST_EXPONENTIAL = 0, DIST_PARETO } dist_t;
+
+/*
+ * Parameters for the synthetic workload generator.
+ *
+ *   count : number of processes
+ *   seed : random seed; the same parameters always give the same workload
+ *   arrival_mean : mean gap between arrivals in ticks (Poisson arrivals)
+ *   bursts : number of CPU bursts per process
+ *   io_fraction : fraction of processes that are I/O-bound
+ *   dist : burst length distribution
+ *   cpu_mean, io_mean : mean CPU and I/O burst for a CPU-bound process.  An
+ *        I/O-bound process swaps them around.
+ *   priorities : priorities are drawn from [0, priorities); I/O-bound
+ *        processes draw from the lower (more important) half
+ *   devices : if nonzero, each I/O burst goes to a random device in
+ *        [0, devices); otherwise the simulator picks one
+ */
+typedef struct {
+    unsigned int count;
+    unsigned long seed;
+    double arrival_mean;
+    unsigned int bursts;
+    double io_fraction;
+    dist_t dist;
+    double cpu_mean;
+    double io_mean;
+    unsigned int priorities;
+    unsigned int devices;
+} workload_params_t;
+
+
+/*
+ * workload_load() replaces the process table with the workload in path.
+ * Processes are sorted by arrival time and given PIDs in that order.
+ * Returns 0 on success; on failure prints the reason and returns -1.
+ */
+extern int workload_load(const char *path);
+
+/*
+ * workload_save() writes the current process table to path as text, or in the
+ * binary format if binary is nonzero.  Returns 0 on success, -1 on failure.
+ */
+extern int workload_save(const char *path, int binary);
+
+/*
+ * workload_params_default() fills params with the generator defaults.
+ * workload_parse_params() then overrides them from a comma-separated spec
+ * such as "n=1000,seed=7,arrival=5,mix=0.3,dist=pareto,devices=4".  Returns -1 on an
+ * unknown key or bad value.
+ */
+extern void workload_params_default(workload_params_t *params);
+extern int workload_parse_params(const char *spec, workload_params_t *params);
+
+/* workload_generate() replaces the process table with a synthetic workload */
+extern void workload_generate(const workload_params_t *params);
+
+#endif /* __WORKLOAD_H__ */
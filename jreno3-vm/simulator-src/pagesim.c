@@ -6,6 +6,8 @@
 #include "swap.h"
 #include "stats.h"
 #include "swapops.h"
+#include "tlb.h"
+#include "trace.h"
 
 /* Simulator data structures */
 uint8_t *mem;
@@ -14,16 +16,28 @@ pcb_t *current_process;
 uint8_t check_corruption = 0;
 uint8_t replacement = 0;
 
+/* Virtual address layout (see pagesim.h) */
+uint8_t vaddr_len;
+uint8_t pt_levels;
+uint8_t pt_bits[MAX_PT_LEVELS];
+uint8_t pt_shift[MAX_PT_LEVELS];
+
 /* Internal array of running processes (we only expose current_process
    to the user) */
 static pcb_t *procs;
 
-/* Constants used in parsing the trace file */
-static const char *START = "START";
-static const char *STOP = "STOP";
+/* Print only the statistics, not every access (-q) */
+static uint8_t quiet = 0;
+
+/* With -C, accesses between full checks are checked incrementally, against
+   the frame table as of the last check */
+static uint32_t check_interval = 1;
+static fte_t frame_snapshot[NUM_FRAMES];
 
 void print_help_and_exit(void);
 void check_validity(int checks);
+static void check_access(uint32_t pid, vpn_t vpn);
+int set_vaddr_layout(const char *spec);
 
 int main(int argc, char **argv)
 {
@@ -38,25 +52,43 @@ int main(int argc, char **argv)
     }
 
     /* Read command line options */
-    FILE *fin = 0;
+    trace_t trace = { 0 };
+    const char *convert_path = NULL;
     int opt;
-    while (-1 != (opt = getopt(argc, argv, "i:hscr:"))) {
+    set_vaddr_layout("10");
+    while (-1 != (opt = getopt(argc, argv, "i:hscC:r:v:t:w:b:q"))) {
         switch (opt) {
         case 'i':
-            fin = fopen(optarg, "r");
-
-            if (!fin) {
+            if (trace_open(&trace, optarg)) {
                 perror("Unable to open trace file");
                 exit(1);
             }
             break;
         case 's':
-            fin = stdin;
+            trace_open_stream(&trace, stdin);
+            break;
+        case 'b':
+            convert_path = optarg;
+            break;
+        case 'q':
+            quiet = 1;
             break;
         case 'c':
             check_corruption = 1;
             printf("-> Note: Strict memory corruption checking is enabled.\n");
             break;
+        case 'C': {
+            char *end;
+            unsigned long n = strtoul(optarg, &end, 10);
+            if (end == optarg || *end != '\0' || n < 1 || n > UINT32_MAX) {
+                fprintf(stderr, "Bad check interval: %s\n", optarg);
+                exit(1);
+            }
+            check_corruption = 1;
+            check_interval = (uint32_t) n;
+            printf("-> Note: Incremental memory corruption checking is enabled, with a full check every %u steps.\n", check_interval);
+            break;
+        }
         case 'r':
             if (strcmp(optarg, "random") == 0) {
                 replacement = RANDOM;
@@ -67,6 +99,23 @@ int main(int argc, char **argv)
                 exit(1);
             }
             break;
+        case 'v':
+            if (set_vaddr_layout(optarg)) {
+                fprintf(stderr, "Bad page table layout: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 't':
+            if (tlb_configure(optarg)) {
+                fprintf(stderr, "Bad TLB spec: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'w':
+            if (swap_queue_open(&swap_queue, optarg)) {
+                exit(1);
+            }
+            break;
         case 'h':
         default:
             /* Print some sort of usage message and exit */
@@ -74,85 +123,88 @@ int main(int argc, char **argv)
         }
     }
 
-    if (!fin) {
+    if (!trace.text && !trace.data) {
         fprintf(stderr, "ERROR: You must specify a trace filename or stdin.\n");
         print_help_and_exit();
     }
+    if (convert_path) {
+        long records = trace_convert(&trace, convert_path);
+        if (records < 0) {
+            perror(convert_path);
+            exit(1);
+        }
+        printf("Wrote %ld records to %s\n", records, convert_path);
+        trace_close(&trace);
+        exit(0);
+    }
     if (!replacement) {
         fprintf(stderr, "ERROR: You must select a replacement algorithm using -r.\n");
         print_help_and_exit();
     }
 
     /* Start the simulation */
-    char rw;
-    uint8_t data;
-    uint32_t address;
+    trace_record_t record;
     uint32_t pid;
-    char buf[120];
     uint32_t step = 0;
 
     system_init();
     if (check_corruption) check_validity(0);
 
-    while ((fgets(buf, sizeof(buf), fin))) {
-        /* Check if process is starting */
-        if (!strncmp(buf, START, 5)) {
-            /* Start scanning from the pid digits */
-            int ret = sscanf(buf+6, "%" PRIu32 "\n", &pid);
-            if (ret == 1) {
-                /* Initialize new process */
-                pcb_t *new_proc = &procs[pid];
-                new_proc->pid = pid;
-                new_proc->state = PROC_RUNNING;
-                proc_init(new_proc);
-                printf("%8u: PID %u started\n", step, pid);
-                if (check_corruption) check_validity(1);
-            } else {
-                printf("Unable to parse trace file: Invalid START command encountered\n");
-                exit(1);
-            }
-        } else if (!strncmp(buf, STOP, 4)) { /* Check if process is stopping */
-            /* Start scanning from the pid digits */
-            int ret = sscanf((buf+5), "%" PRIu32 "\n", &pid);
-            if (ret == 1) {
-                proc_cleanup(&procs[pid]);
-                procs[pid].saved_ptbr = 0;
-                procs[pid].state = PROC_STOPPED;
-                printf("%8u: PID %u stopped\n", step, pid);
-                if (check_corruption) check_validity(1);
-            } else {
-                printf("Unable to parse trace file: Invalid STOP command encountered\n");
-                exit(1);
+    while (trace_next(&trace, &record)) {
+        pid = record.pid;
+        if (record.op == TRACE_START) {
+            /* Initialize new process */
+            pcb_t *new_proc = &procs[pid];
+            new_proc->pid = pid;
+            new_proc->state = PROC_RUNNING;
+            proc_init(new_proc);
+            printf("%8u: PID %u started\n", step, pid);
+            if (check_corruption) check_validity(1);
+        } else if (record.op == TRACE_STOP) {
+            proc_cleanup(&procs[pid]);
+            procs[pid].saved_ptbr = 0;
+            procs[pid].state = PROC_STOPPED;
+            /* The PTBR still holds the freed table; if the PID starts
+               again, its next access must switch to the new one */
+            if (current_process == &procs[pid]) {
+                current_process = NULL;
             }
+            printf("%8u: PID %u stopped\n", step, pid);
+            if (check_corruption) check_validity(1);
         } else { /* Regular access trace */
-            int ret = sscanf(buf, "%u %c %x %hhu\n", &pid, &rw, &address, &data);
-            if (ret == 4) {
-                /* Context switch if need be */
-                if (!current_process || current_process->pid != pid) {
-                    context_switch(&procs[pid]);
-                    current_process = &procs[pid];
-                }
-                uint8_t new_data = mem_access(address, rw, data);
-                /* Print data for trace verification */
-                if (rw == 'r') {
-                    printf("%8u: %3u  r  0x%05x -> %02hhx\n", step, pid, address, new_data);
-                } else {
-                    printf("%8u: %3u  w  0x%05x <- %02hhx\n", step, pid, address, data);
-                }
-                if (check_corruption) check_validity(1);
-            } else {
-                printf("Unable to parse trace file: Invalid memory access command encountered\n");
+            vaddr_t address = record.address;
+            if ((address >> vaddr_len) != 0) {
+                printf("Unable to parse trace file: Address 0x%" PRIx64 " does not fit in %u bits\n", address, vaddr_len);
                 exit(1);
             }
+            /* Context switch if need be */
+            if (!current_process || current_process->pid != pid) {
+                context_switch(&procs[pid]);
+                current_process = &procs[pid];
+            }
+            char rw = record.op == TRACE_READ ? 'r' : 'w';
+            uint8_t new_data = mem_access(address, rw, record.data);
+            /* Print data for trace verification */
+            if (!quiet && rw == 'r') {
+                printf("%8u: %3u  r  0x%05" PRIx64 " -> %02hhx\n", step, pid, address, new_data);
+            } else if (!quiet) {
+                printf("%8u: %3u  w  0x%05" PRIx64 " <- %02hhx\n", step, pid, address, record.data);
+            }
+            if (check_corruption && step % check_interval == 0) {
+                check_validity(1);
+            } else if (check_corruption) {
+                check_access(pid, address >> OFFSET_LEN);
+            }
         }
 
         step++;                 /* Count step number for easy debugging */
     }
-    fclose(fin);
+    trace_close(&trace);
 
     /* Cleanup and print statistics */
     free(mem);
     free(procs);
+    tlb_free();
     compute_stats();
 
     printf("Total Accesses     : %" PRIu64 "\n", stats.accesses);
@@ -160,16 +212,205 @@ int main(int argc, char **argv)
     printf("Writes             : %" PRIu64 "\n", stats.writes);
     printf("Page Faults        : %" PRIu64 "\n", stats.page_faults);
     printf("Writes to disk     : %" PRIu64 "\n", stats.writebacks);
+    printf("Page Table Pages   : %" PRIu64 " max, %" PRIu64 " read from swap (%u-level, %u-bit addresses)\n", stats.pt_pages_max, stats.pt_swapins, pt_levels, vaddr_len);
+    if (tlb_enabled) {
+        uint64_t lookups = stats.tlb_l1_hits + stats.tlb_l2_hits + stats.tlb_misses;
+        printf("TLB Hit Rate       : %.2f%% (L1 %" PRIu64 ", L2 %" PRIu64 ", misses %" PRIu64 ")\n",
+               lookups ? 100.0 * (double) (lookups - stats.tlb_misses) / (double) lookups : 0.0,
+               stats.tlb_l1_hits, stats.tlb_l2_hits, stats.tlb_misses);
+        printf("Page Walks         : %" PRIu64 " (%" PRIu64 " memory reads)\n", stats.page_walks, stats.walk_reads);
+    }
     printf("Average Access Time: %f\n", stats.aat);
     printf("Max Swap Size      : %" PRIu64 " KB\n", (((uint64_t) swap_queue.size_max) * PAGE_SIZE) >> 10);
 
     if (swap_queue.size > 0)  {
         printf("Swap Not Freed     : %" PRIu64 " KB\n", (((uint64_t) swap_queue.size) * PAGE_SIZE) >> 10);
     }
+    swap_queue_free(&swap_queue);
+}
+
+/*
+ * Checks one entry, at the given level, of pid's page table for vpn.  If
+ * mapped_frames_accounted_for is given, a last-level entry also claims its
+ * frame there.
+ */
+static void check_entry(uint32_t pid, const pte_t *pte, uint8_t level, vpn_t vpn,
+                        uint8_t *mapped_frames_accounted_for) {
+    /* Check basic sanity of boolean flags */
+    if (pte->valid != 0 && pte->valid != 1) {
+        panic("Page table entry valid bit should either be zero or one");
+    }
+
+    if (pte->dirty != 0 && pte->dirty != 1) {
+        panic("Page table entry dirty bit should either be zero or one");
+    }
+
+    /* Entries above the last level point to the next level's tables,
+       which are either resident or in swap */
+    if (level + 1 < pt_levels) {
+        if (pte->dirty || (pte->valid && pte->swap)) {
+            panic("Page table entry above the last level should not be dirty, or swapped while valid");
+        }
+        if (pte->swap && !swap_queue_find(&swap_queue, pte->swap)) {
+            panic("Page table entry points to swap entry that does not exist");
+        }
+        if (pte->valid && (pte->pfn <= 0 || pte->pfn > NUM_FRAMES - 1)) {
+            panic("PFN of page table entry cannot be zero or >= the number of frames in the system");
+        }
+        return;
+    }
+
+    /* If valid, check sanity of pfn */
+    if (pte->valid) {
+        pfn_t found_pfn = pte->pfn;
+
+        /* Check basic ranges */
+        if (found_pfn <= 0 || found_pfn > NUM_FRAMES - 1)  {
+            panic("PFN of page table entry cannot be zero or >= the number of frames in the system");
+        }
+
+        if (frame_table[found_pfn].protected) {
+            panic("Page table entry should not map to a protected frame");
+        }
+
+        if (mapped_frames_accounted_for && mapped_frames_accounted_for[found_pfn]) {
+            panic("Duplicate PFN found in page table");
+        }
+
+        if (frame_table[found_pfn].process < procs
+            || frame_table[found_pfn].process >= procs + MAX_PID) {
+            panic("Mapped frame table entry contains invalid process pointer");
+        }
+
+        /* Check that frame table agrees with page table */
+        if (!frame_table[found_pfn].mapped
+            || !(frame_table[found_pfn].process->pid == pid)
+            || !(frame_table[found_pfn].vpn == vpn)) {
+            panic("Frame table is inconsistent with page table entry");
+        }
+        if (mapped_frames_accounted_for) {
+            mapped_frames_accounted_for[found_pfn] = 1;
+        }
+    }
+
+    /* Check the validity of swap entry */
+    if (pte->swap && !swap_queue_find(&swap_queue, pte->swap)) {
+        panic("Page table entry points to swap entry that does not exist");
+    }
+}
+
+/*
+ * Checks the table in frame table_pfn, at the given level, and everything
+ * below it.  prefix holds the VPN bits of the levels above.
+ */
+static void check_table(uint32_t pid, pfn_t table_pfn, uint8_t level, vpn_t prefix,
+                        uint8_t *protected_frames_accounted_for,
+                        uint8_t *mapped_frames_accounted_for) {
+    pte_t *pgtable = (pte_t *)(mem + (table_pfn * PAGE_SIZE));
+    size_t index;
+
+    /* Validate that page table page is marked as protected */
+    if (!frame_table[table_pfn].protected) {
+        panic("Frames corresponding to the page tables of running processes must be marked as protected");
+    }
+    if (protected_frames_accounted_for[table_pfn]) {
+        panic("Page table page is used twice");
+    }
+    protected_frames_accounted_for[table_pfn] = 1;
+
+    for (index = 0; index < ((size_t) 1 << pt_bits[level]); index++) {
+        vpn_t vpn = prefix | ((vpn_t) index << pt_shift[level]);
+
+        check_entry(pid, &pgtable[index], level, vpn, mapped_frames_accounted_for);
+        if (level + 1 < pt_levels && pgtable[index].valid) {
+            check_table(pid, pgtable[index].pfn, (uint8_t) (level + 1), vpn,
+                        protected_frames_accounted_for, mapped_frames_accounted_for);
+        }
+    }
+}
+
+/*
+ * Checks each table on the way to vpn in pid's page table, and the entries
+ * that lead there.  Returns the last-level entry, or NULL if a table on the
+ * way is not resident.
+ */
+static pte_t *check_path(uint32_t pid, vpn_t vpn) {
+    pfn_t table_pfn = procs[pid].saved_ptbr;
+    uint8_t level;
+
+    if (table_pfn <= 0 || table_pfn > NUM_FRAMES)  {
+        panic("PTBR of running process cannot be zero or >= the number of frames in the system");
+    }
+    for (level = 0; ; level++) {
+        size_t index = (size_t) (vpn >> pt_shift[level]) & (((size_t) 1 << pt_bits[level]) - 1);
+        pte_t *pte = (pte_t *)(mem + (table_pfn * PAGE_SIZE)) + index;
+
+        if (!frame_table[table_pfn].protected) {
+            panic("Frames corresponding to the page tables of running processes must be marked as protected");
+        }
+        check_entry(pid, pte, level, vpn, NULL);
+        if (level + 1 == pt_levels) {
+            return pte;
+        }
+        if (!pte->valid) {
+            return NULL;
+        }
+        table_pfn = pte->pfn;
+    }
+}
+
+/*
+ * Checks what an access by pid to vpn could have broken: the page table
+ * entries on the way to vpn, and both sides of every frame whose frame table
+ * entry changed since the last check.  A frame taken from a page must no
+ * longer be mapped by that page's entry, and a frame given to a page must be
+ * mapped by it.  What this misses, such as a page table left behind by a
+ * reclaim, is left to the full check every check_interval steps.
+ */
+static void check_access(uint32_t pid, vpn_t vpn) {
+    uint32_t pfn;
+
+    if ((void *)frame_table != (void *) mem) {
+        panic("Frame table should begin at the first frame in memory");
+    }
+    if (!frame_table[0].protected) {
+        panic("Frame 0 should be marked as protected");
+    }
+
+    check_path(pid, vpn);
+
+    for (pfn = 1; pfn < NUM_FRAMES; pfn++) {
+        fte_t *now = &frame_table[pfn], *then = &frame_snapshot[pfn];
+
+        if (now->protected == then->protected && now->mapped == then->mapped
+            && now->process == then->process && now->vpn == then->vpn) {
+            continue;
+        }
+
+        if (then->mapped && !then->protected && then->process->state == PROC_RUNNING) {
+            pte_t *pte = check_path(then->process->pid, then->vpn);
+            if (pte && pte->valid && pte->pfn == pfn
+                && (!now->mapped || now->protected || now->process != then->process || now->vpn != then->vpn)) {
+                panic("Frame table is inconsistent with page table entry");
+            }
+        }
+
+        if (now->mapped && !now->protected) {
+            if (now->process < procs || now->process >= procs + MAX_PID) {
+                panic("Mapped frame table entry contains invalid process pointer");
+            }
+            pte_t *pte = now->process->state == PROC_RUNNING
+                ? check_path(now->process->pid, now->vpn) : NULL;
+            if (!pte || !pte->valid || pte->pfn != pfn) {
+                panic("Found frame table entry marked as mapped with no corresponding page table entry");
+            }
+        }
+        *then = *now;
+    }
 }
 
 void check_validity(int checks) {
-    uint32_t pid, vpn, pfn, running_procs;
+    uint32_t pid, pfn;
     uint8_t protected_frames_accounted_for[NUM_FRAMES];
     uint8_t mapped_frames_accounted_for[NUM_FRAMES];
     for (pfn = 0; pfn < NUM_FRAMES; pfn++) {
@@ -186,26 +427,23 @@ void check_validity(int checks) {
         panic("Frame 0 should be marked as protected");
     }
     protected_frames_accounted_for[0] = 1;
+    memcpy(frame_snapshot, frame_table, sizeof(frame_snapshot));
 
     if (checks < 1) return;
 
-    /* Validate the PTBRs are correct */
-    running_procs = 0;
+    /* Validate the PTBRs and every page table reachable from them */
     for (pid = 0; pid < MAX_PID; pid++) {
         if (procs[pid].state == PROC_RUNNING) {
-            running_procs++;
-
             /* Validate that PTBR points to a correct physical frame number */
             pfn_t found_ptbr = procs[pid].saved_ptbr;
             if (found_ptbr <= 0 || found_ptbr > NUM_FRAMES)  {
                 panic("PTBR of running process cannot be zero or >= the number of frames in the system");
             }
 
-            /* Validate that page table page is marked as protected */
-            if (!frame_table[found_ptbr].protected) {
-                panic("Frames corresponding to the page tables of running processes must be marked as protected");
-            }
-            protected_frames_accounted_for[found_ptbr] = 1;
+            /* Scan the entire page table, make sure frame table is
+               consistent with any valid pages */
+            check_table(pid, found_ptbr, 0, 0, protected_frames_accounted_for,
+                        mapped_frames_accounted_for);
         }
     }
 
@@ -216,63 +454,6 @@ void check_validity(int checks) {
         }
     }
 
-    /* Validate the page table entries are correct */
-    for (pid = 0; pid < MAX_PID; pid++) {
-        if (procs[pid].state == PROC_RUNNING) {
-            pfn_t found_ptbr = procs[pid].saved_ptbr;
-
-            /* Scan the entire page table, make sure frame table is
-               consistent with any valid pages */
-            pte_t *pgtable = (pte_t *)(mem + (found_ptbr * PAGE_SIZE));
-            for (vpn = 0; vpn < NUM_PAGES; vpn++) {
-                /* Check basic sanity of boolean flags */
-                if (pgtable[vpn].valid != 0 && pgtable[vpn].valid != 1) {
-                    panic("Page table entry valid bit should either be zero or one");
-                }
-
-                if (pgtable[vpn].dirty != 0 && pgtable[vpn].dirty != 1) {
-                    panic("Page table entry dirty bit should either be zero or one");
-                }
-
-                /* If valid, check sanity of pfn */
-                if (pgtable[vpn].valid) {
-                    pfn_t found_pfn = pgtable[vpn].pfn;
-
-                    /* Check basic ranges */
-                    if (found_pfn <= 0 || found_pfn > NUM_FRAMES - 1)  {
-                        panic("PFN of page table entry cannot be zero or >= the number of frames in the system");
-                    }
-
-                    if (protected_frames_accounted_for[found_pfn]) {
-                        panic("Page table entry should not map to a protected frame");
-                    }
-
-                    if (mapped_frames_accounted_for[found_pfn]) {
-                        panic("Duplicate PFN found in page table");
-                    }
-
-                    if (frame_table[found_pfn].process < procs
-                        || frame_table[found_pfn].process >= procs + MAX_PID) {
-                        panic("Mapped frame table entry contains invalid process pointer");
-                    }
-
-                    /* Check that frame table agrees with page table */
-                    if (!frame_table[found_pfn].mapped
-                        || !(frame_table[found_pfn].process->pid == pid)
-                        || !(frame_table[found_pfn].vpn == vpn)) {
-                        panic("Frame table is inconsistent with page table entry");
-                    }
-                    mapped_frames_accounted_for[found_pfn] = 1;
-                }
-
-                /* Check the validity of swap entry */
-                if (pgtable[vpn].swap && !swap_queue_find(&swap_queue, pgtable[vpn].swap)) {
-                    panic("Page table entry points to swap entry that does not exist");
-                }
-            }
-        }
-    }
-
     /* Check that all frames that are mapped are accounted for */
     for (pfn = 0; pfn < NUM_FRAMES; pfn++){
         if (!frame_table[pfn].protected && frame_table[pfn].mapped && !(mapped_frames_accounted_for[pfn])) {
@@ -281,13 +462,58 @@ void check_validity(int checks) {
     }
 }
 
+/*
+ * Sets the virtual address layout from a list of index widths, root level
+ * first, such as "10:10:10".  Each level's table must fit in a page, and the
+ * address in MAX_VADDR_LEN bits.  Returns nonzero on a bad spec.
+ */
+int set_vaddr_layout(const char *spec) {
+    uint8_t bits[MAX_PT_LEVELS], levels = 0, len = OFFSET_LEN;
+    const char *p = spec;
+    char *end;
+
+    do {
+        unsigned long n = strtoul(p, &end, 10);
+        if (end == p || n < 1 || ((size_t) 1 << n) > PTES_PER_TABLE
+            || levels == MAX_PT_LEVELS || len + n > MAX_VADDR_LEN) {
+            return 1;
+        }
+        bits[levels++] = (uint8_t) n;
+        len = (uint8_t) (len + n);
+        p = end + 1;
+    } while (*end == ':');
+    if (*end != '\0') {
+        return 1;
+    }
+
+    pt_levels = levels;
+    vaddr_len = len;
+    len = 0;
+    while (levels-- > 0) {
+        pt_bits[levels] = bits[levels];
+        pt_shift[levels] = len;
+        len = (uint8_t) (len + bits[levels]);
+    }
+    return 0;
+}
+
 void print_help_and_exit() {
     printf("./vm-sim [OPTIONS] -i traces/file.trace -r<replacement algorithm>\n");
-    printf("  -i\t\tReads the trace from the specified path\n");
-    printf("  -s\t\tReads the trace from standard input\n");
+    printf("  -i\t\tReads the trace, text or binary (see -b), from the specified path\n");
+    printf("  -s\t\tReads a text trace from standard input\n");
+    printf("  -b\t\tConverts the trace to binary at the given path, then exits\n");
+    printf("  -q\t\tPrints only the statistics, not every access\n");
     printf("  -r\t\tSelect the replacement algorithm (either 'random' or 'clocksweep')\n");
+    printf("  -v\t\tPage table index widths, root level first (default 10)\n");
+    printf("    \t\te.g. 10:10:10 for a three-level table of 44-bit addresses\n");
+    printf("  -t\t\tModel address translation cost with a TLB tagged by ASID,\n");
+    printf("    \t\te.g. l1=64:4,l2=1024:8 (entries:ways), default, or none\n");
+    printf("  -w\t\tKeeps swapped pages in a new file at the given path\n");
+    printf("    \t\tinstead of in memory\n");
     printf("  -c\t\tEnables strict memory corruption checking\n");
     printf("    \t\t(automatically checks a variety of conditions that can cause bugs)\n");
+    printf("  -C\t\tLike -c, but checks each access only for what it changed,\n");
+    printf("    \t\tand everything only every given number of steps\n");
     printf("  -h\t\tThis helpful output\n");
     exit(0);
 }
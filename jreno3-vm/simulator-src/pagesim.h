@@ -30,16 +30,41 @@ typedef struct process {
  */
 
 #define PADDR_LEN 20
-#define VADDR_LEN 24
 #define OFFSET_LEN 14
 
 #define PAGE_SIZE (1 << OFFSET_LEN)
 
 #define MEM_SIZE (1 << PADDR_LEN)
 
-#define NUM_PAGES (1 << (VADDR_LEN - OFFSET_LEN))
 #define NUM_FRAMES (1 << (PADDR_LEN - OFFSET_LEN))
 
+/*
+ * Virtual address layout, chosen with -v.
+ *
+ * The page table has pt_levels levels, each one page of page table entries.
+ * A virtual address is split, from the top, into an index for each level and
+ * the offset into the page:
+ *
+ *   ----------------------------------------------------------
+ *   | index 0 | index 1 | ... | index pt_levels-1 |  Offset  |
+ *   ----------------------------------------------------------
+ *
+ * pt_bits[n] is the width of level n's index, and pt_shift[n] is where it
+ * starts in the VPN.  Level 0 is the table the PTBR points to; the entries of
+ * the last level map pages, and those of the others map the next level's
+ * tables.  Only the root table exists when a process starts: the others are
+ * allocated the first time something under them is mapped.
+ *
+ * The default is a single level of 10 bits, for 24-bit virtual addresses.
+ */
+#define MAX_VADDR_LEN 48
+#define MAX_PT_LEVELS 4
+
+extern uint8_t vaddr_len;
+extern uint8_t pt_levels;
+extern uint8_t pt_bits[MAX_PT_LEVELS];
+extern uint8_t pt_shift[MAX_PT_LEVELS];
+
 /*
  * Global Data Structures
  */
@@ -11,6 +11,9 @@
  * A page table maps indices (often referred to as virtual page numbers, or
  * VPNs) to corresponding physical frames in memory. Note that the VPN is not
  * stored in the entry - it's the index into the page table!
+ *
+ * In every level but the last (see pagesim.h), valid and pfn say where the
+ * next level's table is, and dirty and swap are unused.
  */
 typedef struct ptable_entry {
     uint8_t valid;              /* 1 if the entry is mapped to a valid frame, 0
@@ -25,6 +28,9 @@ typedef struct ptable_entry {
                                    swap_read() and swap_write() */
 } pte_t;
 
+/* Each level of the page table fills one page */
+#define PTES_PER_TABLE (PAGE_SIZE / sizeof(pte_t))
+
 /*
  * An entry in the frame table.
  *
@@ -70,6 +76,8 @@ void context_switch(pcb_t *proc);
 void proc_cleanup(pcb_t *proc);
 
 uint8_t mem_access(vaddr_t address, char write, uint8_t data);
+pte_t *pt_walk(pfn_t root, vpn_t vpn, int alloc);
+void pt_reclaim(pcb_t *proc, vpn_t vpn);
 
 pfn_t free_frame(void);
 void page_fault(vaddr_t address);
@@ -19,6 +19,18 @@ typedef struct stats_t {
     uint64_t page_faults;
     /* Writebacks to disk */
     uint64_t writebacks;
+    /* Frames holding page tables, now and at most, and tables read back
+       from swap */
+    uint64_t pt_pages;
+    uint64_t pt_pages_max;
+    uint64_t pt_swapins;
+    /* With -t: TLB lookups by where they hit, page table walks, and the
+       page table entries those walks read from memory */
+    uint64_t tlb_l1_hits;
+    uint64_t tlb_l2_hits;
+    uint64_t tlb_misses;
+    uint64_t page_walks;
+    uint64_t walk_reads;
     /* Average Access Time */
     double aat;
 } stats_t;
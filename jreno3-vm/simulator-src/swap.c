@@ -1,71 +1,155 @@
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "swap.h"
 #include "util.h"
 
-static uint64_t TOKEN = 1;
+#define SWAP_MIN_SLOTS 64
 
-swap_info_t *create_entry(void)
+static uint32_t slot_of(uint64_t token)
 {
-    swap_info_t *new_info = calloc(1, sizeof(swap_info_t));
-    if (!new_info) {
-        panic("could not allocate swap entry");
-    }
-    new_info->token = TOKEN++;
-    return new_info;
+    return (uint32_t) (token & UINT32_MAX) - 1;
 }
 
-void swap_queue_enqueue(swap_queue_t *queue, swap_info_t* info)
+/* Doubles the store, chaining the new slots onto the free list */
+static void swap_queue_grow(swap_queue_t *queue)
 {
-    info->next = NULL;
-    if (queue->head == NULL) {
-        queue->head = queue->tail = info;
+    uint32_t old = queue->capacity;
+    uint32_t capacity = old ? old * 2 : SWAP_MIN_SLOTS;
+    swap_info_t *slots;
+    uint8_t *pages;
+
+    if (old >= SWAP_NO_SLOT / 2) {
+        panic("swap is full");
+    }
+    slots = realloc(queue->slots, sizeof(swap_info_t) * capacity);
+    if (!slots) {
+        panic("could not allocate swap space");
+    }
+    queue->slots = slots;
+    if (queue->file_backed) {
+        /* Only extends the file; the new slots stay holes until written */
+        if (ftruncate(queue->fd, (off_t) PAGE_SIZE * capacity)) {
+            panic("could not extend the swap file");
+        }
     } else {
-        queue->tail->next = info;
-        queue->tail = info;
+        pages = realloc(queue->pages, (size_t) PAGE_SIZE * capacity);
+        if (!pages) {
+            panic("could not allocate swap space");
+        }
+        queue->pages = pages;
+    }
+    for (uint32_t n = old; n < capacity; n++) {
+        slots[n].token = 0;
+        slots[n].generation = 1;
+        slots[n].next_free = n + 1 < capacity ? n + 1 : queue->free_head;
+    }
+    queue->free_head = old;
+    queue->capacity = capacity;
+}
+
+int swap_queue_open(swap_queue_t *queue, const char *path)
+{
+    int fd;
+
+    if (queue->file_backed) {
+        fprintf(stderr, "%s: a swap file is already open\n", path);
+        return -1;
+    }
+    /* Refuses an existing file rather than overwrite it */
+    fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    /* Unlinked now, the file goes away however the simulator exits */
+    unlink(path);
+    queue->fd = fd;
+    queue->file_backed = 1;
+    return 0;
+}
+
+swap_info_t *swap_queue_alloc(swap_queue_t *queue)
+{
+    swap_info_t *info;
+    uint32_t slot;
+
+    if (!queue->capacity || queue->free_head == SWAP_NO_SLOT) {
+        if (!queue->capacity) {
+            queue->free_head = SWAP_NO_SLOT;
+        }
+        swap_queue_grow(queue);
     }
+    slot = queue->free_head;
+    info = &queue->slots[slot];
+    queue->free_head = info->next_free;
+    info->token = (uint64_t) info->generation << 32 | (slot + 1);
+
     queue->size++;
     if (queue->size > queue->size_max) {
         queue->size_max = queue->size;
     }
+    return info;
 }
 
-
 void swap_queue_dequeue(swap_queue_t *queue, uint64_t token)
 {
-    swap_info_t *curr = queue->head;
-    swap_info_t *prev = NULL;
-
-    while (curr) {
-        if (curr->token == token) {
-            if (prev) {
-                prev->next = curr->next;
-            } else {
-                queue->head = curr->next;
-            }
-            if (curr == queue->tail) {
-                queue->tail = prev;
-            }
-            break;
-        }
-        prev = curr;
-        curr = curr->next;
+    swap_info_t *info = swap_queue_find(queue, token);
+
+    if (!info) {
+        return;
     }
+    info->token = 0;
+    info->generation++;
+    info->next_free = queue->free_head;
+    queue->free_head = (uint32_t) (info - queue->slots);
     queue->size--;
-    curr->next = NULL;
-    free(curr);
 }
 
 swap_info_t *swap_queue_find(swap_queue_t *queue, uint64_t token)
 {
-    swap_info_t *curr = queue->head;
+    uint32_t slot = slot_of(token);
 
-    while (curr) {
-        if (curr->token == token) {
-            return curr;
-        }
-        curr = curr->next;
+    if (token == 0 || slot >= queue->capacity ||
+        queue->slots[slot].token != token) {
+        return NULL;
+    }
+    return &queue->slots[slot];
+}
+
+void swap_queue_read(swap_queue_t *queue, const swap_info_t *info, void *dst)
+{
+    size_t slot = (size_t) (info - queue->slots);
+
+    if (!queue->file_backed) {
+        memcpy(dst, queue->pages + (size_t) PAGE_SIZE * slot, PAGE_SIZE);
+    } else if (pread(queue->fd, dst, PAGE_SIZE, (off_t) ((size_t) PAGE_SIZE * slot)) != PAGE_SIZE) {
+        panic("could not read the swap file");
+    }
+}
+
+void swap_queue_write(swap_queue_t *queue, const swap_info_t *info, const void *src)
+{
+    size_t slot = (size_t) (info - queue->slots);
+
+    if (!queue->file_backed) {
+        memcpy(queue->pages + (size_t) PAGE_SIZE * slot, src, PAGE_SIZE);
+    } else if (pwrite(queue->fd, src, PAGE_SIZE, (off_t) ((size_t) PAGE_SIZE * slot)) != PAGE_SIZE) {
+        panic("could not write the swap file");
+    }
+}
+
+void swap_queue_free(swap_queue_t *queue)
+{
+    free(queue->slots);
+    free(queue->pages);
+    if (queue->file_backed) {
+        close(queue->fd);
+        queue->file_backed = 0;
     }
-    return NULL;
+    queue->slots = NULL;
+    queue->pages = NULL;
+    queue->capacity = 0;
 }
@@ -5,22 +5,43 @@
 
 typedef uint64_t swap_entry_t;
 
-typedef struct swap_info {
-
-    uint64_t token;
-    uint8_t  page_data[PAGE_SIZE];
+/*
+ * The swap store keeps pages in numbered slots.  A swap entry (token) is
+ * the slot number plus one in its low 32 bits, so that 0 is never an entry,
+ * and the slot's generation in its high 32 bits.  The generation goes up
+ * each time the slot is freed, so a stale entry to a reused slot is not
+ * found.  Free slots are chained through next_free, and the store doubles
+ * when none is left.
+ *
+ * Page data lives in memory unless swap_queue_open() gives the store a swap
+ * file, which it may do only once.  Slot n is then the PAGE_SIZE bytes at
+ * n * PAGE_SIZE.  The file is sparse and grows with the store, so only pages
+ * actually written take disk space, and none of them stay in the
+ * simulator's memory.
+ */
+#define SWAP_NO_SLOT UINT32_MAX
 
-    struct swap_info *next;
+typedef struct swap_info {
+    uint64_t token;             /* The entry stored here, or 0 if free */
+    uint32_t generation;
+    uint32_t next_free;
 } swap_info_t;
 
 typedef struct _swap_queue_t {
-    swap_info_t *head;
-    swap_info_t *tail;
+    swap_info_t *slots;
+    uint8_t *pages;             /* PAGE_SIZE bytes for each slot */
+    uint8_t file_backed;
+    int fd;                     /* The swap file, if file_backed */
+    uint32_t capacity;
+    uint32_t free_head;
     uint64_t size;
     uint64_t size_max;
 } swap_queue_t;
 
-swap_info_t *create_entry(void);
-void swap_queue_enqueue(swap_queue_t *queue, swap_info_t* info);
+int swap_queue_open(swap_queue_t *queue, const char *path);
+swap_info_t *swap_queue_alloc(swap_queue_t *queue);
 void swap_queue_dequeue(swap_queue_t *queue, uint64_t token);
 swap_info_t *swap_queue_find(swap_queue_t *queue, uint64_t token);
+void swap_queue_read(swap_queue_t *queue, const swap_info_t *info, void *dst);
+void swap_queue_write(swap_queue_t *queue, const swap_info_t *info, const void *src);
+void swap_queue_free(swap_queue_t *queue);
@@ -9,18 +9,17 @@ void swap_read(pte_t *pte, void *dst) {
     if (!info) {
         panic("Attempted to read an invalid swap entry.\nHINT: How do you check if a swap entry exists, and if it does not, what should you put in memory instead?");
     }
-    memcpy(dst, info->page_data, PAGE_SIZE);
+    swap_queue_read(&swap_queue, info, dst);
 }
 
 void swap_write(pte_t *pte, void *src) {
 
     swap_info_t *info = swap_queue_find(&swap_queue, pte->swap);
     if (!info) {
-        info = create_entry(); // creates a swap entry and assigns a token
-        swap_queue_enqueue(&swap_queue, info);
+        info = swap_queue_alloc(&swap_queue); // takes a free slot and assigns a token
         pte->swap = info->token;
     }
-    memcpy(info->page_data, src, PAGE_SIZE);
+    swap_queue_write(&swap_queue, info, src);
 }
 
 void swap_free(pte_t *pte) {
@@ -0,0 +1,194 @@
+#include "stats.h"
+#include "tlb.h"
+
+uint8_t tlb_enabled = 0;
+uint16_t ASID;
+
+static tlb_level_t l1, l2;
+static uint64_t tlb_clock;
+
+static int tlb_level_init(tlb_level_t *level, unsigned long entries,
+                          unsigned long ways)
+{
+    free(level->entries);
+    level->entries = NULL;
+    level->sets = level->ways = 0;
+    if (entries == 0) {
+        return 0;
+    }
+    if (ways == 0 || ways > TLB_MAX_WAYS || entries % ways != 0) {
+        return 1;
+    }
+    level->entries = calloc(entries, sizeof(tlb_entry_t));
+    if (!level->entries) {
+        panic("could not allocate the TLB");
+    }
+    level->sets = (uint32_t) (entries / ways);
+    level->ways = (uint32_t) ways;
+    return 0;
+}
+
+int tlb_configure(const char *spec)
+{
+    char *copy = strdup(spec), *save, *tok, *end;
+    int ret = 0;
+
+    if (!copy) {
+        panic("could not allocate the TLB spec");
+    }
+    tlb_enabled = 1;
+    tlb_level_init(&l1, 64, 4);
+    tlb_level_init(&l2, 1024, 8);
+    for (tok = strtok_r(copy, ",", &save); tok && !ret;
+         tok = strtok_r(NULL, ",", &save)) {
+        unsigned long entries, ways = 1;
+        tlb_level_t *level;
+
+        if (strcmp(tok, "default") == 0) {
+            continue;
+        } else if (strcmp(tok, "none") == 0) {
+            tlb_level_init(&l1, 0, 0);
+            tlb_level_init(&l2, 0, 0);
+            continue;
+        } else if (strncmp(tok, "l1=", 3) == 0) {
+            level = &l1;
+        } else if (strncmp(tok, "l2=", 3) == 0) {
+            level = &l2;
+        } else {
+            ret = 1;
+            break;
+        }
+        entries = strtoul(tok + 3, &end, 10);
+        if (end == tok + 3) {
+            ret = 1;
+            break;
+        }
+        if (*end == ':') {
+            char *ways_end;
+            ways = strtoul(end + 1, &ways_end, 10);
+            end = ways_end;
+        }
+        ret = *end != '\0' || entries > 1ul << 20 ||
+            tlb_level_init(level, entries, ways);
+    }
+    free(copy);
+    return ret;
+}
+
+static tlb_entry_t *level_find(tlb_level_t *level, uint16_t asid, vpn_t vpn)
+{
+    tlb_entry_t *set;
+
+    if (!level->sets) {
+        return NULL;
+    }
+    set = level->entries + (size_t) (vpn % level->sets) * level->ways;
+    for (uint32_t way = 0; way < level->ways; way++) {
+        if (set[way].valid && set[way].asid == asid && set[way].vpn == vpn) {
+            return &set[way];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Fills the first invalid way of vpn's set, else the least recently used.
+ * A translation L2 evicts is invalidated in L1 too, keeping L2 inclusive.
+ */
+static tlb_entry_t *level_fill(tlb_level_t *level, uint16_t asid, vpn_t vpn,
+                               pfn_t pfn, uint8_t dirty)
+{
+    tlb_entry_t *set, *victim;
+
+    if (!level->sets) {
+        return NULL;
+    }
+    set = level->entries + (size_t) (vpn % level->sets) * level->ways;
+    victim = set;
+    for (uint32_t way = 0; way < level->ways && victim->valid; way++) {
+        if (!set[way].valid || set[way].used < victim->used) {
+            victim = &set[way];
+        }
+    }
+    if (level == &l2 && victim->valid) {
+        tlb_entry_t *copy = level_find(&l1, victim->asid, victim->vpn);
+        if (copy) {
+            copy->valid = 0;
+        }
+    }
+    victim->valid = 1;
+    victim->dirty = dirty;
+    victim->asid = asid;
+    victim->vpn = vpn;
+    victim->pfn = pfn;
+    victim->used = ++tlb_clock;
+    return victim;
+}
+
+tlb_entry_t *tlb_lookup(uint16_t asid, vpn_t vpn)
+{
+    tlb_entry_t *entry;
+
+    if ((entry = level_find(&l1, asid, vpn))) {
+        stats.tlb_l1_hits++;
+    } else if ((entry = level_find(&l2, asid, vpn))) {
+        stats.tlb_l2_hits++;
+        entry->used = ++tlb_clock;
+        if (l1.sets) {
+            entry = level_fill(&l1, asid, vpn, entry->pfn, entry->dirty);
+        }
+    } else {
+        stats.tlb_misses++;
+        return NULL;
+    }
+    entry->used = ++tlb_clock;
+    return entry;
+}
+
+tlb_entry_t *tlb_insert(uint16_t asid, vpn_t vpn, pfn_t pfn, uint8_t dirty)
+{
+    tlb_entry_t *entry;
+
+    /* The translation may already be cached, such as when a write walks to
+       set the dirty bit */
+    tlb_invalidate(asid, vpn);
+    entry = level_fill(&l2, asid, vpn, pfn, dirty);
+    if (l1.sets) {
+        entry = level_fill(&l1, asid, vpn, pfn, dirty);
+    }
+    return entry;
+}
+
+void tlb_invalidate(uint16_t asid, vpn_t vpn)
+{
+    tlb_entry_t *entry;
+
+    if ((entry = level_find(&l1, asid, vpn))) {
+        entry->valid = 0;
+    }
+    if ((entry = level_find(&l2, asid, vpn))) {
+        entry->valid = 0;
+    }
+}
+
+void tlb_flush_asid(uint16_t asid)
+{
+    for (size_t i = 0; i < (size_t) l1.sets * l1.ways; i++) {
+        if (l1.entries[i].asid == asid) {
+            l1.entries[i].valid = 0;
+        }
+    }
+    for (size_t i = 0; i < (size_t) l2.sets * l2.ways; i++) {
+        if (l2.entries[i].asid == asid) {
+            l2.entries[i].valid = 0;
+        }
+    }
+}
+
+void tlb_free(void)
+{
+    free(l1.entries);
+    free(l2.entries);
+    l1.entries = l2.entries = NULL;
+    l1.sets = l2.sets = 0;
+}
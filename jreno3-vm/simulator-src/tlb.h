@@ -0,0 +1,70 @@
+#pragma once
+
+#include "pagesim.h"
+#include "types.h"
+
+/*
+ * A two-level translation lookaside buffer, enabled with -t.
+ *
+ * Each level is set-associative, indexed by VPN and replaced LRU within a
+ * set.  Entries are tagged with the address space ID (ASID) of the process
+ * they belong to, so a context switch keeps them; the OS must instead
+ * invalidate an entry when it unmaps the page, and flush an ASID when its
+ * process exits.  The levels are inclusive: L2 holds everything L1 does,
+ * and an entry L2 evicts is invalidated in L1 as well.
+ */
+#define TLB_MAX_WAYS 16
+
+typedef struct tlb_entry {
+    uint8_t valid;
+    uint8_t dirty;              /* The page was written through this entry */
+    uint16_t asid;
+    vpn_t vpn;
+    pfn_t pfn;
+    uint64_t used;              /* When the entry was last used, for LRU */
+} tlb_entry_t;
+
+typedef struct tlb_level {
+    uint32_t sets;
+    uint32_t ways;
+    tlb_entry_t *entries;       /* sets * ways entries, a set at a time */
+} tlb_level_t;
+
+/* 1 if translation is modelled (-t), even with no TLB */
+extern uint8_t tlb_enabled;
+
+/* The address space ID of the running process, set on a context switch */
+extern uint16_t ASID;
+
+/**
+ * Sets up the TLB from a spec such as "l1=64:4,l2=1024:8" (entries:ways for
+ * each level), "default" for those sizes, or "none" to model page walks
+ * without a TLB.  A level may be left out, or given 0 entries, to omit it.
+ *
+ * @return nonzero on a bad spec
+ */
+int tlb_configure(const char *spec);
+
+/**
+ * Looks up asid's translation for vpn, L1 first.  An L2 hit is copied into
+ * L1.  Counts the hit or miss in stats.
+ *
+ * @return the entry, or NULL on a miss
+ */
+tlb_entry_t *tlb_lookup(uint16_t asid, vpn_t vpn);
+
+/**
+ * Caches a translation found by a page walk in both levels.
+ *
+ * @return the L1 entry, or the L2 one if there is no L1, or NULL if there
+ * is no TLB
+ */
+tlb_entry_t *tlb_insert(uint16_t asid, vpn_t vpn, pfn_t pfn, uint8_t dirty);
+
+/* Drops asid's translation for vpn, if cached */
+void tlb_invalidate(uint16_t asid, vpn_t vpn);
+
+/* Drops every translation of asid */
+void tlb_flush_asid(uint16_t asid);
+
+void tlb_free(void);
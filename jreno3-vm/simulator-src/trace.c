@@ -0,0 +1,208 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+#include "util.h"
+
+#define MAGIC_LEN (sizeof(TRACE_MAGIC) - 1)
+
+static void parse_error(const char *what)
+{
+    printf("Unable to parse trace file: %s\n", what);
+    exit(1);
+}
+
+int trace_open(trace_t *trace, const char *path)
+{
+    struct stat st;
+    void *data;
+    int fd = open(path, O_RDONLY);
+
+    memset(trace, 0, sizeof(*trace));
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st)) {
+        close(fd);
+        return -1;
+    }
+
+    if ((size_t) st.st_size >= MAGIC_LEN) {
+        data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED && !memcmp(data, TRACE_MAGIC, MAGIC_LEN)) {
+            madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+            close(fd);
+            trace->data = data;
+            trace->size = (size_t) st.st_size;
+            trace->pos = MAGIC_LEN;
+            trace->last = calloc(MAX_PID, sizeof(vaddr_t));
+            if (!trace->last) {
+                panic("could not allocate the trace reader");
+            }
+            return 0;
+        }
+        if (data != MAP_FAILED) {
+            munmap(data, (size_t) st.st_size);
+        }
+    }
+
+    /* Anything without the magic is read as text */
+    trace->text = fdopen(fd, "r");
+    if (!trace->text) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+void trace_open_stream(trace_t *trace, FILE *stream)
+{
+    memset(trace, 0, sizeof(*trace));
+    trace->text = stream;
+}
+
+static int text_next(trace_t *trace, trace_record_t *record)
+{
+    char buf[120];
+    char rw;
+
+    if (!fgets(buf, sizeof(buf), trace->text)) {
+        return 0;
+    }
+    if (!strncmp(buf, "START", 5)) {
+        /* Start scanning from the pid digits */
+        if (sscanf(buf + 6, "%" PRIu32 "\n", &record->pid) != 1) {
+            parse_error("Invalid START command encountered");
+        }
+        record->op = TRACE_START;
+    } else if (!strncmp(buf, "STOP", 4)) {
+        if (sscanf(buf + 5, "%" PRIu32 "\n", &record->pid) != 1) {
+            parse_error("Invalid STOP command encountered");
+        }
+        record->op = TRACE_STOP;
+    } else {
+        if (sscanf(buf, "%u %c %" SCNx64 " %hhu\n", &record->pid, &rw,
+                   &record->address, &record->data) != 4) {
+            parse_error("Invalid memory access command encountered");
+        }
+        record->op = rw == 'r' ? TRACE_READ : TRACE_WRITE;
+    }
+    if (record->pid >= MAX_PID) {
+        parse_error("PID out of range");
+    }
+    return 1;
+}
+
+static uint64_t read_varint(trace_t *trace)
+{
+    uint64_t value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (trace->pos == trace->size) {
+            parse_error("Binary trace is truncated");
+        }
+        uint8_t byte = trace->data[trace->pos++];
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    parse_error("Binary trace has an overlong number");
+    return 0;
+}
+
+static int binary_next(trace_t *trace, trace_record_t *record)
+{
+    uint64_t pid, zigzag;
+    uint8_t op;
+
+    if (trace->pos == trace->size) {
+        return 0;
+    }
+    op = trace->data[trace->pos++];
+    if (op > TRACE_WRITE) {
+        parse_error("Binary trace has an unknown record");
+    }
+    record->op = (trace_op_t) op;
+    pid = read_varint(trace);
+    if (pid >= MAX_PID) {
+        parse_error("PID out of range");
+    }
+    record->pid = (uint32_t) pid;
+    if (op == TRACE_READ || op == TRACE_WRITE) {
+        zigzag = read_varint(trace);
+        trace->last[pid] += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        record->address = trace->last[pid];
+        if (trace->pos == trace->size) {
+            parse_error("Binary trace is truncated");
+        }
+        record->data = trace->data[trace->pos++];
+    }
+    return 1;
+}
+
+int trace_next(trace_t *trace, trace_record_t *record)
+{
+    return trace->data ? binary_next(trace, record) : text_next(trace, record);
+}
+
+void trace_close(trace_t *trace)
+{
+    if (trace->data) {
+        munmap((void *) (uintptr_t) trace->data, trace->size);
+    } else if (trace->text) {
+        fclose(trace->text);
+    }
+    free(trace->last);
+    memset(trace, 0, sizeof(*trace));
+}
+
+static void write_varint(FILE *out, uint64_t value)
+{
+    while (value >= 0x80) {
+        putc((int) (value & 0x7f) | 0x80, out);
+        value >>= 7;
+    }
+    putc((int) value, out);
+}
+
+long trace_convert(trace_t *trace, const char *path)
+{
+    trace_record_t record;
+    vaddr_t *last = calloc(MAX_PID, sizeof(vaddr_t));
+    FILE *out = fopen(path, "wb");
+    long count = 0;
+
+    if (!last) {
+        panic("could not allocate the trace writer");
+    }
+    if (!out) {
+        free(last);
+        return -1;
+    }
+    fwrite(TRACE_MAGIC, 1, MAGIC_LEN, out);
+    while (trace_next(trace, &record)) {
+        putc(record.op, out);
+        write_varint(out, record.pid);
+        if (record.op == TRACE_READ || record.op == TRACE_WRITE) {
+            uint64_t delta = record.address - last[record.pid];
+            write_varint(out, (delta << 1) ^ (0 - (delta >> 63)));
+            last[record.pid] = record.address;
+            putc(record.data, out);
+        }
+        count++;
+    }
+    free(last);
+    if (ferror(out)) {
+        count = -1;
+    }
+    if (fclose(out)) {
+        count = -1;
+    }
+    return count;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pagesim.h"
+#include "types.h"
+
+/*
+ * Traces, as text or in a compact binary form.
+ *
+ * A text trace has one command per line: "START pid", "STOP pid", or
+ * "pid r|w address data", with the address in hex and the data in decimal.
+ *
+ * A binary trace is TRACE_MAGIC and then one record per command: the
+ * trace_op_t as a byte, then the PID as an unsigned LEB128 varint.  An
+ * access follows that with its address, as a zigzag varint of the
+ * difference from the same process's last address, and its data byte.
+ * Nearby accesses so take three to five bytes.  The file is mapped, not
+ * read, so records are decoded straight out of the page cache.
+ */
+#define TRACE_MAGIC "VMTRACE1"
+
+typedef enum trace_op {
+    TRACE_START = 0,
+    TRACE_STOP,
+    TRACE_READ,
+    TRACE_WRITE
+} trace_op_t;
+
+typedef struct trace_record {
+    trace_op_t op;
+    uint32_t pid;
+    vaddr_t address;            /* For accesses only */
+    uint8_t data;
+} trace_record_t;
+
+typedef struct trace {
+    FILE *text;                 /* A text trace, or NULL */
+    const uint8_t *data;        /* A mapped binary trace, or NULL */
+    size_t size;
+    size_t pos;
+    vaddr_t *last;              /* Each process's last address, for deltas */
+} trace_t;
+
+/**
+ * Opens the trace at path, mapping it if it is binary.
+ *
+ * @return nonzero, with errno set, if it cannot be opened
+ */
+int trace_open(trace_t *trace, const char *path);
+
+/**
+ * Reads a text trace from an open stream, such as stdin.
+ */
+void trace_open_stream(trace_t *trace, FILE *stream);
+
+/**
+ * Reads the next command into record.  A malformed trace ends the
+ * simulation with a message saying what was wrong.
+ *
+ * @return 1 if there was a command, or 0 at the end of the trace
+ */
+int trace_next(trace_t *trace, trace_record_t *record);
+
+void trace_close(trace_t *trace);
+
+/**
+ * Writes the rest of trace to path in the binary form.
+ *
+ * @return the number of records written, or -1 if path could not be
+ * written
+ */
+long trace_convert(trace_t *trace, const char *path);
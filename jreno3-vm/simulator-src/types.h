@@ -2,14 +2,15 @@
 
 #include <inttypes.h> /* For uintXX_t types */
 
-/* Virtual addresses are stored in a 32-bit integer. */
-typedef uint32_t vaddr_t;
+/* Virtual addresses are stored in a 64-bit integer, of which the low
+   vaddr_len bits are used. */
+typedef uint64_t vaddr_t;
 
 /* Physical addresses are stored in a 32-bit integer. */
 typedef uint32_t paddr_t;
 
-/* Virtual page numbers can be up to 16 bits. For pedantic reasons. */
-typedef uint16_t vpn_t;
+/* Virtual page numbers can be up to MAX_VADDR_LEN - OFFSET_LEN bits. */
+typedef uint64_t vpn_t;
 
 /* Physical frame numbers can be up to 16 bits. For pedantic reasons. */
 typedef uint16_t pfn_t;
@@ -28,9 +28,14 @@ void page_fault(vaddr_t address) {
 	stats.page_faults++;
     /* First, split the faulting address and locate the page table entry */
 	vpn_t vpn = vaddr_vpn(address);
-    pte_t* pageTableEntry = (pte_t*)(mem + (current_process->saved_ptbr * PAGE_SIZE)) + vpn;
+    /* Any tables missing on the way to the entry are allocated first, so the
+       data page's frame below cannot be handed out to one of them. This
+       must be the table mem_access() walks, the one in the PTBR. */
+    pte_t* pageTableEntry = pt_walk(PTBR, vpn, 1);
     /* It's a page fault, so the entry obviously won't be valid. Grab
-       a frame to use by calling free_frame(). */
+       a frame to use by calling free_frame(). Marking the entry valid first
+       keeps the eviction this may cause from reclaiming its table. */
+    pageTableEntry->valid = 1;
 	pfn_t frame = free_frame();
     /* Update the page table entry. Make sure you set any relevant bits. */
     pageTableEntry->pfn = frame;
@@ -3,6 +3,7 @@
 #include "paging.h"
 #include "swapops.h"
 #include "stats.h"
+#include "tlb.h"
 #include "util.h"
 
 pfn_t select_victim_frame(void);
@@ -37,7 +38,10 @@ pfn_t free_frame(void) {
     if (frame_table[victim_pfn].mapped) {
     	vpn_t vpn = frame_table[victim_pfn].vpn;
     	pcb_t* pcb = frame_table[victim_pfn].process;
-    	pte_t* pte = ((pte_t*)(mem + pcb->saved_ptbr * PAGE_SIZE)) + vpn;
+    	pte_t* pte = pt_walk(pcb->saved_ptbr, vpn, 0);
+    	if (!pte) {
+    		panic("Mapped frame's page table is not resident");
+    	}
     	if (pte->dirty) {
     		void* paddr = (void*)(mem + ((victim_pfn) * PAGE_SIZE));
     		swap_write(pte, paddr);
@@ -46,6 +50,11 @@ pfn_t free_frame(void) {
     	}
     	pte->valid = 0;
     	frame_table[victim_pfn].mapped = 0;
+    	/* The TLB may still hold the old mapping */
+    	if (tlb_enabled) {
+    		tlb_invalidate((uint16_t) pcb->pid, vpn);
+    	}
+    	pt_reclaim(pcb, vpn);
     }
     frame_table[victim_pfn].referenced = 0; // inside or outside?
     /* If the victim is in use, we must evict it first */
@@ -110,7 +119,9 @@ pfn_t select_victim_frame() {
     	// clock++;
     	// return clock - 1;
 
-        while (1) {
+        /* Two turns clear every referenced bit, so a third finds nothing
+           but protected frames */
+        for (size_t turns = 0; turns < 2 * NUM_FRAMES + 1; turns++) {
             clock = clock % NUM_FRAMES;
             if (!frame_table[clock].protected) {
                 if (frame_table[clock].referenced) {
@@ -20,4 +20,10 @@
 static inline vpn_t vaddr_vpn(vaddr_t addr) {return addr/PAGE_SIZE;}
 
 /* Get the offset into the page from a virtual address. */
-static inline uint16_t vaddr_offset(vaddr_t addr) {return addr%PAGE_SIZE;}
+static inline uint16_t vaddr_offset(vaddr_t addr) {return (uint16_t) (addr%PAGE_SIZE);}
+
+/* Get the index into a page table at the given level (0 is the root) from a
+   virtual page number. */
+static inline uint32_t vpn_index(vpn_t vpn, uint8_t level) {
+    return (uint32_t) ((vpn >> pt_shift[level]) & ((1u << pt_bits[level]) - 1));
+}
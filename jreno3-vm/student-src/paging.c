@@ -2,6 +2,7 @@
 #include "page_splitting.h"
 #include "swapops.h"
 #include "stats.h"
+#include "tlb.h"
 
  /* The frame table pointer. You will set this up in system_init. */
 fte_t *frame_table;
@@ -51,6 +52,84 @@ void system_init(void) {
 	frame_table->protected = 1; 
 }
 
+/*
+    Allocates a zeroed frame for one level of a page table, protected from
+    eviction while it maps anything resident (see pt_reclaim()).
+*/
+static pfn_t pt_alloc(void) {
+    pfn_t frame = free_frame();
+    memset(mem + frame * PAGE_SIZE, 0, PAGE_SIZE);
+    frame_table[frame].protected = 1;
+    if (++stats.pt_pages > stats.pt_pages_max) {
+        stats.pt_pages_max = stats.pt_pages;
+    }
+    return frame;
+}
+
+/*
+    Walks the page table whose root is in frame root down to the last-level
+    entry for vpn. A table missing on the way is allocated, or read back from
+    swap, if alloc is set; otherwise the walk stops there and returns NULL.
+*/
+pte_t *pt_walk(pfn_t root, vpn_t vpn, int alloc) {
+    pte_t *table = (pte_t*)(mem + root * PAGE_SIZE);
+    for (uint8_t level = 0; level + 1 < pt_levels; level++) {
+        pte_t *entry = table + vpn_index(vpn, level);
+        if (!entry->valid) {
+            if (!alloc) {
+                return NULL;
+            }
+            /* Valid before it has a frame, so that an eviction while we get
+               one does not reclaim the table we are in */
+            entry->valid = 1;
+            entry->pfn = pt_alloc();
+            if (entry->swap) {
+                swap_read(entry, mem + entry->pfn * PAGE_SIZE);
+                swap_free(entry);
+                stats.pt_swapins++;
+            }
+        }
+        table = (pte_t*)(mem + entry->pfn * PAGE_SIZE);
+    }
+    return table + vpn_index(vpn, (uint8_t) (pt_levels - 1));
+}
+
+/*
+    Called after proc's page vpn is evicted. Every table on the way to it that
+    no longer maps anything resident is given up, from the last level toward
+    the root: to swap if it still holds swap entries, otherwise dropped, as if
+    it had never been allocated. The root stays, since the PTBR points to it.
+*/
+void pt_reclaim(pcb_t *proc, vpn_t vpn) {
+    pte_t *path[MAX_PT_LEVELS];
+    pte_t *table = (pte_t*)(mem + proc->saved_ptbr * PAGE_SIZE);
+    uint8_t level;
+
+    for (level = 0; level + 1 < pt_levels; level++) {
+        path[level] = table + vpn_index(vpn, level);
+        table = (pte_t*)(mem + path[level]->pfn * PAGE_SIZE);
+    }
+    while (level-- > 0) {
+        pte_t *parent = path[level];
+        int swapped = 0;
+        table = (pte_t*)(mem + parent->pfn * PAGE_SIZE);
+        for (size_t i = 0; i < ((size_t) 1 << pt_bits[level + 1]); i++) {
+            if (table[i].valid) {
+                return;
+            }
+            swapped |= table[i].swap != 0;
+        }
+        if (swapped) {
+            swap_write(parent, table);
+            stats.writebacks++;
+        }
+        parent->valid = 0;
+        frame_table[parent->pfn].protected = 0;
+        frame_table[parent->pfn].referenced = 0;
+        stats.pt_pages--;
+    }
+}
+
 /*  --------------------------------- PROBLEM 3 --------------------------------------
     This function gets called every time a new process is created.
     You will need to allocate a new page table for the process in memory using the
@@ -69,18 +148,17 @@ void proc_init(pcb_t *proc) {
     /*
      * 1. Call the free frame allocator (free_frame) to return a free frame for
      * this process's page table. You should zero-out the memory.
-     */
-	pfn_t freeFrame = free_frame();
-	memset(mem + freeFrame * PAGE_SIZE, 0, PAGE_SIZE);
-    /*
+     *
      * 2. Update the process's PCB with the frame number
      * of the newly allocated page table.
      *
      * Additionally, mark the frame's frame table entry as protected. You do not
      * want your page table to be accidentally evicted.
+     *
+     * Only the root table is allocated here; pt_walk() adds the lower levels
+     * as pages under them are mapped.
      */
-	proc->saved_ptbr = freeFrame;
-	frame_table[freeFrame].protected = 1;
+	proc->saved_ptbr = pt_alloc();
 }
 
 /*  --------------------------------- PROBLEM 4 --------------------------------------
@@ -96,6 +174,9 @@ void proc_init(pcb_t *proc) {
  */
 void context_switch(pcb_t *proc) {
 	PTBR = proc->saved_ptbr;
+	/* TLB entries are tagged with the process they belong to, so they can
+	   stay cached across the switch */
+	ASID = (uint16_t) proc->pid;
 }
 
 /*  --------------------------------- PROBLEM 5 --------------------------------------
@@ -127,17 +208,52 @@ void context_switch(pcb_t *proc) {
         - Make sure to update the stats variables correctly (see stats.h)
     -----------------------------------------------------------------------------------
  */
+/* Walks the page table for vpn, faulting the page in if need be. With -t,
+   each walk reads one entry per level from memory. */
+static pte_t *translate(vaddr_t address, vpn_t vpn) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        pte_t* pageTableEntry = pt_walk(PTBR, vpn, 0);
+        if (tlb_enabled) {
+            stats.page_walks++;
+            stats.walk_reads += pt_levels;
+        }
+        if (pageTableEntry && pageTableEntry->valid) {
+            return pageTableEntry;
+        }
+        /* If an entry is invalid, or a table on the way to it is missing,
+           just page fault to map the page, in the same table we walk. The
+           access is then retried, walking again. */
+        if (attempt == 0) {
+            page_fault(address);
+        }
+    }
+    panic("Page fault did not map the faulting page in the page table the PTBR points to");
+    return NULL;
+}
+
 uint8_t mem_access(vaddr_t address, char rw, uint8_t data) {
-    /* Split the address and find the page table entry */
+    /* Split the address and find the translation, in the TLB if it is
+       cached there, and otherwise in the page table */
 	vpn_t vpn = vaddr_vpn(address);
 	uint16_t offset = vaddr_offset(address);
-    pte_t* pageTableEntry = (pte_t*)(mem + PTBR*PAGE_SIZE) + vpn;
-    /* If an entry is invalid, just page fault to allocate a page for the page table. */
-	if (!(pageTableEntry->valid)) {
-		page_fault(address);
-	}
+    pfn_t pfn;
+    tlb_entry_t* cached = tlb_enabled ? tlb_lookup(ASID, vpn) : NULL;
+    /* The first write through a clean TLB entry walks to set the dirty bit
+       in the page table entry */
+    if (cached && (rw == 'r' || cached->dirty)) {
+        pfn = cached->pfn;
+    } else {
+        pte_t* pageTableEntry = translate(address, vpn);
+        if (rw != 'r') {
+            pageTableEntry->dirty = 1;
+        }
+        pfn = pageTableEntry->pfn;
+        if (tlb_enabled) {
+            tlb_insert(ASID, vpn, pfn, pageTableEntry->dirty);
+        }
+    }
     /* Set the "referenced" bit to reduce the page's likelihood of eviction */
-	frame_table[pageTableEntry->pfn].referenced = 1;
+	frame_table[pfn].referenced = 1;
     /*
         The physical address will be constructed like this:
         -------------------------------------
@@ -149,7 +265,6 @@ uint8_t mem_access(vaddr_t address, char rw, uint8_t data) {
         Create the physical address using your offset and the page
         table entry.
     */
-    pfn_t pfn = pageTableEntry->pfn;
     paddr_t paddress = (paddr_t) pfn * PAGE_SIZE + offset;
     stats.accesses++;
     /* Either read or write the data to the physical address
@@ -159,7 +274,6 @@ uint8_t mem_access(vaddr_t address, char rw, uint8_t data) {
     	return mem[paddress];
     } else {
     	stats.writes++;
-    	pageTableEntry->dirty = 1;
     	mem[paddress] = data;
     	return mem[paddress];
     }
@@ -177,12 +291,30 @@ uint8_t mem_access(vaddr_t address, char rw, uint8_t data) {
     You must also clear the "protected" bits for the page table itself.
     -----------------------------------------------------------------------------------
 */
-void proc_cleanup(pcb_t *proc) {
-    /* Look up the process's page table */
-    pte_t* pageTable = (pte_t*)(mem + ((proc->saved_ptbr) * PAGE_SIZE));
-    /* Iterate the page table and clean up each valid page */
-    for (size_t i = 0; i < NUM_PAGES; i++) {
+static void pt_free(pte_t *pageTable, uint8_t level) {
+    /* Iterate the table, freeing the tables below it or, in the last level,
+       cleaning up each valid page */
+    for (size_t i = 0; i < ((size_t) 1 << pt_bits[level]); i++) {
     	pte_t* temp = pageTable + i;
+    	if (level + 1 < pt_levels) {
+    		if (temp->valid) {
+    			pt_free((pte_t*)(mem + temp->pfn * PAGE_SIZE), (uint8_t) (level + 1));
+    			frame_table[temp->pfn].protected = 0;
+    			frame_table[temp->pfn].referenced = 0;
+    			stats.pt_pages--;
+    		} else if (temp->swap) {
+    			/* A table in swap may still own swap entries itself */
+    			pte_t *swapped = malloc(PAGE_SIZE);
+    			if (!swapped) {
+    				panic("could not allocate page table buffer");
+    			}
+    			swap_read(temp, swapped);
+    			pt_free(swapped, (uint8_t) (level + 1));
+    			free(swapped);
+    			swap_free(temp);
+    		}
+    		continue;
+    	}
     	if (temp->valid) {
             fte_t* fte = frame_table + pageTable[i].pfn;
             fte->mapped = 0;
@@ -191,7 +323,17 @@ void proc_cleanup(pcb_t *proc) {
     		swap_free(temp);
     	}
     }
+}
+
+void proc_cleanup(pcb_t *proc) {
+    /* The process's ASID may be handed out again, so forget its TLB entries */
+    if (tlb_enabled) {
+        tlb_flush_asid((uint16_t) proc->pid);
+    }
+    /* Free the process's page table from the root down */
+    pt_free((pte_t*)(mem + proc->saved_ptbr * PAGE_SIZE), 0);
     frame_table[proc->saved_ptbr].protected = 0;
     frame_table[proc->saved_ptbr].mapped = 0;
     frame_table[proc->saved_ptbr].referenced = 0;
+    stats.pt_pages--;
 }
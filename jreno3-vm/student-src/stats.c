@@ -19,6 +19,6 @@ stats_t stats;
 void compute_stats() {
 	// stats.aat = (MEMORY_READ_TIME * stats.reads + DISK_PAGE_READ_TIME * stats.page_faults 
 	// 	+ DISK_PAGE_WRITE_TIME * stats.writebacks)/(stats.accesses);
-	stats.aat = ((double)(MEMORY_READ_TIME * stats.accesses + DISK_PAGE_READ_TIME * stats.page_faults 
+	stats.aat = ((double)(MEMORY_READ_TIME * (stats.accesses + stats.walk_reads) + DISK_PAGE_READ_TIME * (stats.page_faults + stats.pt_swapins)
 		+ DISK_PAGE_WRITE_TIME * stats.writebacks))/((double)(stats.accesses));
 }